@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/jobs.h"
+#include "../include/rng.h"
+
+/*
+
+Training without blocking the caller.
+
+Three jobs share an executor: two train on their own datasets and report
+through a completion callback, one is a runaway (tiny step, no tolerance)
+that the caller cancels after watching its loss. The main thread only
+polls, the way a service's request loop would.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_s(double s) {
+    struct timespec ts = { (time_t)s, (long)((s - (time_t)s) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static Dataset* make_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double z = 0.3;
+        for (int j = 1; j < d; j++) {
+            x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+            z += (j % 3 - 1) * 1.5 * x[j];
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+static void on_done(TrainJob* job, const JobProgress* p, void* user) {
+    (void)job;
+    printf("  [callback] %-8s %-9s after %4d iterations, loss %.5f, %.2f s\n",
+           (const char*)user, job_status_name(p->status), p->iter, p->loss, p->elapsed_s);
+}
+
+static void print_progress(const char* name, TrainJob* job) {
+    JobProgress p = job_poll(job);
+    printf("  %-8s %-9s iter %5d | loss %.5f (iter %d) | change %.1e\n",
+           name, job_status_name(p.status), p.iter, p.loss, p.loss_iter, p.change);
+}
+
+int main() {
+    int d = 17;
+    gd_set_verbose(0);
+    Dataset* a = make_dataset(40000, d, 1);
+    Dataset* b = make_dataset(40000, d, 2);
+
+    JobExecutor* ex = executor_create(2);
+
+    JobConfig adam = job_default_config(OPT_ADAM);
+    adam.opt.lr = 0.05;
+    adam.max_iters = 400;
+    adam.on_done = on_done;
+    adam.user = "adam";
+
+    JobConfig momentum = job_default_config(OPT_MOMENTUM);
+    momentum.opt.lr = 0.5;
+    momentum.max_iters = 400;
+    momentum.on_done = on_done;
+    momentum.user = "momentum";
+
+    JobConfig runaway = job_default_config(OPT_GD);
+    runaway.opt.lr = 1e-4;
+    runaway.max_iters = 1000000;
+    runaway.tol = 0.0;
+    runaway.on_done = on_done;
+    runaway.user = "runaway";
+
+    double* w_adam = calloc(d, sizeof(double));
+    double* w_mom = calloc(d, sizeof(double));
+    double* w_run = calloc(d, sizeof(double));
+    double t0 = now_s();
+    TrainJob* jobs[3];
+    jobs[0] = job_submit_dataset(ex, a, LOSS_LOGISTIC, w_adam, &adam);
+    jobs[1] = job_submit_dataset(ex, b, LOSS_LOGISTIC, w_mom, &momentum);
+    jobs[2] = job_submit_dataset(ex, a, LOSS_LOGISTIC, w_run, &runaway);
+    printf("3 jobs submitted to an executor with 2 threads\n\n");
+    const char* names[3] = { "adam", "momentum", "runaway" };
+
+    // The caller stays free: poll a few times, then stop the job that is going nowhere
+    for (int tick = 0; tick < 3; tick++) {
+        sleep_s(0.4);
+        printf("t = %.1f s\n", now_s() - t0);
+        for (int k = 0; k < 3; k++) print_progress(names[k], jobs[k]);
+    }
+    printf("t = %.1f s: wait 10 ms for the runaway: %s\n", now_s() - t0,
+           job_wait(jobs[2], 0.01) ? "stopped" : "timed out, cancelling");
+
+    double iter_s = job_poll(jobs[2]).elapsed_s / (job_poll(jobs[2]).iter + 1);
+    double t_cancel = now_s();
+    job_cancel(jobs[2]);
+    job_wait(jobs[2], -1.0);
+    printf("cancel honoured in %.1f ms (one iteration takes %.1f ms)\n", (now_s() - t_cancel) * 1e3, iter_s * 1e3);
+
+    for (int k = 0; k < 2; k++) job_wait(jobs[k], -1.0);
+    printf("\nall jobs stopped after %.2f s\n", now_s() - t0);
+
+    // Same iterations through the blocking call: identical weights
+    set_dataset(a);
+    double* w_ref = calloc(d, sizeof(double));
+    gradient_descent_adam(logistic_loss, logistic_grad, w_ref, d, 0.05, 0.9, 0.999, 1e-8, job_poll(jobs[0]).iter, 0.0);
+    double diff = 0.0;
+    for (int j = 0; j < d; j++) diff = fmax(diff, fabs(w_ref[j] - w_adam[j]));
+    printf("adam job vs gradient_descent_adam, same iterations: max |w diff| %.1e\n", diff);
+
+    for (int k = 0; k < 3; k++) job_release(jobs[k]);
+    executor_destroy(ex);
+    free(w_adam);
+    free(w_mom);
+    free(w_run);
+    free(w_ref);
+    free_dataset(a);
+    free_dataset(b);
+    return 0;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/cd.h"
+#include "../include/rng.h"
+
+/*
+
+Coordinate descent for the Lasso, elastic net and L1-logistic regression
+on column-major data, with and without gap-safe screening, followed by
+scoring through the compressed sparse model format.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Bias plus d - 1 features; only the first `informative` carry signal
+static Dataset* make_dataset(int n, int d, int informative, int logistic, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        data->X[i][0] = 1.0;
+        double z = 0.5;
+        for (int j = 1; j < d; j++) {
+            data->X[i][j] = 2.0 * rng_uniform(&rng) - 1.0;
+            if (j <= informative) z += (j % 2 ? 1.5 : -1.0) * data->X[i][j];
+        }
+        if (logistic) data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+        else data->y[i] = z + 0.5 * (rng_uniform(&rng) - 0.5);
+    }
+    return data;
+}
+
+static double* fit(const char* name, const ColumnDataset* cols, CDConfig* cfg) {
+    double* w = calloc(cols->d, sizeof(double));
+    CDResult res;
+    double t0 = now_s();
+    int rc = cd_fit(cols, w, cfg, &res);
+    double elapsed = now_s() - t0;
+    printf("  %-24s | %4d epochs | %8lld updates | screened %4d | nonzero %3d | obj %.8f | gap %.1e | %.3f s%s\n",
+           name, res.epochs, res.coord_updates, res.screened, res.nonzeros, res.objective, res.gap,
+           elapsed, rc == 0 ? "" : " (not converged)");
+    return w;
+}
+
+static void run(const char* title, Dataset* data, LossType loss, double alpha, double ratio, FuncPtrND reg_loss) {
+    ColumnDataset* cols = dense_to_columns(data);
+    double lmax = cd_lambda_max(cols, loss, alpha);
+    CDConfig cfg = cd_default_config(loss, ratio * lmax);
+    cfg.alpha = alpha;
+    printf("%s: n = %d, d = %d, lambda = %.4g (%.2f x lambda_max)\n", title, data->n, data->d, cfg.lambda, ratio);
+
+    cfg.screening = 0;
+    double* w_plain = fit("active set", cols, &cfg);
+    cfg.screening = 1;
+    double* w = fit("active set + gap-safe", cols, &cfg);
+
+    // Same objective as the reg_* family in model.c
+    set_dataset(data);
+    set_penalty(alpha * cfg.lambda, (1 - alpha) * cfg.lambda);
+    double diff = 0.0;
+    for (int j = 0; j < data->d; j++) diff = fmax(diff, fabs(w[j] - w_plain[j]));
+    printf("  reg objective %.8f | max |w_screened - w_plain| = %.1e\n\n", reg_loss(w, data->d), diff);
+
+    free(w_plain);
+    free(w);
+    free_column_dataset(cols);
+}
+
+// Reserves a fresh file under /tmp for the saved model; main() removes it when done
+static int temp_path(char* path, size_t len, const char* stem) {
+    snprintf(path, len, "/tmp/%s_XXXXXX", stem);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+int main() {
+    Dataset* lin = make_dataset(2000, 1001, 20, 0, 1);
+    run("Lasso", lin, LOSS_MSE, 1.0, 0.1, reg_mse_loss);
+    run("Elastic net (alpha = 0.5)", lin, LOSS_MSE, 0.5, 0.1, reg_mse_loss);
+
+    Dataset* logit = make_dataset(2000, 1001, 20, 1, 2);
+    run("L1 logistic", logit, LOSS_LOGISTIC, 1.0, 0.1, reg_logistic_loss);
+
+    // Sparse model: scoring touches only the selected features
+    ColumnDataset* cols = dense_to_columns(logit);
+    CDConfig cfg = cd_default_config(LOSS_LOGISTIC, 0.1 * cd_lambda_max(cols, LOSS_LOGISTIC, 1.0));
+    Model* model = create_model(MODEL_LOGISTIC, 1, logit->d);
+    cd_fit(cols, model->W, &cfg, NULL);
+    free_column_dataset(cols);
+
+    SparseModel* sm = sparse_model_from(model);
+    char path[64];
+    if (temp_path(path, sizeof(path), "sparse_logistic_model") != 0) return 1;
+    save_sparse_model(path, sm);
+    SparseModel* loaded = load_sparse_model(path);
+    remove(path);
+    if (!loaded) return 1;
+
+    // A cache-resident micro-batch, as the inference server scores them
+    int n = 64, d = logit->d;
+    double* X = malloc((size_t)n * d * sizeof(double));
+    for (int i = 0; i < n; i++) memcpy(X + (size_t)i * d, logit->X[i], d * sizeof(double));
+    double* dense_scores = malloc(n * sizeof(double));
+    double* sparse_scores = malloc(n * sizeof(double));
+
+    int reps = 5000;
+    double t0 = now_s();
+    for (int r = 0; r < reps; r++) predict_batch(model, X, n, dense_scores, NULL);
+    double t_dense = now_s() - t0;
+    t0 = now_s();
+    for (int r = 0; r < reps; r++) predict_sparse_batch(loaded, X, n, sparse_scores, NULL);
+    double t_sparse = now_s() - t0;
+
+    double diff = 0.0;
+    for (int i = 0; i < n; i++) diff = fmax(diff, fabs(dense_scores[i] - sparse_scores[i]));
+    printf("Sparse model: %d of %d weights stored, saved and reloaded\n", loaded->nnz, d);
+    printf("  dense predict_batch  %.2f us / %d rows\n", t_dense * 1e6 / reps, n);
+    printf("  predict_sparse_batch %.2f us / %d rows | max score difference %.1e\n", t_sparse * 1e6 / reps, n, diff);
+
+    free(X);
+    free(dense_scores);
+    free(sparse_scores);
+    free_sparse_model(sm);
+    free_sparse_model(loaded);
+    free_model(model);
+    free_dataset(lin);
+    free_dataset(logit);
+    return 0;
+}
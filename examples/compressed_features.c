@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/colstore.h"
+#include "../include/gd.h"
+#include "../include/rng.h"
+
+/*
+
+Training on compressed features.
+
+A row of the Dataset costs 8 bytes per feature plus a row pointer. Most
+real columns need far less: categorical codes, timings at a fixed resolution
+and sensor readings with a known precision. The column store keeps each column in
+its smallest sufficient encoding (dictionary, 8-bit grid, half precision
+or raw doubles) and the loss and gradient kernels decode inside their
+inner loops, so only the codes are ever read from memory.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// bias | 8 categorical (4-12 levels) | 8 durations of 0-8 h at 1/256 h | 16 readings in [-1, 1]
+static Dataset* make_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double z = -0.5;
+        for (int j = 1; j < d; j++) {
+            if (j <= 8) {
+                x[j] = floor(rng_uniform(&rng) * (4 + j)) * 0.25;
+                z += (j % 2 ? 0.3 : -0.2) * x[j];
+            } else if (j <= 16) {
+                x[j] = floor(rng_uniform(&rng) * 2049) / 256.0;
+                z += (j % 3 - 1) * 0.15 * x[j];
+            } else {
+                x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+                z += (j % 4 - 1.5) * x[j];
+            }
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+static double accuracy(const Dataset* data, const double* w) {
+    int correct = 0;
+    for (int i = 0; i < data->n; i++) {
+        double z = 0.0;
+        for (int j = 0; j < data->d; j++) z += w[j] * data->X[i][j];
+        correct += (z > 0.0) == (data->y[i] > 0.5);
+    }
+    return (double)correct / data->n;
+}
+
+int main() {
+    int n = 500000, d = 33, iters = 100;
+    double tol = 1e-2;   // the readings carry about two decimals of precision
+    gd_set_verbose(0);
+    Dataset* data = make_dataset(n, d, 7);
+    set_dataset(data);
+
+    ColumnStore* cs = colstore_encode(data, NULL, tol);
+    if (!cs) return 1;
+
+    // Encoding summary, consecutive columns with the same encoding on one line
+    printf("n = %d, d = %d, tolerance %.0e\n", n, d, tol);
+    for (int j = 0; j < d;) {
+        int k = j;
+        double err = 0.0;
+        while (k < d && cs->cols[k].enc == cs->cols[j].enc) err = fmax(err, cs->cols[k++].max_error);
+        printf("  columns %2d-%-2d %-4s  max error %.1e\n", j, k - 1, col_encoding_name(cs->cols[j].enc), err);
+        j = k;
+    }
+
+    double raw = (double)n * (d * sizeof(double) + sizeof(double*) + sizeof(double));
+    double packed = (double)colstore_bytes(cs);
+    printf("\nbytes per row: %.1f raw -> %.1f compressed (%.1fx)\n", raw / n, packed / n, raw / packed);
+    printf("rows per GB:   %.1fM raw -> %.1fM compressed\n\n", 1e9 / (raw / n) / 1e6, 1e9 / (packed / n) / 1e6);
+
+    // One gradient, both ways
+    set_column_store(cs, LOSS_LOGISTIC);
+    double* w = malloc(d * sizeof(double));
+    double* g_raw = malloc(d * sizeof(double));
+    double* g_cs = malloc(d * sizeof(double));
+    for (int j = 0; j < d; j++) w[j] = 0.01 * (j % 7 - 3);
+    double best_raw = 1e9, best_cs = 1e9;
+    for (int round = 0; round < 5; round++) {
+        double t0 = now_s();
+        logistic_grad(w, g_raw, d);
+        best_raw = fmin(best_raw, now_s() - t0);
+        t0 = now_s();
+        compressed_grad(w, g_cs, d);
+        best_cs = fmin(best_cs, now_s() - t0);
+    }
+    double diff = 0.0, scale = 0.0;
+    for (int j = 0; j < d; j++) {
+        diff = fmax(diff, fabs(g_raw[j] - g_cs[j]));
+        scale = fmax(scale, fabs(g_raw[j]));
+    }
+    printf("logistic gradient: doubles %.1f ms | compressed %.1f ms (%.2fx), max difference %.1e (|g| up to %.1e)\n",
+           best_raw * 1e3, best_cs * 1e3, best_raw / best_cs, diff, scale);
+
+    // Adam on both objectives
+    double* w_raw = calloc(d, sizeof(double));
+    double* w_cs = calloc(d, sizeof(double));
+    double t0 = now_s();
+    gradient_descent_adam(logistic_loss, logistic_grad, w_raw, d, 0.05, 0.9, 0.999, 1e-8, iters, 0.0);
+    double t_raw = now_s() - t0;
+    t0 = now_s();
+    gradient_descent_adam(compressed_loss, compressed_grad, w_cs, d, 0.05, 0.9, 0.999, 1e-8, iters, 0.0);
+    double t_cs = now_s() - t0;
+
+    printf("\n%d Adam steps      time     loss      accuracy\n", iters);
+    printf("doubles         %6.2f s  %.5f  %.4f\n", t_raw, logistic_loss(w_raw, d), accuracy(data, w_raw));
+    printf("compressed      %6.2f s  %.5f  %.4f\n", t_cs, logistic_loss(w_cs, d), accuracy(data, w_cs));
+
+    free(w);
+    free(g_raw);
+    free(g_cs);
+    free(w_raw);
+    free(w_cs);
+    colstore_free(cs);
+    free_dataset(data);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/stats.h"
+#include "../include/pool.h"
+#include "../include/rng.h"
+
+/*
+
+Single-pass feature statistics and a persisted normalization transform.
+
+Column statistics are accumulated row by row (Welford) in fixed chunks on
+the thread pool and merged in order, so every pool size gives the same
+bits. The transform built from them is applied in place, fused into the
+loss kernels instead of normalizing a copy, folded into raw-space weights,
+and saved next to the model so that serving rows are scaled exactly as
+the training rows were.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Features on very different scales and offsets
+static Dataset* make_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        data->X[i][0] = 1.0;
+        double z = 0.0;
+        for (int j = 1; j < d; j++) {
+            double scale = pow(10.0, j % 5 - 2);
+            double u = 2.0 * rng_uniform(&rng) - 1.0;
+            data->X[i][j] = 100.0 * j + scale * u;
+            z += (j % 3 - 1) * u;
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-2.0 * z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+// The previous normalize_features: three column-wise passes through the row pointers
+static void normalize_columnwise(Dataset* data) {
+    for (int j = 1; j < data->d; j++) {
+        double mean = 0, std = 0;
+        for (int i = 0; i < data->n; i++) mean += data->X[i][j];
+        mean /= data->n;
+        for (int i = 0; i < data->n; i++) std += pow(data->X[i][j] - mean, 2);
+        std = sqrt(std / data->n);
+
+        for (int i = 0; i < data->n; i++)
+            data->X[i][j] = (data->X[i][j] - mean) / (std + 1e-8);
+    }
+}
+
+static double max_diff(const Dataset* a, const Dataset* b) {
+    double diff = 0.0;
+    for (int i = 0; i < a->n; i++)
+        for (int j = 0; j < a->d; j++) diff = fmax(diff, fabs(a->X[i][j] - b->X[i][j]));
+    return diff;
+}
+
+static double* train(Dataset* data, const FeatureTransform* fused) {
+    double* w = calloc(data->d, sizeof(double));
+    set_dataset(data);
+    set_feature_transform(fused);
+    gradient_descent_adam(logistic_loss, logistic_grad, w, data->d, 0.05, 0.9, 0.999, 1e-8, 300, 1e-12);
+    set_feature_transform(NULL);
+    return w;
+}
+
+// Reserves a fresh file under /tmp for the saved model; main() removes it when done
+static int temp_path(char* path, size_t len, const char* stem) {
+    snprintf(path, len, "/tmp/%s_XXXXXX", stem);
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        perror("mkstemp");
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+int main() {
+    int n = 200000, d = 33;
+    gd_set_verbose(0);
+
+    // Normalization: old column-wise passes against the row-major statistics engine
+    Dataset* a = make_dataset(n, d, 1);
+    Dataset* b = make_dataset(n, d, 1);
+    double t0 = now_s();
+    normalize_columnwise(a);
+    double t_old = now_s() - t0;
+    t0 = now_s();
+    normalize_features(b);
+    double t_new = now_s() - t0;
+    printf("normalize %d x %d: column-wise %.3f s | single pass %.3f s | max difference %.1e\n",
+           n, d, t_old, t_new, max_diff(a, b));
+    free_dataset(a);
+    free_dataset(b);
+
+    // Parallel statistics: fixed chunks merged in order give identical results for any pool size
+    Dataset* raw = make_dataset(n, d, 1);
+    ColumnStats* ref = stats_compute(raw, NULL);
+    int threads[] = { 1, 2, 4 };
+    for (int t = 0; t < 3; t++) {
+        ThreadPool* pool = pool_create(threads[t]);
+        t0 = now_s();
+        ColumnStats* s = stats_compute(raw, pool);
+        double elapsed = now_s() - t0;
+        int same = memcmp(s->mean, ref->mean, d * sizeof(double)) == 0 &&
+                   memcmp(s->m2, ref->m2, d * sizeof(double)) == 0;
+        printf("stats_compute, %d thread%s: %.3f s | %s serial pass\n", threads[t], threads[t] > 1 ? "s" : " ",
+               elapsed, same ? "bitwise equal to the" : "DIFFERS from the");
+        stats_free(s);
+        pool_destroy(pool);
+    }
+    printf("  column 4: mean %.4f  std %.4f  min %.4f  max %.4f\n\n",
+           ref->mean[4], stats_std(ref, 4), ref->min[4], ref->max[4]);
+
+    // Training: normalized copy against the transform fused into the loss kernels
+    FeatureTransform* tf = transform_from_stats(ref, TRANSFORM_STANDARDIZE);
+    Dataset* normalized = make_dataset(n, d, 1);
+    transform_apply(tf, normalized);
+
+    t0 = now_s();
+    double* w_copy = train(normalized, NULL);
+    double t_copy = now_s() - t0;
+    t0 = now_s();
+    double* w_fused = train(raw, tf);
+    double t_fused = now_s() - t0;
+
+    double wdiff = 0.0;
+    for (int j = 0; j < d; j++) wdiff = fmax(wdiff, fabs(w_copy[j] - w_fused[j]));
+    set_dataset(normalized);
+    double loss = logistic_loss(w_copy, d);
+    printf("Adam, 300 iterations: normalized copy %.3f s | fused transform %.3f s\n", t_copy, t_fused);
+    printf("  loss %.6f | max |w_copy - w_fused| = %.1e\n", loss, wdiff);
+
+    // Serving: save the transform next to the model, or fold it into raw-space weights
+    Model* model = create_model(MODEL_LOGISTIC, 1, d);
+    memcpy(model->W, w_fused, d * sizeof(double));
+    char model_path[64], norm_path[64];
+    if (temp_path(model_path, sizeof(model_path), "stats_logistic_model") != 0) return 1;
+    if (temp_path(norm_path, sizeof(norm_path), "stats_logistic_norm") != 0) return 1;
+    save_model(model_path, model);
+    save_transform(norm_path, tf);
+
+    Model* folded = create_model(MODEL_LOGISTIC, 1, d);
+    transform_fold_weights(tf, w_fused, folded->W, 1);
+
+    Model* loaded = load_model(model_path);
+    FeatureTransform* loaded_tf = load_transform(norm_path);
+    remove(model_path);
+    remove(norm_path);
+    if (!loaded || !loaded_tf) return 1;
+
+    int m = 1000;
+    Dataset* test = make_dataset(m, d, 2);
+    double* X_raw = malloc((size_t)m * d * sizeof(double));
+    double* X_norm = malloc((size_t)m * d * sizeof(double));
+    for (int i = 0; i < m; i++) {
+        memcpy(X_raw + (size_t)i * d, test->X[i], d * sizeof(double));
+        memcpy(X_norm + (size_t)i * d, test->X[i], d * sizeof(double));
+        transform_apply_row(loaded_tf, X_norm + (size_t)i * d);
+    }
+    double* p_loaded = malloc(m * sizeof(double));
+    double* p_folded = malloc(m * sizeof(double));
+    predict_batch(loaded, X_norm, m, p_loaded, NULL);
+    predict_batch(folded, X_raw, m, p_folded, NULL);
+
+    double pdiff = 0.0;
+    int correct = 0;
+    for (int i = 0; i < m; i++) {
+        pdiff = fmax(pdiff, fabs(p_loaded[i] - p_folded[i]));
+        correct += (p_folded[i] >= 0.5) == (test->y[i] == 1.0);
+    }
+    printf("\nServing %d held-out rows: accuracy %.3f\n", m, (double)correct / m);
+    printf("  saved model + saved transform vs folded raw-space model: max probability difference %.1e\n", pdiff);
+
+    free(X_raw);
+    free(X_norm);
+    free(p_loaded);
+    free(p_folded);
+    free(w_copy);
+    free(w_fused);
+    free_model(model);
+    free_model(folded);
+    free_model(loaded);
+    transform_free(tf);
+    transform_free(loaded_tf);
+    stats_free(ref);
+    free_dataset(raw);
+    free_dataset(normalized);
+    free_dataset(test);
+    return 0;
+}
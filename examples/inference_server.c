@@ -0,0 +1,73 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include "../include/model.h"
+#include "../include/server.h"
+
+/*
+
+Local inference daemon with request micro-batching.
+
+  ./run_inference_server [-s socket_path] [-b max_batch] [-w max_wait_us] [-i stats_interval_s] model.bin [model2.bin ...]
+
+Without -s requests are read from stdin and responses written to stdout.
+Each request is a ServerRequestHeader {request_id, model_id, n_features}
+followed by n_features doubles; each response is a 16-byte ServerResponse.
+Model files are written by save_model() (see regression_logistic.c).
+
+*/
+
+static InferenceServer* g_server = NULL;
+
+static void on_signal(int sig) {
+    (void)sig;
+    if (g_server) server_stop(g_server);
+}
+
+int main(int argc, char** argv) {
+    ServerConfig cfg = server_default_config();
+    Model* models[64];
+    int num_models = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-s") && i + 1 < argc) cfg.socket_path = argv[++i];
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) cfg.max_batch = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-w") && i + 1 < argc) cfg.max_wait_us = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-i") && i + 1 < argc) cfg.stats_interval_s = atoi(argv[++i]);
+        else if (num_models < 64) {
+            models[num_models] = load_model(argv[i]);
+            if (!models[num_models]) return 1;
+            num_models++;
+        }
+    }
+
+    if (num_models == 0) {
+        fprintf(stderr, "usage: %s [-s socket] [-b max_batch] [-w max_wait_us] [-i stats_s] model.bin...\n", argv[0]);
+        return 1;
+    }
+
+    for (int m = 0; m < num_models; m++)
+        fprintf(stderr, "Model %d: type %d | k = %d | d = %d\n", m, models[m]->type, models[m]->k, models[m]->d);
+
+    g_server = server_create(models, num_models, &cfg);
+    if (!g_server) return 1;
+
+#ifndef _WIN32
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;  // no SA_RESTART so accept() returns
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+#else
+    signal(SIGINT, on_signal);
+#endif
+
+    int rc = server_run(g_server);
+    server_print_stats(g_server, stderr);
+
+    server_destroy(g_server);
+    for (int m = 0; m < num_models; m++) free_model(models[m]);
+    return rc == 0 ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/jobs.h"
+#include "../include/hotswap.h"
+#include "../include/rng.h"
+
+/*
+
+Serving a model while it is still training.
+
+A training job publishes its weights into a ModelHandle every few
+iterations; reader threads score batches from whatever snapshot is newest.
+Readers never lock: they compare their latency with the model idle, with
+training running, and with a reader-writer lock in place of the handle.
+A second run publishes weight vectors filled with their own version number
+as fast as it can, and readers check that no snapshot mixes two versions.
+
+*/
+
+#define BATCH 64
+#define MAX_CALLS 2000000
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void sleep_s(double s) {
+    struct timespec ts = { (time_t)s, (long)((s - (time_t)s) * 1e9) };
+    nanosleep(&ts, NULL);
+}
+
+static Dataset* make_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double z = -0.2;
+        for (int j = 1; j < d; j++) {
+            x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+            z += (j % 4 - 1.5) * x[j];
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+// The baseline: one shared model, copied in under the write lock
+typedef struct {
+    pthread_rwlock_t lock;
+    Model* model;
+} LockedModel;
+
+static void locked_publish(const double* w, int dim, int iter, void* ctx) {
+    (void)iter;
+    LockedModel* lm = ctx;
+    pthread_rwlock_wrlock(&lm->lock);
+    memcpy(lm->model->W, w, dim * sizeof(double));
+    pthread_rwlock_unlock(&lm->lock);
+}
+
+typedef struct {
+    ModelHandle* h;         // hot-swap readers
+    LockedModel* locked;    // or rwlock readers
+    const double* X;        // n contiguous rows of d features
+    int n, d;
+    int* stop;
+    int check_versions;     // torn-snapshot run: every weight must equal the version
+
+    double* latency;        // per call, seconds
+    int calls;
+    int versions_seen;      // version changes observed
+    long long torn;
+} Reader;
+
+static void* reader_main(void* arg) {
+    Reader* r = arg;
+    int slot = r->h ? hot_reader_register(r->h) : -1;
+    if (r->h && slot < 0) return NULL;
+    double scores[BATCH];
+    int labels[BATCH];
+    long long last = 0;
+    int row = 0;
+    while (!__atomic_load_n(r->stop, __ATOMIC_RELAXED) && r->calls < MAX_CALLS) {
+        const double* x = r->X + (size_t)row * r->d;
+        long long version = 0;
+        double t0 = now_s();
+        if (r->check_versions) {
+            const Model* m = hot_acquire(r->h, slot, &version);
+            for (int j = 0; j < m->k * m->d; j++) {
+                if (m->W[j] != (double)version) {
+                    r->torn++;
+                    break;
+                }
+            }
+            hot_release(r->h, slot);
+        } else if (r->h) {
+            version = hot_predict_batch(r->h, slot, x, BATCH, scores, labels);
+        } else {
+            pthread_rwlock_rdlock(&r->locked->lock);
+            predict_batch(r->locked->model, x, BATCH, scores, labels);
+            pthread_rwlock_unlock(&r->locked->lock);
+        }
+        r->latency[r->calls++] = now_s() - t0;
+        if (version != last) {
+            r->versions_seen++;
+            last = version;
+        }
+        row += BATCH;
+        if (row + BATCH > r->n) row = 0;
+    }
+    hot_reader_unregister(r->h, slot);
+    return NULL;
+}
+
+static int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+#define NUM_READERS 2
+
+typedef struct {
+    Reader r[NUM_READERS];
+    pthread_t threads[NUM_READERS];
+    int stop;
+} ReaderGroup;
+
+static void readers_start(ReaderGroup* g, ModelHandle* h, LockedModel* locked, const double* X, int n, int d, int check) {
+    g->stop = 0;
+    for (int t = 0; t < NUM_READERS; t++) {
+        Reader* r = &g->r[t];
+        memset(r, 0, sizeof(Reader));
+        r->h = h;
+        r->locked = locked;
+        r->X = X;
+        r->n = n;
+        r->d = d;
+        r->stop = &g->stop;
+        r->check_versions = check;
+        r->latency = malloc(MAX_CALLS * sizeof(double));
+        pthread_create(&g->threads[t], NULL, reader_main, r);
+    }
+}
+
+// Stops the readers and prints their latency quantiles over all calls
+static void readers_stop(ReaderGroup* g, const char* name) {
+    __atomic_store_n(&g->stop, 1, __ATOMIC_RELAXED);
+    int total = 0, versions = 0;
+    for (int t = 0; t < NUM_READERS; t++) {
+        pthread_join(g->threads[t], NULL);
+        total += g->r[t].calls;
+        versions += g->r[t].versions_seen;
+    }
+    double* all = malloc(total * sizeof(double));
+    int at = 0;
+    for (int t = 0; t < NUM_READERS; t++) {
+        memcpy(all + at, g->r[t].latency, g->r[t].calls * sizeof(double));
+        at += g->r[t].calls;
+        free(g->r[t].latency);
+    }
+    qsort(all, total, sizeof(double), compare_double);
+    printf("  %-22s %8d calls | p50 %6.2f us | p99 %7.2f us | p99.9 %8.2f us", name, total,
+           all[total / 2] * 1e6, all[(int)(total * 0.99)] * 1e6, all[(int)(total * 0.999)] * 1e6);
+    if (g->r[0].h) printf(" | versions seen %d", versions / NUM_READERS);
+    printf("\n");
+    free(all);
+}
+
+int main() {
+    int d = 33, n_train = 40000, n_test = 4096;
+    gd_set_verbose(0);
+    Dataset* train = make_dataset(n_train, d, 1);
+    Dataset* test = make_dataset(n_test, d, 2);
+    double* X = malloc((size_t)n_test * d * sizeof(double));
+    for (int i = 0; i < n_test; i++) memcpy(X + (size_t)i * d, test->X[i], d * sizeof(double));
+
+    JobExecutor* ex = executor_create(1);
+    JobConfig cfg = job_default_config(OPT_ADAM);
+    cfg.opt.lr = 0.05;
+    cfg.max_iters = 300;
+    cfg.tol = 0.0;
+    cfg.loss_every = 0;
+    cfg.publish_every = 5;
+    double* w = calloc(d, sizeof(double));
+    ReaderGroup g;
+
+    printf("%d readers scoring %d-row batches, training publishes every %d iterations\n\n", NUM_READERS, BATCH, cfg.publish_every);
+
+    // Hot-swap handle: idle, then while a job trains into it
+    ModelHandle* h = hot_create(MODEL_LOGISTIC, 1, d, w);
+    readers_start(&g, h, NULL, X, n_test, d, 0);
+    sleep_s(0.5);
+    readers_stop(&g, "hot-swap, idle");
+
+    cfg.publish = hot_job_publish;
+    cfg.publish_ctx = h;
+    readers_start(&g, h, NULL, X, n_test, d, 0);
+    double t0 = now_s();
+    TrainJob* job = job_submit_dataset(ex, train, LOSS_LOGISTIC, w, &cfg);
+    job_wait(job, -1.0);
+    double train_s = now_s() - t0;
+    readers_stop(&g, "hot-swap, training");
+    job_release(job);
+
+    HotStats s = hot_stats(h);
+    int* labels = malloc(n_test * sizeof(int));
+    double* scores = malloc(n_test * sizeof(double));
+    int slot = hot_reader_register(h);
+    long long version = hot_predict_batch(h, slot, X, n_test, scores, labels);
+    hot_reader_unregister(h, slot);
+    if (version < 0) return 1;
+    int correct = 0;
+    for (int i = 0; i < n_test; i++) correct += labels[i] == (int)test->y[i];
+
+    // Same job with a reader-writer lock around one shared model
+    LockedModel locked;
+    pthread_rwlock_init(&locked.lock, NULL);
+    locked.model = create_model(MODEL_LOGISTIC, 1, d);
+    memset(w, 0, d * sizeof(double));
+    cfg.publish = locked_publish;
+    cfg.publish_ctx = &locked;
+    readers_start(&g, NULL, &locked, X, n_test, d, 0);
+    job = job_submit_dataset(ex, train, LOSS_LOGISTIC, w, &cfg);
+    job_wait(job, -1.0);
+    readers_stop(&g, "rwlock, training");
+    job_release(job);
+
+    printf("\ntraining %.2f s, %lld snapshots published, %lld freed, %d pending\n", train_s, s.published, s.reclaimed, s.pending);
+    printf("served version %lld: test accuracy %.2f%%\n\n", version, 100.0 * correct / n_test);
+
+    // Torn-snapshot check: a publisher flat out against readers verifying every weight
+    int big_d = 4096;
+    double* W = malloc(big_d * sizeof(double));
+    for (int j = 0; j < big_d; j++) W[j] = 1.0;
+    ModelHandle* big = hot_create(MODEL_LOGISTIC, 1, big_d, W);
+    readers_start(&g, big, NULL, NULL, 0, big_d, 1);
+    t0 = now_s();
+    while (now_s() - t0 < 0.5) {
+        double next = (double)(hot_version(big) + 1);
+        for (int j = 0; j < big_d; j++) W[j] = next;
+        hot_publish(big, W);
+    }
+    readers_stop(&g, "hot-swap, publish loop");
+    long long checks = 0, torn = 0;
+    for (int t = 0; t < NUM_READERS; t++) {
+        checks += g.r[t].calls;
+        torn += g.r[t].torn;
+    }
+    s = hot_stats(big);
+    printf("\n%d-weight snapshots: %lld published, %d pending while readers ran", big_d, s.published, s.pending);
+    printf(", %d once they left | %lld reads, %lld torn\n", hot_reclaim(big), checks, torn);
+
+    hot_destroy(big);
+    hot_destroy(h);
+    free_model(locked.model);
+    pthread_rwlock_destroy(&locked.lock);
+    executor_destroy(ex);
+    free(W);
+    free(w);
+    free(X);
+    free(labels);
+    free(scores);
+    free_dataset(train);
+    free_dataset(test);
+    return 0;
+}
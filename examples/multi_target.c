@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/multitarget.h"
+#include "../include/rng.h"
+
+/*
+
+Multi-target regression: hundreds of linear models over one feature matrix.
+
+The per-target way runs mse_grad once per column of Y, reading X every
+time. multi_mse_grad() forms all gradients in one blocked pass, and
+multi_ridge_solve() accumulates X^T X and X^T Y in one pass and reuses a
+single Cholesky factorization for every target.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Y = X B^T + noise for m random weight vectors B
+static Dataset* make_dataset(int n, int d, int m, double* B, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    for (int k = 0; k < m * d; k++) B[k] = 2.0 * rng_uniform(&rng) - 1.0;
+
+    Dataset* data = create_dataset(n, d);
+    double* Y = malloc((size_t)n * m * sizeof(double));
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        for (int j = 1; j < d; j++) x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+        for (int t = 0; t < m; t++) {
+            double z = 0.0;
+            for (int j = 0; j < d; j++) z += B[(size_t)t * d + j] * x[j];
+            Y[(size_t)i * m + t] = z + 0.1 * (rng_uniform(&rng) - 0.5);
+        }
+    }
+    dataset_set_targets(data, m, Y);
+    free(Y);
+    return data;
+}
+
+int main() {
+    int n = 20000, d = 65, m = 256;
+    gd_set_verbose(0);
+    double* B = malloc((size_t)m * d * sizeof(double));
+    Dataset* data = make_dataset(n, d, m, B, 1);
+    printf("n = %d rows, d = %d features, m = %d targets (X is %.1f MB)\n\n", n, d, m, (double)n * d * 8 / 1e6);
+
+    double* W = malloc((size_t)m * d * sizeof(double));
+    for (int k = 0; k < m * d; k++) W[k] = 0.01 * (k % 7);
+
+    // One gradient for every target, the per-target way
+    double* G_loop = malloc((size_t)m * d * sizeof(double));
+    set_dataset(data);
+    double t0 = now_s();
+    for (int t = 0; t < m; t++) {
+        for (int i = 0; i < n; i++) data->y[i] = data->Y[(size_t)i * m + t];
+        mse_grad(W + (size_t)t * d, G_loop + (size_t)t * d, d);
+    }
+    double t_loop = now_s() - t0;
+
+    double* G = malloc((size_t)m * d * sizeof(double));
+    t0 = now_s();
+    double loss = multi_mse_grad(data, W, G);
+    double t_multi = now_s() - t0;
+
+    double diff = 0.0;
+    for (int k = 0; k < m * d; k++) diff = fmax(diff, fabs(G[k] - G_loop[k]));
+    printf("gradient of all %d targets:\n", m);
+    printf("  %d x mse_grad   %.3f s\n", m, t_loop);
+    printf("  multi_mse_grad  %.3f s (%.1fx) | loss %.4f | max difference %.1e\n\n",
+           t_multi, t_loop / t_multi, loss, diff);
+
+    // Closed form: one pass over X, one factorization, m right-hand sides
+    t0 = now_s();
+    int rc = multi_ridge_solve(data, 1e-6, W);
+    double t_solve = now_s() - t0;
+    double werr = 0.0;
+    for (int k = 0; k < m * d; k++) werr = fmax(werr, fabs(W[k] - B[k]));
+    printf("multi_ridge_solve: %s in %.3f s | loss %.6f (noise floor %.6f) | max |W - B| %.1e\n",
+           rc == 0 ? "solved" : "failed", t_solve, multi_mse(data, W, NULL) / m, 0.01 / 12.0, werr);
+
+    // The same objective through a FuncPtrND optimizer, warm-started from zero
+    double* W_gd = calloc((size_t)m * d, sizeof(double));
+    t0 = now_s();
+    gradient_descent_adam(multi_target_loss, multi_target_grad, W_gd, m * d, 0.05, 0.9, 0.999, 1e-8, 25, 1e-12);
+    printf("Adam, 25 iterations on multi_target_loss: %.2f s | mean loss per target %.6f\n\n",
+           now_s() - t0, multi_target_loss(W_gd, m * d) / m);
+
+    // Scoring every target for a batch of rows
+    Model* model = create_model(MODEL_LINEAR, m, d);
+    memcpy(model->W, W, (size_t)m * d * sizeof(double));
+    int rows = 1000;
+    double* X = malloc((size_t)rows * d * sizeof(double));
+    for (int i = 0; i < rows; i++) memcpy(X + (size_t)i * d, data->X[i], d * sizeof(double));
+    double* out = malloc((size_t)rows * m * sizeof(double));
+    t0 = now_s();
+    predict_multi(model, X, rows, out);
+    double t_pred = now_s() - t0;
+    double perr = 0.0;
+    for (int i = 0; i < rows; i++)
+        for (int t = 0; t < m; t++) perr = fmax(perr, fabs(out[(size_t)i * m + t] - data->Y[(size_t)i * m + t]));
+    printf("predict_multi: %d rows x %d targets in %.2f ms | max |prediction - Y| %.3f\n", rows, m, t_pred * 1e3, perr);
+
+    free(X);
+    free(out);
+    free_model(model);
+    free(W_gd);
+    free(G);
+    free(G_loop);
+    free(W);
+    free(B);
+    free_dataset(data);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/multiclass.h"
+#include "../include/pool.h"
+#include "../include/rng.h"
+
+/*
+
+Multi-class training from arbitrary labels.
+
+The iris file is read with all three species: the label column goes
+through a dictionary instead of hardcoded names. One-vs-rest trains one
+binary logistic model per class, each a task on the thread pool reading
+the same Dataset, and predict_batch() picks the class with a batched
+argmax. A synthetic problem with 100 classes shows the scaling.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double* pack_rows(const Dataset* data) {
+    double* X = malloc((size_t)data->n * data->d * sizeof(double));
+    for (int i = 0; i < data->n; i++) memcpy(X + (size_t)i * data->d, data->X[i], data->d * sizeof(double));
+    return X;
+}
+
+static double accuracy(const Model* m, const Dataset* data, int* labels) {
+    double* X = pack_rows(data);
+    predict_batch(m, X, data->n, NULL, labels);
+    int correct = 0;
+    for (int i = 0; i < data->n; i++) correct += labels[i] == (int)data->y[i];
+    free(X);
+    return (double)correct / data->n;
+}
+
+// Gaussian blobs around random class centres
+static Dataset* make_blobs(int n, int d, int k, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, 1234);
+    double* centres = malloc((size_t)k * d * sizeof(double));
+    for (int i = 0; i < k * d; i++) centres[i] = 4.0 * rng_uniform(&rng) - 2.0;
+
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        int c = rng_int(&rng, k);
+        data->X[i][0] = 1.0;
+        for (int j = 1; j < d; j++) {
+            double u = rng_uniform(&rng) + rng_uniform(&rng) + rng_uniform(&rng) - 1.5;
+            data->X[i][j] = centres[(size_t)c * d + j] + 1.2 * u;
+        }
+        data->y[i] = c;
+    }
+    free(centres);
+    return data;
+}
+
+int main() {
+    // Iris, all three classes
+    LabelDict* labels = label_dict_create();
+    Dataset* iris = load_csv_dataset("data/iris.csv", 4, 0, labels);
+    if (!iris) return 1;
+    normalize_features(iris);
+    printf("iris: %d rows, %d classes:", iris->n, labels->num);
+    for (int c = 0; c < labels->num; c++) printf(" %s", label_dict_name(labels, c));
+    printf("\n");
+
+    OvrConfig cfg = ovr_default_config();
+    int iters[3];
+    Model* model = train_ovr(iris, labels->num, &cfg, iters);
+    int* pred = malloc(iris->n * sizeof(int));
+    printf("  one-vs-rest accuracy %.3f (Adam steps per class: %d %d %d)\n",
+           accuracy(model, iris, pred), iters[0], iters[1], iters[2]);
+
+    int confusion[3][3] = { { 0 } };
+    for (int i = 0; i < iris->n; i++) confusion[(int)iris->y[i]][pred[i]]++;
+    printf("  confusion (rows: true, cols: predicted)\n");
+    for (int a = 0; a < 3; a++)
+        printf("    %-10s %3d %3d %3d\n", label_dict_name(labels, a), confusion[a][0], confusion[a][1], confusion[a][2]);
+    free(pred);
+    free_model(model);
+
+    // Many classes: one pool task per class
+    int k = 100;
+    Dataset* train = make_blobs(10000, 17, k, 1);
+    Dataset* test = make_blobs(5000, 17, k, 2);
+    cfg.max_iter = 60;
+    cfg.tol = 0.0;
+    printf("\nblobs: %d classes, %d rows, d = %d\n", k, train->n, train->d);
+
+    int cpus = pool_num_cpus();
+    int counts[] = { 1, cpus > 1 ? cpus : 2 };
+    Model* first = NULL;
+    for (int t = 0; t < 2; t++) {
+        cfg.num_threads = counts[t];
+        double t0 = now_s();
+        Model* m = train_ovr(train, k, &cfg, NULL);
+        double elapsed = now_s() - t0;
+        int same = !first || memcmp(first->W, m->W, (size_t)k * train->d * sizeof(double)) == 0;
+        printf("  %2d thread%s: %.2f s%s\n", counts[t], counts[t] > 1 ? "s" : " ", elapsed,
+               first ? (same ? " | weights identical to 1 thread" : " | weights DIFFER") : "");
+        if (!first) first = m;
+        else free_model(m);
+    }
+    if (cpus == 1) printf("  (one CPU available; with more, classes spread over every core)\n");
+
+    // Batched argmax against scoring one row and one class at a time
+    int* labels_out = malloc(test->n * sizeof(int));
+    double t0 = now_s();
+    double acc = accuracy(first, test, labels_out);
+    double t_batched = now_s() - t0;
+
+    double* X = pack_rows(test);
+    int mismatches = 0;
+    t0 = now_s();
+    for (int i = 0; i < test->n; i++) {
+        const double* x = X + (size_t)i * test->d;
+        int best = 0;
+        double z_best = -INFINITY;
+        for (int c = 0; c < k; c++) {
+            double z = 0.0;
+            for (int j = 0; j < test->d; j++) z += first->W[(size_t)c * test->d + j] * x[j];
+            if (z > z_best) {
+                z_best = z;
+                best = c;
+            }
+        }
+        mismatches += best != labels_out[i];
+    }
+    double t_naive = now_s() - t0;
+    printf("  test accuracy %.3f | batched argmax %.1f ms, row at a time %.1f ms, %d disagreements\n",
+           acc, t_batched * 1e3, t_naive * 1e3, mismatches);
+
+    free(X);
+    free(labels_out);
+    free_model(first);
+    free_dataset(train);
+    free_dataset(test);
+    free_dataset(iris);
+    label_dict_free(labels);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/online.h"
+#include "../include/rng.h"
+
+/*
+
+Online learning from an unbounded row stream.
+
+  ./run_online_stream                        synthetic drifting stream
+  ./run_online_stream [options] -            CSV rows "f1,...,fm,label" from stdin
+      -t linear|logistic|softmax  -k classes  -r adagrad|ftrl
+      -n snapshot_every  -o snapshot.bin
+
+A file that is still being appended to can be followed with
+  tail -f events.csv | ./run_online_stream -o live_model.bin -
+and the snapshot served by run_inference_server.
+
+*/
+
+#define MAX_FEATURES 1024
+
+static void print_snapshot(const Model* m, const OnlineMetrics* s, void* ctx) {
+    (void)m;
+    (void)ctx;
+    printf("rows %9lld | loss %.4f (recent %.4f) | accuracy %.3f (recent %.3f) | nonzero weights %d\n",
+           s->rows, s->loss, s->recent_loss, s->accuracy, s->recent_accuracy, s->nonzeros);
+}
+
+// Parses one CSV line into x[1..m] (x[0] is the bias) and the trailing label.
+static int parse_row(char* line, double* x, double* y) {
+    int count = 0;
+    double vals[MAX_FEATURES + 1];
+    char* token = strtok(line, ",\r\n");
+    while (token && count <= MAX_FEATURES) {
+        vals[count++] = atof(token);
+        token = strtok(NULL, ",\r\n");
+    }
+    if (count < 2) return -1;
+
+    x[0] = 1.0;
+    for (int j = 0; j < count - 1; j++) x[j + 1] = vals[j];
+    *y = vals[count - 1];
+    return count;   // d = features + bias
+}
+
+static int run_stdin(OnlineConfig* cfg) {
+    char line[16384];
+    double x[MAX_FEATURES + 1], y;
+    OnlineLearner* ol = NULL;
+
+    while (fgets(line, sizeof(line), stdin)) {
+        int d = parse_row(line, x, &y);
+        if (d < 0) continue;
+        if (!ol) {
+            cfg->d = d;
+            ol = online_create(cfg);
+            if (!ol) return 1;
+        }
+        if (d != cfg->d) {
+            fprintf(stderr, "skipping row with %d features (expected %d)\n", d - 1, cfg->d - 1);
+            continue;
+        }
+        online_update(ol, x, y);
+    }
+
+    if (!ol) return 1;
+
+    // Publish whatever arrived after the last scheduled snapshot
+    OnlineMetrics m;
+    online_metrics(ol, &m);
+    if (m.rows % cfg->snapshot_every != 0) online_snapshot(ol);
+    online_destroy(ol);
+    return 0;
+}
+
+// Logistic events whose true weights flip sign halfway through the stream
+static int run_synthetic(OnlineConfig* cfg) {
+    int d = 21;
+    long long rows = 400000;
+    cfg->d = d;
+    cfg->type = MODEL_LOGISTIC;
+    cfg->k = 1;
+    cfg->rule = ONLINE_FTRL;
+    cfg->lr = 0.05;
+    cfg->l1 = 1.0;
+    if (cfg->snapshot_every == 0) cfg->snapshot_every = 50000;
+
+    OnlineLearner* ol = online_create(cfg);
+    if (!ol) return 1;
+
+    Rng rng;
+    rng_seed(&rng, 7);
+    double x[21];
+    printf("FTRL-Proximal, %d features (5 informative), drift at row %lld\n", d - 1, rows / 2);
+    for (long long i = 0; i < rows; i++) {
+        double sign = i < rows / 2 ? 1.0 : -1.0;
+        x[0] = 1.0;
+        double z = 0.0;
+        for (int j = 1; j < d; j++) {
+            x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+            if (j <= 5) z += sign * j * x[j];
+        }
+        double y = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+        online_update(ol, x, y);
+    }
+
+    online_destroy(ol);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    OnlineConfig cfg = online_default_config(MODEL_LOGISTIC, 1, 0);
+    cfg.on_snapshot = print_snapshot;
+    int from_stdin = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-")) from_stdin = 1;
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            i++;
+            cfg.type = !strcmp(argv[i], "linear") ? MODEL_LINEAR :
+                       !strcmp(argv[i], "softmax") ? MODEL_SOFTMAX : MODEL_LOGISTIC;
+        }
+        else if (!strcmp(argv[i], "-k") && i + 1 < argc) cfg.k = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-r") && i + 1 < argc) cfg.rule = !strcmp(argv[++i], "ftrl") ? ONLINE_FTRL : ONLINE_ADAGRAD;
+        else if (!strcmp(argv[i], "-n") && i + 1 < argc) cfg.snapshot_every = atoll(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && i + 1 < argc) cfg.snapshot_path = argv[++i];
+    }
+
+    if (from_stdin) {
+        if (cfg.snapshot_every == 0) cfg.snapshot_every = 10000;
+        return run_stdin(&cfg);
+    }
+    return run_synthetic(&cfg);
+}
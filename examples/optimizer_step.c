@@ -0,0 +1,67 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../include/gd.h"
+#include "../include/optim.h"
+#include "../include/model.h"
+#include "../include/dataset.h"
+
+/*
+
+Stateful optimizers driven one step at a time.
+
+The optimizer object owns its workspace, so the loop below performs no
+heap allocation per step; the caller decides when to step, can inspect
+m and v between steps and reuses the same object after optimizer_reset().
+
+*/
+
+int main() {
+    Dataset* data = create_sample_dataset();
+    set_dataset(data);
+    int dim = data->d;
+
+    OptimizerParams params = optimizer_default_params(OPT_ADAM);
+    params.lr = 0.1;
+    Optimizer* opt = optimizer_create(&params, logistic_grad, dim);
+
+    double* w = calloc(dim, sizeof(double));
+    int max_iters = 1000;
+    double tol = 1e-6;
+
+    printf("Training Logistic Regression with Adam, one step at a time...\n");
+    for (int it = 1; it <= max_iters; it++) {
+        double change = optimizer_step(opt, w);
+
+        // Other work can be interleaved here between steps
+        if (it % 200 == 0) {
+            printf("Step %4d | loss = %.6f | m[1] = %+.6f | v[1] = %.6f\n",
+                   opt->t, logistic_loss(w, dim), opt->m[1], opt->v[1]);
+        }
+        if (change < tol) {
+            printf("Converged in %d steps.\n", it);
+            break;
+        }
+    }
+
+    // Same configuration through the one-shot API, for comparison
+    double* w_ref = calloc(dim, sizeof(double));
+    gd_set_verbose(0);
+    gradient_descent_adam(logistic_loss, logistic_grad, w_ref, dim, params.lr, params.beta1, params.beta2, params.epsilon, max_iters, tol);
+
+    double diff = 0.0;
+    for (int j = 0; j < dim; j++) diff += fabs(w[j] - w_ref[j]);
+    printf("Weights: [%.6f, %.6f] | |w - w_adam| = %.3g\n", w[0], w[1], diff);
+
+    // Reuse the same object and workspace for a fresh run
+    optimizer_reset(opt);
+    for (int j = 0; j < dim; j++) w[j] = 0.0;
+    int steps = optimizer_run(opt, w, 100, tol);
+    printf("After reset: %d steps | loss = %.6f\n", steps, logistic_loss(w, dim));
+
+    optimizer_destroy(opt);
+    free(w);
+    free(w_ref);
+    free_dataset(data);
+    return 0;
+}
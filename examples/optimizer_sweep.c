@@ -0,0 +1,105 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/gd.h"
+#include "../include/model.h"
+#include "../include/dataset.h"
+#include "../include/sweep.h"
+#include "../include/pool.h"
+#include "../include/rng.h"
+
+/*
+
+Hyperparameter sweep with successive halving.
+
+500 random Adam, RMSProp and Momentum configurations train logistic
+regression on the same 4000-row dataset. Every rung runs the survivors in
+parallel on a work-stealing pool, keeps the best third and triples their
+budget. The sweep runs once on one thread and once on every CPU.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Dataset* make_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double z = 0.4;
+        for (int j = 1; j < d; j++) {
+            x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+            z += (j % 3 - 1) * 1.2 * x[j];
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+int main() {
+    gd_set_verbose(0);
+    Dataset* data = make_dataset(4000, 13, 1);
+    set_dataset(data);
+    int dim = data->d;
+    double* x0 = calloc(dim, sizeof(double));
+
+    SweepSpace space;
+    memset(&space, 0, sizeof(space));
+    space.lr = (SweepRange){ 1e-4, 1.0 };
+    space.momentum = (SweepRange){ 0.5, 0.99 };
+    space.beta1 = (SweepRange){ 0.8, 0.95 };
+    space.beta2 = (SweepRange){ 0.9, 0.9999 };
+    space.epsilon = (SweepRange){ 1e-10, 1e-4 };
+
+    OptimizerParams* adam = sweep_random(OPT_ADAM, &space, 200, 1);
+    OptimizerParams* rmsprop = sweep_random(OPT_RMSPROP, &space, 150, 2);
+    OptimizerParams* momentum = sweep_random(OPT_MOMENTUM, &space, 150, 3);
+
+    int n = 500;
+    OptimizerParams* configs = malloc(n * sizeof(OptimizerParams));
+    memcpy(configs, adam, 200 * sizeof(OptimizerParams));
+    memcpy(configs + 200, rmsprop, 150 * sizeof(OptimizerParams));
+    memcpy(configs + 350, momentum, 150 * sizeof(OptimizerParams));
+
+    SweepConfig cfg = sweep_default_config();
+    cfg.min_iters = 20;
+    cfg.max_iters = 2000;
+
+    printf("Sweeping %d configurations, logistic loss on %d x %d\n", n, data->n, dim);
+    cfg.num_threads = 1;
+    double t0 = now_s();
+    SweepResult* serial = sweep_run(logistic_loss, logistic_grad, x0, dim, configs, n, &cfg);
+    double t_serial = now_s() - t0;
+    printf("  1 thread:  %.2f s\n", t_serial);
+
+    cfg.num_threads = 0;
+    t0 = now_s();
+    SweepResult* results = sweep_run(logistic_loss, logistic_grad, x0, dim, configs, n, &cfg);
+    double t_pool = now_s() - t0;
+    printf("  %d CPU(s):  %.2f s (%.2fx), same ranking: %s\n\n", pool_num_cpus(), t_pool, t_serial / t_pool,
+           memcmp(&serial[0].params, &results[0].params, sizeof(OptimizerParams)) == 0 ? "yes" : "no");
+    sweep_free(serial, n);
+
+    sweep_print(results, n, 10, stdout);
+
+    printf("\nBest weights:");
+    for (int j = 0; j < dim; j++) printf(" %.6f", results[0].x[j]);
+    printf("\n");
+
+    sweep_free(results, n);
+    free(configs);
+    free(adam);
+    free(rmsprop);
+    free(momentum);
+    free(x0);
+    free_dataset(data);
+    return 0;
+}
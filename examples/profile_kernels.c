@@ -0,0 +1,81 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "../include/gd.h"
+#include "../include/model.h"
+#include "../include/dataset.h"
+#include "../include/prof.h"
+#include "../include/rng.h"
+
+/*
+
+Per-kernel profile of logistic and softmax training.
+
+Build with `make -B PROFILE=1 run_profile_kernels` to compile the regions in. Any other example can be
+profiled the same way by running it with COPTI_PROFILE=1, and
+COPTI_PROFILE_JSON=profile.json also writes the table as JSON.
+
+*/
+
+// The label is the index of the largest of features 1..k
+static Dataset* make_dataset(int n, int d, int k, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        data->X[i][0] = 1.0;
+        for (int j = 1; j < d; j++) data->X[i][j] = 2.0 * rng_uniform(&rng) - 1.0;
+        int best = 0;
+        for (int c = 1; c < k; c++)
+            if (data->X[i][1 + c] > data->X[i][1 + best]) best = c;
+        data->y[i] = best;
+    }
+    return data;
+}
+
+int main() {
+#ifndef COPTI_PROFILE
+    printf("Profiling is compiled out; rebuild with: make -B PROFILE=1 run_profile_kernels\n");
+#endif
+    int k = 3;
+    Dataset* data = make_dataset(20000, 32, k, 5);
+    set_dataset(data);
+    int d = data->d;
+
+    prof_enable(1);
+    gd_set_verbose(0);
+
+    Dataset* binary = make_dataset(20000, 32, 2, 5);
+    set_dataset(binary);
+    double* w = calloc(d, sizeof(double));
+    gradient_descent_adam(logistic_loss, logistic_grad, w, d, 0.05, 0.9, 0.999, 1e-8, 50, 1e-9);
+    printf("Logistic loss after 50 Adam steps: %.6f\n", logistic_loss(w, d));
+
+    set_dataset(data);
+    double** W = malloc(k * sizeof(double*));
+    double** G = malloc(k * sizeof(double*));
+    for (int c = 0; c < k; c++) {
+        W[c] = calloc(d, sizeof(double));
+        G[c] = calloc(d, sizeof(double));
+    }
+    for (int it = 0; it < 20; it++) {
+        softmax_grad(W, G, k, d);
+        for (int c = 0; c < k; c++)
+            for (int j = 0; j < d; j++) W[c][j] -= 0.5 * G[c][j];
+    }
+    printf("Softmax loss after 20 steps: %.6f\n\n", softmax_loss(W, k, d));
+
+    prof_report(stdout);
+
+    for (int c = 0; c < k; c++) {
+        free(W[c]);
+        free(G[c]);
+    }
+    free(W);
+    free(G);
+    free(w);
+    free_dataset(binary);
+    free_dataset(data);
+    return 0;
+}
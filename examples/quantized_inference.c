@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/stats.h"
+#include "../include/quant.h"
+#include "../include/rng.h"
+
+/*
+
+int8 inference for trained logistic and softmax models.
+
+quantize_model() folds the feature standardization into the weights, maps
+every raw feature onto a 7-bit grid over its calibration range and stores
+the weights as int8 with one scale per class. Scoring is then an integer
+dot product (VNNI or AVX2 pmaddubsw with make NATIVE=1, a plain loop
+otherwise) plus one multiply-add per class.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long)st.st_size : -1;
+}
+
+// Raw features on their own scales with a few outliers; k classes from the argmax of noisy linear margins
+static Dataset* make_dataset(int n, int d, int k, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double u[8];
+        for (int j = 1; j < d; j++) {
+            double g = rng_uniform(&rng) + rng_uniform(&rng) + rng_uniform(&rng) - 1.5;
+            if (rng_uniform(&rng) < 0.001) g *= 10.0;     // rare glitches stretch the min-max range
+            u[j % 8] = g;
+            x[j] = 10.0 * (j % 5) + (1 + j % 7) * g;    // offsets 0..40, spreads 1..7
+        }
+        int best = 0;
+        double z_best = -INFINITY;
+        for (int c = 0; c < k; c++) {
+            double z = 2.0 * u[c % 8] - u[(c + 3) % 8] - 0.5 * log(-log(rng_uniform(&rng) + 1e-12));
+            if (z > z_best) {
+                z_best = z;
+                best = c;
+            }
+        }
+        data->y[i] = best;
+    }
+    return data;
+}
+
+static Model* train_softmax(int k, int d, int iters) {
+    double** W = malloc(k * sizeof(double*));
+    double** G = malloc(k * sizeof(double*));
+    for (int c = 0; c < k; c++) {
+        W[c] = calloc(d, sizeof(double));
+        G[c] = malloc(d * sizeof(double));
+    }
+    for (int it = 0; it < iters; it++) {
+        softmax_grad(W, G, k, d);
+        for (int c = 0; c < k; c++)
+            for (int j = 0; j < d; j++) W[c][j] -= 1.0 * G[c][j];
+    }
+    Model* m = create_model(MODEL_SOFTMAX, k, d);
+    for (int c = 0; c < k; c++) {
+        memcpy(m->W + (size_t)c * d, W[c], d * sizeof(double));
+        free(W[c]);
+        free(G[c]);
+    }
+    free(W);
+    free(G);
+    return m;
+}
+
+// Rows per second of the float path (rows already standardized), int8 from raw doubles
+// and int8 from stored codes; best of 5
+static void benchmark(const Model* m, const QuantModel* qm, const double* X, const double* Xt, int n) {
+    double* scores = malloc(n * sizeof(double));
+    int* labels = malloc(n * sizeof(int));
+    uint8_t* codes = malloc((size_t)n * qm->d_pad);
+    quant_encode_rows(qm, X, n, codes);
+    double best[3] = { 1e9, 1e9, 1e9 };
+    for (int round = 0; round < 5; round++) {
+        double t0 = now_s();
+        predict_batch(m, Xt, n, scores, labels);
+        double t1 = now_s();
+        quant_predict_batch(qm, X, n, scores, labels);
+        double t2 = now_s();
+        quant_predict_codes(qm, codes, n, scores, labels);
+        double t3 = now_s();
+        best[0] = fmin(best[0], t1 - t0);
+        best[1] = fmin(best[1], t2 - t1);
+        best[2] = fmin(best[2], t3 - t2);
+    }
+    printf("  rows/s: float %.1fM | int8 from doubles %.1fM (%.1fx) | int8 from codes %.1fM (%.1fx)\n",
+           n / best[0] / 1e6, n / best[1] / 1e6, best[0] / best[1], n / best[2] / 1e6, best[0] / best[2]);
+    free(scores);
+    free(labels);
+    free(codes);
+}
+
+static void report(const char* name, const Model* m, const FeatureTransform* t, const ColumnStats* calib,
+                   const Dataset* test, const double* X, const double* Xt) {
+    printf("%s (k = %d, d = %d)\n", name, m->k, m->d);
+    const char* scale_names[] = { "per tensor", "per class " };
+    QuantModel* qm = NULL;
+    for (int s = 0; s < 2; s++) {
+        for (int clip = 0; clip < 2; clip++) {
+            free_quant_model(qm);
+            qm = quantize_model(m, t, calib, (QuantScale)s, clip ? 4.0 : 0.0);
+            if (!qm) exit(1);
+            QuantReport r = quant_report(qm, m, t, test);
+            printf("  %s, %s: ", scale_names[s], clip ? "+-4 sd " : "min-max");
+            quant_report_print(&r, stdout);
+        }
+    }
+
+    save_model("quant_float_model.bin", m);
+    save_transform("quant_float_model.norm", t);
+    save_quant_model("quant_int8_model.bin", qm);
+    long float_bytes = file_size("quant_float_model.bin") + file_size("quant_float_model.norm");
+    long int8_bytes = file_size("quant_int8_model.bin");
+    printf("  files: float model + norm %ld bytes | int8 %ld bytes (%.1fx smaller; weights alone %.0fx)\n",
+           float_bytes, int8_bytes, (double)float_bytes / int8_bytes,
+           (double)(m->k * m->d * sizeof(double)) / (m->k * qm->d_pad));
+
+    QuantModel* loaded = load_quant_model("quant_int8_model.bin");
+    QuantReport r = quant_report(loaded, m, t, test);
+    printf("  reloaded (per class, +-4 sd): same label %.2f%%\n", 100.0 * r.agreement);
+    benchmark(m, loaded, X, Xt, test->n);
+    free_quant_model(loaded);
+    free_quant_model(qm);
+    remove("quant_float_model.bin");
+    remove("quant_float_model.norm");
+    remove("quant_int8_model.bin");
+}
+
+int main() {
+    int d = 25, k = 5, n_train = 50000, n_test = 200000;
+    gd_set_verbose(0);
+    printf("int8 kernel: %s\n\n", quant_kernel_name());
+
+    Dataset* train = make_dataset(n_train, d, k, 1);
+    Dataset* test = make_dataset(n_test, d, k, 2);
+
+    // Calibrate on raw training rows, then train on standardized ones
+    ColumnStats* calib = stats_compute(train, NULL);
+    FeatureTransform* t = standardize_dataset(train, NULL);
+    set_dataset(train);
+    Model* softmax = train_softmax(k, d, 300);
+
+    // Binary model: class 0 against the rest
+    double* y_multi = train->y;
+    train->y = malloc(n_train * sizeof(double));
+    for (int i = 0; i < n_train; i++) train->y[i] = y_multi[i] == 0;
+    Model* logistic = create_model(MODEL_LOGISTIC, 1, d);
+    gradient_descent_adam(logistic_loss, logistic_grad, logistic->W, d, 0.05, 0.9, 0.999, 1e-8, 300, 0.0);
+    free(train->y);
+    train->y = y_multi;
+
+    // Contiguous raw and standardized copies of the test rows for the benchmarks
+    double* X = malloc((size_t)n_test * d * sizeof(double));
+    double* Xt = malloc((size_t)n_test * d * sizeof(double));
+    for (int i = 0; i < n_test; i++) {
+        memcpy(X + (size_t)i * d, test->X[i], d * sizeof(double));
+        memcpy(Xt + (size_t)i * d, test->X[i], d * sizeof(double));
+        transform_apply_row(t, Xt + (size_t)i * d);
+    }
+
+    report("softmax", softmax, t, calib, test, X, Xt);
+
+    for (int i = 0; i < n_test; i++) test->y[i] = test->y[i] == 0;
+    printf("\n");
+    report("logistic", logistic, t, calib, test, X, Xt);
+
+    free(X);
+    free(Xt);
+    free_model(softmax);
+    free_model(logistic);
+    transform_free(t);
+    stats_free(calib);
+    free_dataset(train);
+    free_dataset(test);
+    return 0;
+}
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include "../include/gd.h"
 #include "../include/model.h"
 #include "../include/dataset.h"
@@ -33,6 +34,13 @@ int main() {
         printf("  Sample %d: Pred = %.4f | Label = %.0f\n", i, pred, data->y[i]);
     }
 
+    // Save for serving with run_inference_server
+    Model* model = create_model(MODEL_LOGISTIC, 1, dim);
+    for (int j = 0; j < dim; j++) model->W[j] = weights[j];
+    if (save_model("logistic_model.bin", model) == 0)
+        printf("Saved model to logistic_model.bin\n");
+    free_model(model);
+
     free(weights);
     free_dataset(data);
     return 0;
@@ -0,0 +1,158 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/gd.h"
+#include "../include/pool.h"
+#include "../include/rng.h"
+
+/*
+
+Bit-identical models across thread counts.
+
+set_reduction() runs the loss and gradient sums over the rows in parallel.
+The fast mode splits rows into one slice per thread, so the order of the
+floating-point additions, and therefore the trained weights, changes with
+the thread count. The deterministic mode fixes the shape of the sum
+(1024-row chunks, 32-row blocks, pairwise trees) and lets the threads
+only choose which chunks they compute: every run gives the same bits.
+
+*/
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static Dataset* make_dataset(int n, int d, int k, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        double* x = data->X[i];
+        x[0] = 1.0;
+        double z = 0.0;
+        for (int j = 1; j < d; j++) {
+            x[j] = 2.0 * rng_uniform(&rng) - 1.0;
+            z += (j % 4 - 1.5) * x[j];
+        }
+        // Two classes from a logistic model, or k classes by binning the same margin
+        double p = 1.0 / (1.0 + exp(-z));
+        data->y[i] = k > 2 ? fmin(k - 1, floor(p * k)) : (rng_uniform(&rng) < p ? 1.0 : 0.0);
+    }
+    return data;
+}
+
+static double* train(int d, int iters, double* elapsed) {
+    double* w = calloc(d, sizeof(double));
+    double t0 = now_s();
+    gradient_descent_adam(logistic_loss, logistic_grad, w, d, 0.05, 0.9, 0.999, 1e-8, iters, 0.0);
+    *elapsed = now_s() - t0;
+    return w;
+}
+
+static double max_diff(const double* a, const double* b, int d) {
+    double diff = 0.0;
+    for (int j = 0; j < d; j++) diff = fmax(diff, fabs(a[j] - b[j]));
+    return diff;
+}
+
+// Best of several rounds of gradient evaluations, modes interleaved to share the noise
+static void compare_overhead(int d, int threads) {
+    double* w = malloc(d * sizeof(double));
+    double* g = malloc(d * sizeof(double));
+    for (int j = 0; j < d; j++) w[j] = 0.01 * j;
+    double best[2] = { 1e9, 1e9 };
+    ReduceMode modes[2] = { REDUCE_FAST, REDUCE_DETERMINISTIC };
+    for (int round = 0; round < 5; round++) {
+        for (int m = 0; m < 2; m++) {
+            set_reduction(modes[m], threads);
+            double t0 = now_s();
+            for (int it = 0; it < 10; it++) logistic_grad(w, g, d);
+            best[m] = fmin(best[m], now_s() - t0);
+        }
+    }
+    printf("logistic_grad, %d thread%s, best of 5 x 10 calls: fast %.1f ms | deterministic %.1f ms (%+.1f%%)\n",
+           threads, threads > 1 ? "s" : "", best[0] * 100, best[1] * 100, 100.0 * (best[1] / best[0] - 1.0));
+    free(w);
+    free(g);
+}
+
+int main() {
+    int n = 200000, d = 33, iters = 60;
+    gd_set_verbose(0);
+    Dataset* data = make_dataset(n, d, 2, 1);
+    set_dataset(data);
+    printf("logistic regression, n = %d, d = %d, %d Adam steps\n\n", n, d, iters);
+
+    double elapsed;
+    set_reduction(REDUCE_OFF, 0);
+    double* w_serial = train(d, iters, &elapsed);
+    printf("serial loops            %.2f s\n", elapsed);
+
+    int threads[] = { 1, 2, 3, 8 };
+    const char* names[] = { "fast", "deterministic" };
+    ReduceMode modes[] = { REDUCE_FAST, REDUCE_DETERMINISTIC };
+    for (int m = 0; m < 2; m++) {
+        double* first = NULL;
+        for (int t = 0; t < 4; t++) {
+            set_reduction(modes[m], threads[t]);
+            double* w = train(d, iters, &elapsed);
+            printf("%-13s %d thread%s %.2f s | ", names[m], threads[t], threads[t] > 1 ? "s" : " ", elapsed);
+            if (!first) {
+                printf("max |w - w_serial| %.1e\n", max_diff(w, w_serial, d));
+                first = w;
+                continue;
+            }
+            if (memcmp(w, first, d * sizeof(double)) == 0) printf("bitwise identical to 1 thread\n");
+            else printf("differs from 1 thread by up to %.1e\n", max_diff(w, first, d));
+            free(w);
+        }
+        free(first);
+    }
+
+    int cpus = pool_num_cpus();
+    printf("\n");
+    compare_overhead(d, cpus);
+    if (cpus == 1) printf("(one CPU available; with more, the chunks spread over every core)\n");
+
+    // Softmax gradients take the same path
+    int k = 4;
+    Dataset* multi = make_dataset(50000, d, k, 2);
+    set_dataset(multi);
+    double** W = malloc(k * sizeof(double*));
+    double** G = malloc(k * sizeof(double*));
+    double* ref = malloc((size_t)k * d * sizeof(double));
+    for (int c = 0; c < k; c++) {
+        W[c] = malloc(d * sizeof(double));
+        G[c] = malloc(d * sizeof(double));
+        for (int j = 0; j < d; j++) W[c][j] = 0.01 * ((c * d + j) % 11 - 5);
+    }
+    int same = 1;
+    for (int t = 0; t < 4; t++) {
+        set_reduction(REDUCE_DETERMINISTIC, threads[t]);
+        softmax_grad(W, G, k, d);
+        for (int c = 0; c < k; c++) {
+            if (t == 0) memcpy(ref + (size_t)c * d, G[c], d * sizeof(double));
+            else same &= memcmp(ref + (size_t)c * d, G[c], d * sizeof(double)) == 0;
+        }
+    }
+    printf("\nsoftmax_grad (k = %d), deterministic, 1/2/3/8 threads: %s\n", k, same ? "bitwise identical" : "DIFFERENT");
+
+    set_reduction(REDUCE_OFF, 0);
+    for (int c = 0; c < k; c++) {
+        free(W[c]);
+        free(G[c]);
+    }
+    free(W);
+    free(G);
+    free(ref);
+    free(w_serial);
+    free_dataset(multi);
+    free_dataset(data);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/dataset.h"
+#include "../include/model.h"
+#include "../include/train.h"
+#include "../include/checkpoint.h"
+#include "../include/rng.h"
+
+/*
+
+Checkpoint and resume of mini-batch training.
+
+A run that is "killed" after 130 steps resumes from its last checkpoint
+(step 100) and must finish with exactly the weights of an uninterrupted run.
+
+*/
+
+static Dataset* make_logistic_dataset(int n, int d, unsigned long long seed) {
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    Dataset* data = create_dataset(n, d);
+    for (int i = 0; i < n; i++) {
+        data->X[i][0] = 1.0;
+        double z = 0.5;
+        for (int j = 1; j < d; j++) {
+            data->X[i][j] = 2.0 * rng_uniform(&rng) - 1.0;
+            z += (j % 2 ? 2.0 : -1.5) * data->X[i][j];
+        }
+        data->y[i] = rng_uniform(&rng) < 1.0 / (1.0 + exp(-z)) ? 1.0 : 0.0;
+    }
+    return data;
+}
+
+int main() {
+    Dataset* data = make_logistic_dataset(2000, 6, 11);
+    set_dataset(data);
+    const char* path = "train_checkpoint.bin";
+
+    MiniBatchConfig cfg = minibatch_default_config(LOSS_LOGISTIC, OPT_ADAM);
+    cfg.opt.lr = 0.05;
+    cfg.batch_size = 64;
+    cfg.epochs = 8;
+
+    // Reference: one uninterrupted run
+    TrainState* full = train_state_create(data, &cfg);
+    long long total = train_minibatch(data, full, &cfg);
+    printf("Uninterrupted run: %lld steps | loss = %.6f\n", total, logistic_loss(full->w, data->d));
+
+    // Interrupted run, checkpointing every 50 steps in the background
+    MiniBatchConfig killed = cfg;
+    killed.checkpoint_path = path;
+    killed.checkpoint_every = 50;
+    killed.max_steps = 130;
+    TrainState* first = train_state_create(data, &killed);
+    train_minibatch(data, first, &killed);
+    printf("Interrupted at step %lld (epoch %d)\n", first->step, first->epoch);
+
+    // Resume from the last checkpoint in a fresh state
+    TrainState* resumed = train_state_create(data, &cfg);
+    if (checkpoint_load(path, resumed) != 0) return 1;
+    printf("Resumed from step %lld (epoch %d, position %d, Adam t = %d)\n",
+           resumed->step, resumed->epoch, resumed->pos, resumed->opt->t);
+    train_minibatch(data, resumed, &cfg);
+
+    int exact = memcmp(full->w, resumed->w, data->d * sizeof(double)) == 0;
+    printf("Resumed run: %lld steps | loss = %.6f | %s\n", resumed->step, logistic_loss(resumed->w, data->d),
+           exact ? "bit-exact match" : "MISMATCH");
+
+    remove(path);
+    train_state_free(full);
+    train_state_free(first);
+    train_state_free(resumed);
+    free_dataset(data);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+#ifndef ALIGNED_H
+#define ALIGNED_H
+
+#include <stdlib.h>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#define CACHE_LINE 64
+
+// Rounds a count of doubles up to whole cache lines
+static inline size_t aligned_doubles(size_t n) {
+    size_t per_line = CACHE_LINE / sizeof(double);
+    return (n + per_line - 1) / per_line * per_line;
+}
+
+// Cache-line aligned allocation; release with aligned_free()
+static inline void* aligned_malloc(size_t size) {
+    if (size == 0) size = CACHE_LINE;
+#ifdef _WIN32
+    return _aligned_malloc(size, CACHE_LINE);
+#else
+    void* p = NULL;
+    return posix_memalign(&p, CACHE_LINE, size) == 0 ? p : NULL;
+#endif
+}
+
+static inline void aligned_free(void* p) {
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+#endif
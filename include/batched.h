@@ -0,0 +1,68 @@
+#ifndef BATCHED_H
+#define BATCHED_H
+
+#include <stddef.h>
+#include "dataset.h"
+
+// Many small independent logistic models trained together (one per customer, segment, ...).
+// Models are packed BATCH_LANES to a group and every array is structure-of-arrays with the
+// lane innermost: element (row r, feature j) of all models in a group is one contiguous
+// vector of BATCH_LANES doubles, so the loss, gradient and Adam loops run across models
+// and vectorize without any gather. Each model stops on its own gradient. Training runs
+// in rounds of BATCH_ROUND_STEPS steps; between rounds the models still training are
+// repacked into fewer groups once a quarter of the groups could be freed, so lanes of
+// stopped models do not keep costing time.
+//
+// The lanes only pay off when the compiler can fill wide registers. In the default -O2
+// build (SSE2, two doubles) train_batch() is no faster than one gradient_descent_adam()
+// call per model; build with `make NATIVE=1` for AVX2 or AVX-512. examples/batched_models.c
+// times both.
+#define BATCH_LANES 8
+#define BATCH_ROUND_STEPS 25
+
+// Arena holding the training rows of every model. Models are grouped by row count so
+// that lanes of one group need little padding; padded rows carry weight 0.
+typedef struct {
+    int num_models;
+    int d;              // features per row, shared by every model (bias included)
+    int num_groups;
+    int* rows;          // rows of each model
+    int* slot;          // model -> group * BATCH_LANES + lane
+    int* model;         // slot -> model, -1 for an empty lane
+    int* group_rows;    // rows of the longest model in each group
+    size_t* group_off;  // first arena row of each group
+    double* X;          // X[((group_off[g] + r) * d + j) * BATCH_LANES + lane]
+    double* y;          // y[(group_off[g] + r) * BATCH_LANES + lane]
+    double* wt;         // 1/rows for real rows, 0 for padding
+} ModelBatch;
+
+// Empty arena for num_models models of rows[i] rows each; fill with batch_set_row()
+ModelBatch* batch_create(int num_models, int d, const int* rows);
+void batch_free(ModelBatch* b);
+void batch_set_row(ModelBatch* b, int model, int row, const double* x, double y);
+
+// Packs num Datasets of equal d (0/1 labels)
+ModelBatch* batch_from_datasets(Dataset* const* sets, int num);
+
+typedef struct {
+    int num_threads;    // groups are spread over a pool; <= 0 uses every online CPU
+    int max_iter;       // full-batch Adam steps per model
+    double lr;
+    double beta1;
+    double beta2;
+    double epsilon;
+    double l2;          // ridge penalty l2/2 * sum w_j², j >= 1
+    double tol;         // a model stops once every |gradient_j| < tol
+} BatchConfig;
+
+BatchConfig batch_default_config(void);
+
+// Trains every model from W (num_models x d, row-major, used as the starting point)
+// and writes the result back. iters_out (num_models entries, may be NULL) receives the
+// steps per model. Returns how many models met tol within max_iter.
+int train_batch(const ModelBatch* b, const BatchConfig* cfg, double* W, int* iters_out);
+
+// Mean logistic loss of each model at W (num_models entries)
+void batch_loss(const ModelBatch* b, const double* W, double* loss_out);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef CD_H
+#define CD_H
+
+#include "dataset.h"
+#include "model.h"
+
+// Cyclic coordinate descent for the l1 / elastic-net objectives of model.h:
+//   mean sample_loss(x_i·w, y_i) + l1 * sum|w_j| + l2/2 * sum w_j²   (j >= 1)
+// with l1 = alpha * lambda and l2 = (1 - alpha) * lambda as in include/path.h.
+// LOSS_MSE gives the Lasso / elastic net, LOSS_LOGISTIC sparse logistic regression.
+// Column 0 must be the bias (all ones); w[0] is not penalized.
+//
+// The residual (MSE) or margins (logistic) are updated in place after every
+// coordinate, so one update costs one pass over a column. Between full sweeps
+// only the nonzero coordinates are cycled, and gap-safe rules (Ndiaye et al. 2017)
+// drop coordinates that are provably zero at the optimum for the rest of the fit.
+typedef struct {
+    LossType loss;
+    double lambda;
+    double alpha;
+    double tol;         // stop when the duality gap falls below tol * objective
+    int max_epochs;     // sweeps over either the active set or all coordinates
+    int screening;      // gap-safe screening (MSE, and logistic with alpha = 1)
+} CDConfig;
+
+typedef struct {
+    int epochs;
+    long long coord_updates;
+    int screened;       // coordinates eliminated by the safe rule
+    int nonzeros;       // nonzero penalized weights
+    double objective;
+    double gap;         // duality gap, in objective units (-1 when not available)
+} CDResult;
+
+CDConfig cd_default_config(LossType loss, double lambda);
+
+// Smallest lambda at which every penalized weight is zero.
+double cd_lambda_max(const ColumnDataset* data, LossType loss, double alpha);
+
+// w (data->d entries) is the warm start and receives the solution; returns 0 when converged.
+int cd_fit(const ColumnDataset* data, double* w, const CDConfig* cfg, CDResult* out);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "train.h"
+
+// Full training state (weights, optimizer state and step counter, RNG, epoch position)
+// in a compact binary file. Files are written with write_file_atomic(), so a crash
+// mid-write leaves the previous checkpoint intact.
+
+// Writes a file through write_fn (0 on success) into a uniquely named temp file next to
+// path, flushes it to disk and renames it over path: readers see the old file or the whole
+// new one, even after a crash, and concurrent writers of one path do not collide. 0 on success.
+int write_file_atomic(const char* path, int (*write_fn)(FILE* f, const void* ctx), const void* ctx);
+
+int checkpoint_save(const char* path, const TrainState* st);   // 0 on success
+// st must match type, dim and n; a file with a bad row order, position or batch size is rejected
+int checkpoint_load(const char* path, TrainState* st);
+
+// Background writer: checkpointer_submit copies the state into memory and returns;
+// a writer thread does the file I/O. If a write is still in flight, the newer
+// snapshot replaces any snapshot still waiting.
+typedef struct Checkpointer Checkpointer;
+
+Checkpointer* checkpointer_create(const char* path);
+void checkpointer_submit(Checkpointer* c, const TrainState* st);
+int checkpointer_destroy(Checkpointer* c);   // flushes the pending snapshot; 0 if every write succeeded
+
+#endif
@@ -0,0 +1,72 @@
+#ifndef COLSTORE_H
+#define COLSTORE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dataset.h"
+#include "model.h"
+
+// Compressed column-major copy of a Dataset for the loss and gradient kernels.
+// Each column is stored in its own encoding:
+//   COL_F64   8 bytes/value, exact
+//   COL_F16   2 bytes, IEEE half precision (~3 significant digits, |x| <= 65504)
+//   COL_I8    1 byte, x = offset + scale * q with q in 0..255 (uniform grid over [min, max])
+//   COL_DICT  1 byte, index into a table of at most 256 distinct values, exact
+// The kernels never expand a column: rows are taken in tiles of COLSTORE_TILE_ROWS,
+// margins are accumulated column by column straight from the codes (w_j * scale and
+// w_j * offset folded per column, w_j * value per dictionary entry), and gradients
+// are formed from per-column sums of e * q or per-code sums of e. Only the codes
+// cross the memory bus: 1-2 bytes per value instead of 8.
+#define COLSTORE_TILE_ROWS 1024
+#define COLSTORE_DICT_MAX 256
+
+typedef enum {
+    COL_AUTO = 0,       // encode: pick the smallest exact or within-tolerance encoding
+    COL_F64,
+    COL_F16,
+    COL_I8,
+    COL_DICT
+} ColEncoding;
+
+typedef struct {
+    ColEncoding enc;
+    void* codes;        // n values: double, uint16_t (half) or uint8_t
+    double scale;       // COL_I8
+    double offset;
+    double* dict;       // COL_DICT values
+    int dict_size;
+    double max_error;   // largest |decoded - original| over the column
+} EncodedColumn;
+
+typedef struct {
+    int n;
+    int d;
+    EncodedColumn* cols;
+    double* y;
+} ColumnStore;
+
+// encodings (d entries) may be NULL or hold COL_AUTO for automatic columns. COL_AUTO
+// takes COL_DICT when a column has at most COLSTORE_DICT_MAX distinct values, else the
+// first of COL_I8, COL_F16 whose error stays within tol, else COL_F64. A forced encoding
+// is used as given (COL_DICT falls back to COL_F64 when there are too many values,
+// COL_F16 when a value is outside the half range).
+ColumnStore* colstore_encode(const Dataset* data, const ColEncoding* encodings, double tol);
+void colstore_free(ColumnStore* cs);
+
+size_t colstore_bytes(const ColumnStore* cs);   // codes, tables and labels
+const char* col_encoding_name(ColEncoding enc);
+
+// Decoded value and row, for checks and scoring
+double colstore_value(const ColumnStore* cs, int row, int col);
+void colstore_row(const ColumnStore* cs, int row, double* x_out);
+
+// Mean sample_loss over the rows; grad_out (d entries, may be NULL) receives its gradient.
+// Matches mse_loss/mse_grad and logistic_loss/logistic_grad on the decoded data.
+double colstore_loss_grad(const ColumnStore* cs, LossType loss, const double* w, double* grad_out);
+
+// FuncPtrND / GradPtrND objectives over a store, for the optimizers of gd.h and optim.h
+void set_column_store(const ColumnStore* cs, LossType loss);
+double compressed_loss(double* w, int dim);
+void compressed_grad(double* w, double* grad_out, int dim);
+
+#endif
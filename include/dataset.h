@@ -6,16 +6,67 @@ typedef struct {
     int d;      // number of features (+1 for bias if added)
     double** X; // features
     double* y;  // target (for classification: 0, 1, ..., k-1)
+    int m;      // number of columns in Y (0: single target y only)
+    double* Y;  // n x m targets, row-major; NULL when m == 0 (include/multitarget.h)
 } Dataset;
 
-Dataset* load_csv_dataset(const char* filename, int feature_count, int has_header, int classification);
+// Binary iris loader: feature columns, then the label (Setosa = 0, Versicolor = 1, other rows skipped)
+Dataset* load_csv(const char* filename, int features);
+
+// Label strings -> dense class ids 0..num-1, in order of first appearance
+typedef struct {
+    int num;
+    int cap;
+    char** names;
+    int* slots;         // open-addressing table of id + 1 (0 = empty)
+    int num_slots;      // power of two
+} LabelDict;
+
+LabelDict* label_dict_create(void);
+void label_dict_free(LabelDict* dict);
+int label_dict_id(LabelDict* dict, const char* name, int insert);   // -1 if absent and not inserted
+const char* label_dict_name(const LabelDict* dict, int id);
+
+// feature_count numeric columns followed by the label column; x[0] = 1.0 is the bias.
+// Columns after the label are ignored.
+// With labels != NULL every label string (quotes and spaces stripped) becomes a class id,
+// new ones are added to the dictionary; with NULL the label is read as a number.
+Dataset* load_csv_dataset(const char* filename, int feature_count, int has_header, LabelDict* labels);
+Dataset* create_dataset(int n, int d);    // n rows of d zeros, y zeroed, no targets matrix; NULL on failure
 void free_dataset(Dataset* data);
-void normalize_features(Dataset* data);
+int dataset_set_targets(Dataset* data, int m, const double* Y);   // copies n x m targets; 0 on success
+void normalize_features(Dataset* data);   // standardize_dataset() in include/stats.h keeps the transform
 void add_bias_column(Dataset* data);  // x[0] = 1.0 style
 
 Dataset* create_sample_dataset();
 void set_dataset(Dataset* data);
 void train_test_split(Dataset* full, Dataset** train, Dataset** test, double test_ratio);
 
+// Sparse rows in CSR form: row i holds idx/val[row_ptr[i] .. row_ptr[i + 1])
+typedef struct {
+    int n;
+    int d;
+    int* row_ptr;   // n + 1 offsets
+    int* idx;       // column indices
+    double* val;
+    double* y;
+} SparseDataset;
+
+SparseDataset* create_sparse_dataset(int n, int d, int nnz);
+SparseDataset* dense_to_sparse(const Dataset* data);  // drops exact zeros
+void free_sparse_dataset(SparseDataset* data);
+
+// Column-major dense data: feature j of every row is cols[j * n .. j * n + n)
+typedef struct {
+    int n;
+    int d;
+    double* cols;
+    double* y;
+} ColumnDataset;
+
+ColumnDataset* create_column_dataset(int n, int d);
+ColumnDataset* dense_to_columns(const Dataset* data);
+void free_column_dataset(ColumnDataset* data);
+
 
 #endif
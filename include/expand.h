@@ -0,0 +1,55 @@
+#ifndef EXPAND_H
+#define EXPAND_H
+
+#include "dataset.h"
+#include "model.h"
+
+// Virtual feature expansions: phi(x) is generated from the original rows inside the
+// loss and gradient kernels and never stored. Rows are processed in tiles of
+// EXPAND_TILE_ROWS, and expanded features in blocks of EXPAND_TILE_COLS, so each
+// generated tile stays cache-resident while it is multiplied into the margins
+// and again into the gradient. Memory is one tile plus the weights, whatever n is.
+//
+// Inputs follow the Dataset convention (x[0] = 1, features x[1..d-1]):
+//   poly2: phi = [x_0 .. x_{d-1}, x_i x_j for 1 <= i <= j < d], D = d + p(p+1)/2, p = d - 1
+//   rff:   phi = [1, sqrt(2/m) cos(omega_k . x + b_k) for k < m], D = 1 + m, omega ~ N(0, 2 gamma I),
+//          approximating the RBF kernel exp(-gamma ||x - x'||²) (Rahimi & Recht 2007)
+#define EXPAND_TILE_ROWS 16
+#define EXPAND_TILE_COLS 512
+
+typedef enum {
+    EXPAND_POLY2,
+    EXPAND_RFF
+} ExpandType;
+
+typedef struct {
+    ExpandType type;
+    int d;              // input dimension, including the bias
+    int D;              // expanded dimension, including the bias
+    long long* pair_start;  // poly2: index of pair (i, i) among the pairs, i = 1..p (p + 2 entries)
+    int m;              // rff: number of random features
+    double* omega;      // rff: m x (d - 1)
+    double* phase;      // rff: m offsets in [0, 2 pi)
+    double amp;         // rff: sqrt(2 / m)
+} FeatureExpansion;
+
+FeatureExpansion* expand_poly2(int d);      // NULL when D would not fit an int
+FeatureExpansion* expand_rff(int d, int num_features, double gamma, unsigned long long seed);
+void expand_free(FeatureExpansion* e);
+
+// phi(x) materialized for one row (D entries), for inspection and checks
+void expand_row(const FeatureExpansion* e, const double* x, double* phi_out);
+
+// Margins w . phi(x_i) for n rows
+void expand_margins(const FeatureExpansion* e, double* const* X, int n, const double* w, double* z_out);
+
+// Mean sample_loss over the rows; grad_out (D entries, may be NULL) receives its gradient
+double expand_loss_grad(const FeatureExpansion* e, double* const* X, const double* y, int n,
+                        LossType loss, const double* w, double* grad_out);
+
+// FuncPtrND / GradPtrND objectives over a whole dataset, for the optimizers of gd.h and optim.h
+void set_expansion(const FeatureExpansion* e, const Dataset* data, LossType loss);
+double expanded_loss(double* w, int dim);
+void expanded_grad(double* w, double* grad_out, int dim);
+
+#endif
@@ -32,5 +32,32 @@ void gradient_descent_rmsprop(FuncPtrND f, GradPtrND grad, double* x, int dim, d
 //  Nesterov Accelerated Gradient (NAG)
 void gradient_descent_nesterov(FuncPtrND f, GradPtrND grad, double* x, int dim, double lr, double momentum, int max_iters, double tol);
 
+// Per-iteration progress lines (on by default); returns the previous setting.
+// Change it only while no other thread is training.
+int gd_set_verbose(int verbose);
+
+
+// Optimizer selection for code that drives the methods above generically
+typedef enum {
+    OPT_GD,
+    OPT_MOMENTUM,
+    OPT_NESTEROV,
+    OPT_ADAGRAD,
+    OPT_RMSPROP,
+    OPT_ADAM
+} OptimizerType;
+
+typedef struct {
+    OptimizerType type;
+    double lr;
+    double momentum;   // Momentum / Nesterov gamma
+    double beta1;      // Adam first-moment decay
+    double beta2;      // Adam second-moment decay, RMSProp decay
+    double epsilon;    // Adagrad / RMSProp / Adam
+} OptimizerParams;
+
+OptimizerParams optimizer_default_params(OptimizerType type);
+const char* optimizer_name(OptimizerType type);
+
 
 #endif
@@ -0,0 +1,53 @@
+#ifndef HASHING_H
+#define HASHING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "dataset.h"
+
+// Hashing trick: string and numeric columns go straight into a fixed feature space
+// of 2^bits columns (plus the bias, column 0) while the file is parsed; no vocabulary
+// is built, so the feature dimension is fixed whatever the column cardinality.
+// Each feature lands at 1 + (h & (2^bits - 1)) with sign bit 31 of h, so colliding
+// features cancel in expectation instead of piling up (Weinberger et al. 2009).
+//
+// schema has one character per CSV column:
+//   'n' numeric      value at the column's own hashed slot
+//   'c' categorical  one feature per (column, value) pair
+//   't' text         lower-cased alphanumeric words and word n-grams up to `ngram`
+//   'l' label        y (see `positive`)
+//   '-' skipped
+typedef struct {
+    int bits;               // 1..30
+    const char* schema;
+    int ngram;              // text columns: n-grams of 1..ngram consecutive words
+    int has_header;
+    char delimiter;
+    const char* positive;   // y = 1 when the label equals this string, else 0; NULL parses numbers
+    uint32_t seed;
+} HashConfig;
+
+HashConfig hash_default_config(const char* schema, int bits);
+int hash_dim(const HashConfig* cfg);     // 2^bits + 1
+
+uint32_t hash_bytes(const void* key, size_t len, uint32_t seed);    // MurmurHash3 x86_32
+
+// One hashed record: entries sorted by index, duplicate indices summed
+typedef struct {
+    int nnz;
+    int cap;
+    int* idx;
+    double* val;
+    double y;
+} HashedRow;
+
+void hashed_row_init(HashedRow* row);
+void hashed_row_free(HashedRow* row);
+
+// Parses and hashes one CSV line (modified in place). Returns 0, or -1 on a missing column.
+int hash_record(const HashConfig* cfg, char* line, HashedRow* row);
+
+// Streams the file through hash_record into CSR rows; malformed lines are skipped.
+SparseDataset* load_hashed_csv(const char* filename, const HashConfig* cfg);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef HOTSWAP_H
+#define HOTSWAP_H
+
+#include "model.h"
+
+// A model that can be replaced while it is being served.
+//
+// Every publish builds a new immutable snapshot (a Model plus its version) and swaps it in
+// with one atomic exchange, so a reader sees either the old weights or the new ones, never
+// a mix. Readers take no lock: hot_acquire() announces the global epoch in the reader's own
+// slot and loads the current snapshot; hot_release() clears the slot. A replaced snapshot
+// is retired with the epoch of its replacement and freed (by the publisher) once no slot
+// announces an epoch at or before it, so a snapshot is never freed under a reader.
+// Publishing costs the reader nothing beyond two stores and a load per acquire.
+//
+// Readers must not hold a snapshot across a publish from the same thread.
+#define HOT_MAX_READERS 64
+
+typedef struct ModelHandle ModelHandle;
+
+// W (k x d) is copied into version 1
+ModelHandle* hot_create(ModelType type, int k, int d, const double* W);
+void hot_destroy(ModelHandle* h);   // no readers may be active
+
+// Publishers must not run concurrently with each other. Returns the new version.
+long long hot_publish(ModelHandle* h, const double* W);
+// Frees what no reader can still hold (every publish does this too); returns the
+// number of retired snapshots left. Publisher side only.
+int hot_reclaim(ModelHandle* h);
+long long hot_version(const ModelHandle* h);
+
+// A reader slot per serving thread; -1 when all HOT_MAX_READERS are taken
+int hot_reader_register(ModelHandle* h);
+void hot_reader_unregister(ModelHandle* h, int reader);
+
+// The snapshot stays valid, and unchanged, until hot_release(); version_out may be NULL.
+// NULL when reader is not a slot (e.g. the -1 of a failed hot_reader_register()).
+const Model* hot_acquire(ModelHandle* h, int reader, long long* version_out);
+void hot_release(ModelHandle* h, int reader);
+
+// acquire + predict_batch() + release; returns the version that scored the rows, or -1
+// without scoring when reader is not a slot
+long long hot_predict_batch(ModelHandle* h, int reader, const double* X, int n, double* scores_out, int* labels_out);
+
+typedef struct {
+    long long published;    // snapshots created, including the first
+    long long reclaimed;    // snapshots freed
+    int pending;            // retired but still possibly in use
+} HotStats;
+
+HotStats hot_stats(ModelHandle* h);
+
+// JobConfig.publish adapter (include/jobs.h): publishes the weights of a running job.
+// ctx is the ModelHandle; the job's dim must equal k * d.
+void hot_job_publish(const double* w, int dim, int iter, void* ctx);
+
+#endif
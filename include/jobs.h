@@ -0,0 +1,89 @@
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "gd.h"
+#include "dataset.h"
+#include "model.h"
+
+// Non-blocking training: job_submit() queues a run of one of the OptimizerType methods on a
+// shared JobExecutor (a work-stealing pool, include/pool.h) and returns a handle at once.
+// A job trains a private copy of the weights and, after every iteration, publishes its
+// progress and weights under the job's lock, so polling never sees a half-written step.
+// Cancellation is checked before every iteration. When the job stops, the weights are
+// copied to the caller's buffer, the on_done callback runs on the executor thread, and
+// only then are waiters released.
+//
+// The plain FuncPtrND objectives of model.h read the global dataset (set_dataset): jobs
+// on them may run side by side only while they all train on that same dataset.
+// job_submit_dataset() binds the data to the job instead and is safe with any mix.
+
+typedef enum {
+    JOB_QUEUED,         // waiting for an executor thread
+    JOB_RUNNING,
+    JOB_CONVERGED,      // step size fell below tol
+    JOB_FINISHED,       // ran max_iters
+    JOB_CANCELLED,
+    JOB_FAILED          // out of memory
+} JobStatus;
+
+typedef struct {
+    JobStatus status;
+    int iter;           // iterations completed
+    double change;      // sum |Δw_j| of the last iteration
+    double loss;        // objective at loss_iter (NAN until first evaluated)
+    int loss_iter;
+    double elapsed_s;   // running time so far
+} JobProgress;
+
+typedef struct TrainJob TrainJob;
+typedef struct JobExecutor JobExecutor;
+
+typedef void (*JobCallback)(TrainJob* job, const JobProgress* final, void* user);
+
+// Receives the weights of a running job on the executor thread (e.g. hot_job_publish, include/hotswap.h)
+typedef void (*JobPublishFn)(const double* w, int dim, int iter, void* ctx);
+
+typedef struct {
+    OptimizerParams opt;
+    int max_iters;
+    double tol;
+    int loss_every;         // evaluate the loss every N iterations (it costs a pass over the data); 0 = only at the end
+    JobCallback on_done;    // may be NULL
+    void* user;
+
+    // Intermediate weights: after every publish_every iterations and/or once publish_interval_s
+    // has passed since the last call (0 disables either), and once more when the job stops
+    JobPublishFn publish;   // may be NULL
+    void* publish_ctx;
+    int publish_every;
+    double publish_interval_s;
+} JobConfig;
+
+JobConfig job_default_config(OptimizerType type);
+
+JobExecutor* executor_create(int num_threads);     // <= 0 uses every online CPU
+// Cancels the jobs that have not finished and waits for them. Handles not yet released
+// stay valid for job_poll/job_wait until job_release().
+void executor_destroy(JobExecutor* ex);
+
+// w (dim doubles) holds the starting point and receives the result once the job stops;
+// it must stay valid until then and should not be read before. Returns NULL on failure.
+TrainJob* job_submit(JobExecutor* ex, FuncPtrND f, GradPtrND grad, double* w, int dim, const JobConfig* cfg);
+// Mean mse or logistic loss over data (data->d weights), without the model.h globals
+TrainJob* job_submit_dataset(JobExecutor* ex, const Dataset* data, LossType loss, double* w, const JobConfig* cfg);
+
+JobProgress job_poll(TrainJob* job);
+void job_snapshot(TrainJob* job, double* w_out);    // weights after the last completed iteration
+
+// 1 once the job has stopped, 0 on timeout; timeout_s < 0 waits indefinitely
+int job_wait(TrainJob* job, double timeout_s);
+
+// Asks the job to stop; a running job stops before its next iteration
+void job_cancel(TrainJob* job);
+
+// Drops the caller's handle; the job keeps running (or is freed once it stops)
+void job_release(TrainJob* job);
+
+const char* job_status_name(JobStatus status);
+
+#endif
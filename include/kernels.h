@@ -0,0 +1,25 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+// Kernels specialized at compile time for small feature counts (bias included).
+// With d a constant the inner loops unroll completely and the weights and
+// gradient accumulators stay in registers. Each kernel adds in the same order
+// as the generic loops in model.c, so results are bit-identical.
+// The logistic loss has no kernel here: one exp and two logs per row dominate
+// it, and bit-identical results leave those untouched. examples/kernels_fixed.c
+// measures the generic and specialized kernels side by side.
+
+#define FIXED_MAX_DIM 32
+
+typedef struct {
+    int d;
+    double (*dot)(const double* w, const double* x);
+    double (*mse_loss)(const double* w, double* const* X, const double* y, int n);
+    void (*mse_grad)(const double* w, double* const* X, const double* y, int n, double* grad_out);
+    void (*logistic_grad)(const double* w, double* const* X, const double* y, int n, double* grad_out);
+} FixedKernels;
+
+// NULL when d is outside 1..FIXED_MAX_DIM
+const FixedKernels* fixed_kernels(int d);
+
+#endif
@@ -2,11 +2,18 @@
 #define MODEL_H
 
 
+#include <stdio.h>
 #include "dataset.h"
+#include "stats.h"
+#include "reduce.h"
 
 void train_logistic(Dataset* data, double* weights, double lr, int max_iter);
 double predict_sample(double* w, double* x, int d);
 
+// Unrolled kernels for d <= FIXED_MAX_DIM (include/kernels.h) are picked by set_dataset();
+// on by default, switch off to force the generic loops.
+void use_fixed_kernels(int on);
+
 // Mean Squared Error: loss
 double mse_loss(double* weights, int dim);
 
@@ -21,6 +28,103 @@ void logistic_grad(double* weights, double* grad_out, int dim);
 double softmax_loss(double** W, int num_classes, int dim);
 void softmax_grad(double** W, double** grad_out, int num_classes, int dim);
 
+// Multi-output MSE over the dataset's target matrix Y (include/multitarget.h):
+// W holds m x d weights (dim = m * d), each pass over X serves every target.
+double multi_target_loss(double* W, int dim);
+void multi_target_grad(double* W, double* grad_out, int dim);
+
+// Runs the mse, logistic and softmax losses and gradients above as parallel row sums
+// (include/reduce.h). REDUCE_DETERMINISTIC returns the same bits for every num_threads;
+// REDUCE_FAST is quicker but its rounding follows the thread count; REDUCE_OFF (default)
+// restores the serial loops and fixed-d kernels. The mode applies to the calling thread
+// only: other threads, pool tasks included, keep their own (serial by default), so
+// concurrent callers never share a reducer. Set REDUCE_OFF before the thread exits to
+// release its workers.
+void set_reduction(ReduceMode mode, int num_threads);
+
+// Fuses a feature transform (include/stats.h) into the losses and gradients above:
+// weights are taken to act on transformed rows while the raw dataset is read as is.
+// The weights are folded into raw space once per call and the gradient unfolded,
+// so no normalized copy of the data is made. t->d must match the dataset; NULL turns it off.
+// Set it before evaluating; the objectives only read t and fold into per-thread buffers,
+// so several threads may evaluate them at once.
+void set_feature_transform(const FeatureTransform* t);
+
+
+// Regularized objectives: data loss + l1 * sum|w_j| + l2/2 * sum w_j² over j >= 1
+// (w[0], the bias, is not penalized). The l1 term contributes its subgradient sign(w_j);
+// solvers that need exact zeros should use the proximal path in include/path.h.
+void set_penalty(double l1, double l2);
+double penalty_value(const double* w, int dim);
+
+double reg_mse_loss(double* weights, int dim);
+void reg_mse_grad(double* weights, double* grad_out, int dim);
+double reg_logistic_loss(double* weights, int dim);
+void reg_logistic_grad(double* weights, double* grad_out, int dim);
+double reg_softmax_loss(double** W, int num_classes, int dim);
+void reg_softmax_grad(double** W, double** grad_out, int num_classes, int dim);
+
+
+// Per-sample losses on the margin z = w·x; the gradient w.r.t. w is sample_dloss(z, y) * x.
+// Averaged over the data these match mse_loss/mse_grad and logistic_loss/logistic_grad.
+typedef enum {
+    LOSS_MSE,
+    LOSS_LOGISTIC
+} LossType;
+
+double sample_loss(LossType type, double z, double y);
+double sample_dloss(LossType type, double z, double y);
+void sample_grad(LossType type, const double* w, const double* x, double y, int d, double* grad_out);
+double sparse_loss(LossType type, const SparseDataset* data, const double* w);
+
+
+// Saved models
+typedef enum {
+    MODEL_LINEAR = 1,
+    MODEL_LOGISTIC = 2,
+    MODEL_SOFTMAX = 3,
+    MODEL_OVR = 4       // one-vs-rest: k binary logistic rows, label = argmax of the margins
+} ModelType;
+
+typedef struct {
+    ModelType type;
+    int k;      // number of weight rows (1 for linear/logistic, num_classes for softmax)
+    int d;      // number of features (including bias)
+    double* W;  // k x d weights, row-major
+} Model;
+
+Model* create_model(ModelType type, int k, int d);
+void free_model(Model* m);
+int save_model(const char* filename, const Model* m);   // 0 on success
+int write_model(FILE* f, const Model* m);               // same format to an open stream
+Model* load_model(const char* filename);
+
+// Batch scoring of n contiguous rows (X is n x d, row-major).
+// scores_out[i] is the prediction (linear), P(y=1) (logistic), the top class probability (softmax)
+// or the winning row's sigmoid (one-vs-rest).
+// labels_out[i] is the predicted class (0 for linear); either output may be NULL.
+void predict_batch(const Model* m, const double* X, int n, double* scores_out, int* labels_out);
+
+
+// Sparse models keep only the nonzero weights of each row (CSR over the k rows),
+// so scoring touches only the features they use.
+typedef struct {
+    ModelType type;
+    int k, d;
+    int nnz;
+    int* row_ptr;   // k + 1 offsets into idx/val
+    int* idx;       // feature indices, ascending within a row
+    double* val;
+} SparseModel;
+
+SparseModel* sparse_model_from(const Model* m);   // drops exact zeros
+Model* sparse_model_to_dense(const SparseModel* sm);
+void free_sparse_model(SparseModel* sm);
+int save_sparse_model(const char* filename, const SparseModel* sm);   // 0 on success
+SparseModel* load_sparse_model(const char* filename);
+
+// Same outputs as predict_batch() on the dense model
+void predict_sparse_batch(const SparseModel* sm, const double* X, int n, double* scores_out, int* labels_out);
 
 
 #endif
@@ -0,0 +1,26 @@
+#ifndef MULTICLASS_H
+#define MULTICLASS_H
+
+#include "dataset.h"
+#include "model.h"
+
+// One-vs-rest: class c gets its own binary logistic model on the targets [y_i == c].
+// The classes are independent, so each one is a task on the work-stealing pool
+// (include/pool.h); all tasks read the same Dataset and write only their own row
+// of W. The result is a MODEL_OVR model, scored by predict_batch() with a batched
+// argmax over the rows.
+typedef struct {
+    int num_threads;    // <= 0 uses every online CPU
+    int max_iter;       // full-batch Adam steps per class
+    double lr;
+    double l2;          // ridge penalty l2/2 * sum w_j², j >= 1
+    double tol;         // a class stops once every |gradient_j| < tol
+} OvrConfig;
+
+OvrConfig ovr_default_config(void);
+
+// Labels must be class ids 0..num_classes-1 (e.g. from a LabelDict); num_classes <= 0
+// takes max(y) + 1. iters_out (num_classes entries, may be NULL) receives the steps per class.
+Model* train_ovr(const Dataset* data, int num_classes, const OvrConfig* cfg, int* iters_out);
+
+#endif
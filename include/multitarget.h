@@ -0,0 +1,29 @@
+#ifndef MULTITARGET_H
+#define MULTITARGET_H
+
+#include "dataset.h"
+#include "model.h"
+
+// Multi-output linear regression on the target matrix Y (data->m columns, see dataset.h).
+// W is m x d, row t holding the weights of target t, so it is the W of a MODEL_LINEAR
+// Model with k = m. Every kernel reads each row of X once for all m targets: rows are
+// taken in tiles of MULTI_TILE_ROWS and targets four at a time, so a tile of X stays
+// in cache while P = X W^T and G += R^T X are formed as blocked matrix products
+// (2 rows x 4 targets per register block).
+#define MULTI_TILE_ROWS 32
+
+// Sum over targets of the mean squared error; per_target_out (m entries) may be NULL
+double multi_mse(const Dataset* data, const double* W, double* per_target_out);
+
+// Same loss, and its gradient G (m x d): row t equals mse_grad() with y = Y[:, t]
+double multi_mse_grad(const Dataset* data, const double* W, double* G);
+
+// Ridge closed form for all targets: one pass forms X^T X + l2 I (bias unpenalized) and
+// X^T Y, a single Cholesky factorization serves every right-hand side.
+// Returns 0, or -1 when the system is not positive definite (raise l2).
+int multi_ridge_solve(const Dataset* data, double l2, double* W);
+
+// n x k outputs of a MODEL_LINEAR model with k rows (X is n x d, row-major)
+void predict_multi(const Model* m, const double* X, int n, double* out);
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef ONLINE_H
+#define ONLINE_H
+
+#include "model.h"
+
+// Online learning from an unbounded stream of rows.
+// Each row is scored before it is learned from (progressive validation), so the
+// running metrics are honest held-out estimates. Memory is fixed at create time:
+// per-row cost is O(k * d) whatever the number of rows seen.
+
+typedef enum {
+    ONLINE_ADAGRAD,   // w_j -= lr * g_j / (sqrt(sum g_j²) + epsilon)
+    ONLINE_FTRL       // FTRL-Proximal with per-coordinate rates and L1/L2 shrinkage
+} OnlineRule;
+
+typedef struct {
+    long long rows;        // rows learned from
+    double loss;           // mean progressive loss over all rows
+    double recent_loss;    // exponentially weighted over the last ~1/(1 - decay) rows
+    double accuracy;       // classification only (0 for linear)
+    double recent_accuracy;
+    int nonzeros;          // nonzero weights in the current model
+} OnlineMetrics;
+
+typedef void (*OnlineSnapshotFn)(const Model* snapshot, const OnlineMetrics* metrics, void* ctx);
+
+typedef struct {
+    ModelType type;
+    int k;                  // classes for MODEL_SOFTMAX (ignored otherwise)
+    int d;                  // features including bias
+    OnlineRule rule;
+    double lr;              // Adagrad step, FTRL alpha
+    double beta;            // FTRL rate smoothing
+    double l1, l2;          // FTRL regularization
+    double epsilon;         // Adagrad denominator guard
+    double decay;           // recent_* metrics, e.g. 0.999
+
+    long long snapshot_every;   // rows between snapshots (0 = never)
+    const char* snapshot_path;  // written atomically with save_model() format (may be NULL)
+    OnlineSnapshotFn on_snapshot;   // called with the published model (may be NULL)
+    void* ctx;
+} OnlineConfig;
+
+typedef struct OnlineLearner OnlineLearner;
+
+OnlineConfig online_default_config(ModelType type, int k, int d);
+
+OnlineLearner* online_create(const OnlineConfig* cfg);
+void online_destroy(OnlineLearner* ol);
+
+// Learns from one row (x has d entries, bias included; y is the target or class index).
+// Returns the prediction made before the update, as predict_batch() would score it.
+double online_update(OnlineLearner* ol, const double* x, double y);
+
+// n contiguous rows (X is n x d, row-major), applied in order.
+void online_update_batch(OnlineLearner* ol, const double* X, const double* y, int n);
+
+void online_metrics(const OnlineLearner* ol, OnlineMetrics* out);
+
+// Current weights; the model is owned by the learner and changes with every update.
+const Model* online_model(OnlineLearner* ol);
+
+// Publishes a snapshot now (path and/or callback); returns 0 on success.
+int online_snapshot(OnlineLearner* ol);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef OPTIM_H
+#define OPTIM_H
+
+#include <stddef.h>
+#include "gd.h"
+
+// Stateful optimizers: the caller drives iterations one step at a time.
+// All state lives in one cache-line aligned workspace allocated by optimizer_create,
+// so stepping never touches the heap.
+typedef struct {
+    OptimizerParams params;
+    GradPtrND grad;     // may be NULL when gradients are supplied through optimizer_apply
+    int dim;
+    int t;              // steps taken since create/reset
+
+    // Internal state (NULL when the method does not use it)
+    double* g;          // gradient of the last step
+    double* m;          // Adam first moment
+    double* v;          // Adam second moment
+    double* G;          // Adagrad sum of g², RMSProp moving average of g²
+    double* velocity;   // Momentum / Nesterov
+    double* lookahead;  // Nesterov evaluation point
+
+    double* workspace;
+    size_t workspace_len;   // doubles
+} Optimizer;
+
+Optimizer* optimizer_create(const OptimizerParams* params, GradPtrND grad, int dim);
+void optimizer_reset(Optimizer* opt);
+void optimizer_destroy(Optimizer* opt);
+
+// One iteration: evaluate grad at optimizer_eval_point() and update x.
+// Returns the step size sum |Δx_j|, the convergence measure gradient_descent_* uses.
+double optimizer_step(Optimizer* opt, double* x);
+
+// Split form for callers computing gradients themselves (mini-batches, parallel kernels):
+// g must be the gradient at the point returned by optimizer_eval_point(opt, x).
+const double* optimizer_eval_point(Optimizer* opt, const double* x);
+double optimizer_apply(Optimizer* opt, double* x, const double* g);
+
+// Steps until the change drops below tol or max_iters steps; returns steps taken.
+int optimizer_run(Optimizer* opt, double* x, int max_iters, double tol);
+
+#endif
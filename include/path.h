@@ -0,0 +1,46 @@
+#ifndef PATH_H
+#define PATH_H
+
+#include "dataset.h"
+#include "model.h"
+
+// Regularization path: the reg_* objectives of model.h solved for a decreasing grid
+//   lambda_i = lambda_max * lambda_min_ratio^(i / (num_lambdas - 1))
+// with l1 = alpha * lambda and l2 = (1 - alpha) * lambda (alpha = 1 is the lasso, 0 ridge).
+// Each point is solved by accelerated proximal gradient, warm-started from the previous
+// solution. The Gram matrix (MSE) or the margins X·w (logistic, softmax) are cached
+// across iterations and path points. Warm starts cut the total iterations against
+// solving every point from zero, but each point still needs tens to hundreds of
+// iterations, so a full path costs many times a single solve.
+typedef struct {
+    ModelType type;
+    int k;                      // classes for MODEL_SOFTMAX (ignored otherwise)
+    double alpha;
+    int num_lambdas;
+    double lambda_min_ratio;
+    double lambda_max;          // 0 = smallest lambda zeroing every penalized weight
+    double tol;                 // stop when every entry of the proximal gradient mapping is below tol
+    int max_iter;               // per path point
+    int warm_start;             // 0 solves every point from zero weights, for comparison
+} PathConfig;
+
+typedef struct {
+    int num;
+    int k, d;
+    double* lambda;
+    double* W;          // num x (k x d); point i starts at W + i * k * d
+    double* loss;       // data loss
+    double* objective;  // data loss + penalty
+    int* nonzeros;      // nonzero penalized weights
+    int* iters;
+    long long total_iters;
+} RegPath;
+
+PathConfig path_default_config(ModelType type, int k);
+
+// Rows of data must carry the bias in X[i][0] = 1 (add_bias_column); w[0] is not penalized.
+RegPath* reg_path(const Dataset* data, const PathConfig* cfg);
+const double* reg_path_weights(const RegPath* p, int i);
+void reg_path_free(RegPath* p);
+
+#endif
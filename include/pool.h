@@ -0,0 +1,24 @@
+#ifndef POOL_H
+#define POOL_H
+
+// Work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the bottom (LIFO)
+// and, when empty, steals from the top of a random victim (FIFO).
+
+typedef void (*TaskFn)(void* arg);
+
+typedef struct ThreadPool ThreadPool;
+
+ThreadPool* pool_create(int num_threads);   // <= 0 uses every online CPU
+void pool_destroy(ThreadPool* pool);        // waits for queued tasks first
+
+// Tasks submitted from inside a task go to the calling worker's own deque.
+void pool_submit(ThreadPool* pool, TaskFn fn, void* arg);
+
+// Blocks until every submitted task has finished. Not for use from inside a task.
+void pool_wait(ThreadPool* pool);
+
+int pool_size(const ThreadPool* pool);
+int pool_num_cpus(void);
+
+#endif
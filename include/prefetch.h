@@ -0,0 +1,57 @@
+#ifndef PREFETCH_H
+#define PREFETCH_H
+
+#include "dataset.h"
+
+// Background assembly of shuffled mini-batches into contiguous, aligned buffers.
+//
+// Worker threads claim batch numbers and fill the slots of a bounded ring; the
+// consumer takes batches strictly in order. Slots hand over through per-slot
+// sequence numbers (no locks), so batch N + 1 .. N + depth - 1 are being built
+// while batch N is in use. The batch order depends only on the seed, not on the
+// number of workers.
+
+typedef struct {
+    int rows;            // rows in this batch (the last batch of an epoch may be short)
+    int d;
+    double* X;           // rows x d, row-major, cache-line aligned
+    double* y;
+    int epoch;
+    long long index;     // batch sequence number
+} Batch;
+
+typedef struct {
+    int batch_size;
+    int queue_depth;     // slots in the ring (>= 2)
+    int num_workers;     // <= 0 uses every online CPU but one
+    int epochs;
+    unsigned long long seed;
+    const double* mean;  // optional: rows are written as (x - mean) * inv_std while gathering
+    const double* inv_std;
+} PrefetchConfig;
+
+typedef struct {
+    long long produced;
+    long long consumed;
+    int occupancy;              // batches built and not yet released by the consumer
+    long long consumer_stalls;  // prefetch_next calls that found their batch not ready
+    double consumer_wait_s;
+    long long producer_stalls;  // workers that found their slot still in use
+} PrefetchStats;
+
+typedef struct Prefetcher Prefetcher;
+
+PrefetchConfig prefetch_default_config(int batch_size, int epochs);
+
+// The dataset must stay alive and unmodified until prefetch_destroy.
+Prefetcher* prefetch_create(const Dataset* data, const PrefetchConfig* cfg);
+
+// Next batch in order, or NULL after the last epoch. Hand it back with prefetch_release
+// before asking for the next one.
+const Batch* prefetch_next(Prefetcher* p);
+void prefetch_release(Prefetcher* p, const Batch* b);
+
+void prefetch_stats(Prefetcher* p, PrefetchStats* out);
+void prefetch_destroy(Prefetcher* p);
+
+#endif
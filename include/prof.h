@@ -0,0 +1,45 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdio.h>
+
+// Opt-in profiling of kernels, optimizer updates and loaders.
+//
+// Build with -DCOPTI_PROFILE (make PROFILE=1) to compile the PROF_* regions in,
+// then turn them on with prof_enable(1) or COPTI_PROFILE=1 in the environment.
+// Each region records calls and wall time and, on Linux when perf_event_open is
+// permitted, cycles, instructions, LLC misses and branch misses (user space only).
+// Counts are inclusive: a region's numbers include the regions nested inside it.
+//
+// With COPTI_PROFILE=1 the summary table is printed to stderr at exit, and
+// COPTI_PROFILE_JSON=<file> additionally dumps it as JSON.
+
+typedef struct {
+    int active;
+    int region;
+    unsigned long long t0;
+    unsigned long long c0[4];
+} ProfScope;
+
+void prof_enable(int on);
+int prof_enabled(void);
+void prof_reset(void);
+void prof_report(FILE* out);
+int prof_dump_json(const char* filename);   // 0 on success
+
+int prof_register(const char* name);
+void prof_begin(ProfScope* s, int* region, const char* name);
+void prof_end(ProfScope* s);
+
+#ifdef COPTI_PROFILE
+#define PROF_BEGIN(name) \
+    static int prof_region_ = -1; \
+    ProfScope prof_scope_; \
+    prof_begin(&prof_scope_, &prof_region_, name)
+#define PROF_END() prof_end(&prof_scope_)
+#else
+#define PROF_BEGIN(name) ((void)0)
+#define PROF_END() ((void)0)
+#endif
+
+#endif
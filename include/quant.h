@@ -0,0 +1,79 @@
+#ifndef QUANT_H
+#define QUANT_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "model.h"
+#include "stats.h"
+#include "dataset.h"
+
+// Post-training int8 quantization of logistic, softmax and one-vs-rest models.
+//
+// Inputs: every raw feature j >= 1 is mapped onto 7-bit codes with its calibration range,
+//   x_j ~ lo_j + step_j * q_j,  q_j = clamp(round((x_j - lo_j) / step_j), 0, QUANT_INPUT_MAX).
+// The feature transform the model was trained with is folded into the weights first, so a
+// quantized model scores raw rows and replaces both the .bin and the .norm file.
+// Weights: with v_cj = w_cj * step_j (class c, raw space), v_c is stored as int8 with one
+// scale per class (QUANT_PER_CLASS) or one for the whole matrix (QUANT_PER_TENSOR), and
+//   z_c = bias_c + scale_c * sum_j vq_cj * q_j
+// where bias_c absorbs w_c0 and the sum of w_cj * lo_j. The sum is exact int32 arithmetic.
+//
+// Codes are 7-bit so that two u8 x s8 products never saturate the int16 pairs of AVX2
+// pmaddubsw (2 * 127 * 127 < 32767): every kernel (AVX512-VNNI, AVX2, scalar) returns the
+// same integers. The SIMD kernels are compiled in with make NATIVE=1 on machines that have them.
+#define QUANT_INPUT_MAX 127
+#define QUANT_BLOCK 32      // rows of codes and weights are padded with zeros to whole blocks
+
+typedef enum {
+    QUANT_PER_TENSOR,
+    QUANT_PER_CLASS
+} QuantScale;
+
+typedef struct {
+    ModelType type;     // MODEL_LOGISTIC, MODEL_SOFTMAX or MODEL_OVR
+    int k;
+    int d;              // features including the bias column, as the float model
+    int d_pad;          // code row length, a multiple of QUANT_BLOCK
+    int8_t* W;          // k x d_pad, row-major, cache-line aligned; column 0 unused
+    float* scale;       // k
+    float* bias;        // k
+    float* lo;          // d input offsets; lo[0] = inv_step[0] = 0 encode the bias column as 0
+    float* inv_step;    // d, 1 / step (0 for constant columns)
+} QuantModel;
+
+// m's weights apply to rows transformed by t (NULL: raw rows). calib holds raw-space
+// statistics of representative rows; clip_std > 0 narrows each range to mean +- clip_std
+// standard deviations (outliers then saturate), 0 uses min..max.
+QuantModel* quantize_model(const Model* m, const FeatureTransform* t, const ColumnStats* calib,
+                           QuantScale scale, double clip_std);
+void free_quant_model(QuantModel* qm);
+size_t quant_model_bytes(const QuantModel* qm);     // weights and per-class/per-feature tables
+int save_quant_model(const char* filename, const QuantModel* qm);   // 0 on success
+QuantModel* load_quant_model(const char* filename);
+
+// Raw rows (n x d, row-major) -> codes (n x d_pad). Rows kept as codes are 8x smaller
+// than doubles and skip this step at scoring time.
+void quant_encode_rows(const QuantModel* qm, const double* X, int n, uint8_t* codes_out);
+
+// Same outputs as predict_batch() on the float model with its transform applied
+void quant_predict_codes(const QuantModel* qm, const uint8_t* codes, int n, double* scores_out, int* labels_out);
+void quant_predict_batch(const QuantModel* qm, const double* X, int n, double* scores_out, int* labels_out);
+
+const char* quant_kernel_name(void);    // "avx512-vnni", "avx2" or "scalar"
+
+
+// Quantized vs float model on a labelled dataset (raw rows, y holds class ids)
+typedef struct {
+    int n;
+    double agreement;           // fraction of rows with the same predicted label
+    double accuracy_float;
+    double accuracy_quant;
+    double mean_score_error;    // |score_quant - score_float| over the rows
+    double max_score_error;
+} QuantReport;
+
+QuantReport quant_report(const QuantModel* qm, const Model* m, const FeatureTransform* t, const Dataset* data);
+void quant_report_print(const QuantReport* r, FILE* out);
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef REDUCE_H
+#define REDUCE_H
+
+// Parallel sums over the rows of a dataset, of a vector of len doubles (a gradient, a loss).
+//
+// REDUCE_FAST gives each thread one contiguous slice of rows, summed in a single running
+// accumulator, and adds the slices in order: the fastest split, but the rounding depends
+// on the thread count.
+//
+// REDUCE_DETERMINISTIC fixes the shape of the sum independently of the threads: rows are
+// cut into chunks of REDUCE_CHUNK_ROWS, each chunk into blocks of REDUCE_BLOCK_ROWS summed
+// in order, blocks are combined by a pairwise tree inside the chunk, and chunks by a
+// pairwise tree over the chunk index. Threads only decide who computes which chunk, so
+// every thread count produces the same bits. Pairwise combination also bounds the rounding
+// error by O(log n) instead of O(n). Each task sums an aligned power-of-two run of chunks,
+// one node of that tree, so partial sums are kept per task, not per chunk.
+#define REDUCE_CHUNK_ROWS 1024
+#define REDUCE_BLOCK_ROWS 32
+
+typedef enum {
+    REDUCE_OFF = 0,         // serial loops (model.c default)
+    REDUCE_FAST,
+    REDUCE_DETERMINISTIC
+} ReduceMode;
+
+// Adds the contributions of rows [begin, end) to acc (len doubles, not cleared).
+// scratch holds the scratch_len doubles passed to reducer_sum(), private to the caller.
+typedef void (*RowSumFn)(void* ctx, int begin, int end, double* acc, double* scratch);
+
+typedef struct Reducer Reducer;
+
+Reducer* reducer_create(ReduceMode mode, int num_threads);   // <= 0 threads: every online CPU
+void reducer_free(Reducer* r);
+ReduceMode reducer_mode(const Reducer* r);
+int reducer_threads(const Reducer* r);
+
+// out[0..len) = sum over rows 0..n-1 of fn's contributions. Also returns the sum as held
+// in the reducer, valid until its next call, so out may be NULL; NULL if n <= 0 or on
+// allocation failure. A Reducer serves one caller at a time.
+const double* reducer_sum(Reducer* r, int n, int len, int scratch_len, RowSumFn fn, void* ctx, double* out);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+// xorshift64* generator: a single word of state, so it can be copied,
+// given one per thread and saved alongside a model.
+typedef struct {
+    uint64_t s;
+} Rng;
+
+static inline void rng_seed(Rng* r, uint64_t seed) {
+    // splitmix64 scramble so nearby seeds give unrelated streams (and s != 0)
+    uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    r->s = (z ^ (z >> 31)) | 1;
+}
+
+static inline uint64_t rng_next(Rng* r) {
+    r->s ^= r->s >> 12;
+    r->s ^= r->s << 25;
+    r->s ^= r->s >> 27;
+    return r->s * 0x2545F4914F6CDD1Dull;
+}
+
+// Uniform in [0, 1)
+static inline double rng_uniform(Rng* r) {
+    return (rng_next(r) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform in [0, n)
+static inline int rng_int(Rng* r, int n) {
+    return (int)(((rng_next(r) >> 32) * (uint64_t)n) >> 32);
+}
+
+static inline void rng_shuffle(Rng* r, int* a, int n) {
+    for (int i = n - 1; i > 0; i--) {
+        int j = rng_int(r, i + 1);
+        int tmp = a[i];
+        a[i] = a[j];
+        a[j] = tmp;
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdio.h>
+#include "model.h"
+
+// Wire protocol (native byte order, no padding):
+//   request  = ServerRequestHeader followed by n_features doubles
+//   response = ServerResponse, one per request, possibly out of order across models
+typedef struct {
+    unsigned int request_id;
+    unsigned short model_id;    // index into the models the server was started with
+    unsigned short n_features;  // must equal the model's d (bias included)
+} ServerRequestHeader;
+
+typedef struct {
+    unsigned int request_id;
+    short status;               // SERVER_OK or a negative error code
+    short label;                // predicted class
+    double score;               // see predict_batch()
+} ServerResponse;
+
+#define SERVER_OK         0
+#define SERVER_ERR_MODEL -1     // unknown model_id
+#define SERVER_ERR_DIM   -2     // n_features does not match the model
+
+typedef struct {
+    const char* socket_path;  // Unix domain socket to listen on; NULL serves stdin/stdout
+    int max_batch;            // flush a micro-batch once it holds this many requests
+    int max_wait_us;          // ... or once its oldest request has waited this long
+    int queue_capacity;       // pending requests before readers block
+    int stats_interval_s;     // print counters to stderr every N seconds (0 = only at shutdown)
+} ServerConfig;
+
+typedef struct {
+    long long requests;
+    long long batches;
+    double elapsed_s;
+    double throughput;        // requests per second since start
+    double mean_batch;
+    double p50_us, p99_us;    // end-to-end latency over the most recent requests
+} ServerStats;
+
+typedef struct InferenceServer InferenceServer;
+
+ServerConfig server_default_config(void);
+
+// The server borrows the models; they must outlive it.
+InferenceServer* server_create(Model** models, int num_models, const ServerConfig* cfg);
+
+// Blocks until stdin reaches EOF (stdio mode) or server_stop() is called (socket mode).
+int server_run(InferenceServer* s);
+
+// Safe to call from a signal handler.
+void server_stop(InferenceServer* s);
+
+void server_get_stats(InferenceServer* s, ServerStats* out);
+void server_print_stats(InferenceServer* s, FILE* out);
+void server_destroy(InferenceServer* s);
+
+#endif
@@ -0,0 +1,71 @@
+#ifndef SGD_H
+#define SGD_H
+
+#include "dataset.h"
+#include "model.h"
+
+// Hogwild!: lock-free asynchronous SGD on the shared weight vector
+typedef enum {
+    HOGWILD_RACY,    // relaxed load/store per coordinate; concurrent updates may be lost
+    HOGWILD_ATOMIC   // per-coordinate atomic add (CAS loop); no update is lost
+} HogwildUpdate;
+
+typedef struct {
+    LossType loss;
+    int num_threads;      // <= 0 uses every online CPU
+    int epochs;           // passes each worker makes over its shard
+    double lr;
+    double decay;         // lr for epoch e is lr / (1 + decay * e)
+    HogwildUpdate update;
+    unsigned long long seed;
+} HogwildConfig;
+
+HogwildConfig hogwild_default_config(LossType loss);
+
+// Trains w (data->d entries) in place. Each worker owns a contiguous shard of rows,
+// visits it in its own random order and never waits on the others.
+void sgd_hogwild(const SparseDataset* data, double* w, const HogwildConfig* cfg);
+
+
+// Variance-reduced SGD on a finite sum f(w) = 1/n sum_i f_i(w) + l2/2 * sum_{j>=1} w_j²
+// (the reg_* objectives of model.h with l1 = 0).
+typedef enum {
+    VR_SVRG,    // full gradient at a snapshot every epoch, corrected per sample
+    VR_SAGA     // table of the last gradient seen for every sample
+} VRMethod;
+
+// Per-sample gradients. Linear models (data != NULL) have f_i(w) = sample_loss(loss, x_i·w, y_i),
+// so a gradient is a scalar times x_i and SAGA stores one scalar per sample.
+// Otherwise sample_grad(i, w, grad_out, ctx) is called and SAGA stores n x d doubles.
+typedef struct {
+    int n, d;
+    const Dataset* data;
+    LossType loss;
+    void (*sample_grad)(int i, const double* w, double* grad_out, void* ctx);
+    void* ctx;
+    double lipschitz;   // max smoothness of the f_i; 0 = computed for linear models
+} FiniteSum;
+
+FiniteSum finite_sum_linear(const Dataset* data, LossType loss);
+
+// Called after every epoch with the data passes so far (gradient evaluations / n);
+// return nonzero to stop.
+typedef int (*VREpochFn)(int epoch, double passes, const double* w, void* ctx);
+
+typedef struct {
+    VRMethod method;
+    double lr;          // 0 = 1 / (3 L) for SAGA, 1 / (5 L) for SVRG
+    double l2;
+    int epochs;
+    int inner;          // SVRG steps between snapshots (0 = 2n)
+    unsigned long long seed;
+    VREpochFn on_epoch;
+    void* ctx;
+} VRConfig;
+
+VRConfig vr_default_config(VRMethod method);
+
+// Trains w (f->d entries) in place; returns the data passes used.
+double sgd_vr(const FiniteSum* f, double* w, const VRConfig* cfg);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "dataset.h"
+#include "pool.h"
+
+// Per-column running statistics in one pass over the rows (Welford), mergeable
+// across threads and chunks with the pairwise update of Chan et al.
+typedef struct {
+    int d;
+    long long count;
+    double* mean;
+    double* m2;         // sum of squared deviations from the mean
+    double* min;
+    double* max;
+} ColumnStats;
+
+ColumnStats* stats_create(int d);
+void stats_reset(ColumnStats* s);
+void stats_free(ColumnStats* s);
+
+void stats_add_row(ColumnStats* s, const double* x);
+void stats_merge(ColumnStats* into, const ColumnStats* other);
+double stats_variance(const ColumnStats* s, int j);     // population variance
+double stats_std(const ColumnStats* s, int j);
+
+// Rows are split into fixed chunks whose partial statistics are merged in chunk
+// order, so the result does not depend on the pool size. pool may be NULL.
+ColumnStats* stats_compute(const Dataset* data, ThreadPool* pool);
+
+
+// Affine per-column map x_j -> (x_j - shift_j) * scale_j; column 0 (the bias) is left as is.
+typedef struct {
+    int d;
+    double* shift;
+    double* scale;
+} FeatureTransform;
+
+typedef enum {
+    TRANSFORM_STANDARDIZE,   // (x - mean) / (std + 1e-8), as normalize_features()
+    TRANSFORM_MINMAX         // (x - min) / (max - min) into [0, 1]
+} TransformType;
+
+FeatureTransform* transform_from_stats(const ColumnStats* s, TransformType type);
+void transform_free(FeatureTransform* t);
+
+void transform_apply_row(const FeatureTransform* t, double* x);
+void transform_apply(const FeatureTransform* t, Dataset* data);    // in place
+
+// Weights learned on transformed rows -> the same model on raw rows (k rows of d weights)
+void transform_fold_weights(const FeatureTransform* t, const double* w, double* w_raw, int k);
+
+// Chain rule back through the fold: gradient w.r.t. raw-space weights -> transformed-space, in place
+void transform_unfold_grad(const FeatureTransform* t, double* grad, int k);
+
+// stats_compute + TRANSFORM_STANDARDIZE + transform_apply; the caller owns the transform
+FeatureTransform* standardize_dataset(Dataset* data, ThreadPool* pool);
+
+int save_transform(const char* filename, const FeatureTransform* t);   // 0 on success
+FeatureTransform* load_transform(const char* filename);
+
+#endif
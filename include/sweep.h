@@ -0,0 +1,56 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <stdio.h>
+#include "gd.h"
+
+// Hyperparameter sweeps over OptimizerParams, run as tasks on a work-stealing pool.
+// All tasks share the objective (and therefore the dataset given to set_dataset) read-only.
+
+typedef struct {
+    const double* values;
+    int count;            // 0 keeps the optimizer's default
+} SweepAxis;
+
+typedef struct {
+    SweepAxis lr, momentum, beta1, beta2, epsilon;
+} SweepGrid;
+
+typedef struct {
+    double lo, hi;        // lo == hi == 0 keeps the optimizer's default
+} SweepRange;
+
+typedef struct {
+    SweepRange lr, momentum, beta1, beta2, epsilon;  // lr and epsilon are sampled log-uniformly
+} SweepSpace;
+
+// Both return a malloc'd array; *count receives its length.
+OptimizerParams* sweep_grid(OptimizerType type, const SweepGrid* grid, int* count);
+OptimizerParams* sweep_random(OptimizerType type, const SweepSpace* space, int count, unsigned long long seed);
+
+typedef struct {
+    int num_threads;      // <= 0 uses every online CPU
+    int min_iters;        // budget of the first successive-halving rung
+    int max_iters;        // budget of the last rung
+    int eta;              // each rung keeps the best 1/eta and multiplies the budget by eta (< 2 disables halving)
+    double tol;
+} SweepConfig;
+
+typedef struct {
+    OptimizerParams params;
+    double loss;          // f(x) after the last rung it ran (INFINITY if it diverged)
+    int iters;            // iterations budget of that rung (survivors resume, so this is total work)
+    int rung;
+    double* x;            // point reached (dim entries)
+} SweepResult;
+
+SweepConfig sweep_default_config(void);
+
+// Returns n results ranked best first: configurations that reached later rungs
+// come before those cancelled earlier, then by loss.
+SweepResult* sweep_run(FuncPtrND f, GradPtrND grad, const double* x0, int dim,
+                       const OptimizerParams* configs, int n, const SweepConfig* cfg);
+void sweep_print(const SweepResult* results, int n, int top, FILE* out);
+void sweep_free(SweepResult* results, int n);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef TRAIN_H
+#define TRAIN_H
+
+#include "dataset.h"
+#include "model.h"
+#include "optim.h"
+#include "rng.h"
+#include "prefetch.h"
+
+// Mini-batch training of a linear/logistic model with any Optimizer
+typedef struct {
+    LossType loss;
+    OptimizerParams opt;
+    int batch_size;
+    int epochs;
+    unsigned long long seed;
+    long long max_steps;          // stop after this many steps in total (0 = run all epochs)
+    const char* checkpoint_path;  // NULL disables checkpointing
+    int checkpoint_every;         // steps between checkpoints
+} MiniBatchConfig;
+
+// Everything a run depends on, so it can be checkpointed and resumed bit-exactly
+typedef struct {
+    Optimizer* opt;
+    double* w;
+    int dim;
+    int n;
+    int batch_size;
+    LossType loss;
+    Rng rng;
+    int* perm;        // sample order of the current epoch
+    int epoch;
+    int pos;          // next position in perm
+    long long step;
+} TrainState;
+
+MiniBatchConfig minibatch_default_config(LossType loss, OptimizerType type);
+
+TrainState* train_state_create(const Dataset* data, const MiniBatchConfig* cfg);
+void train_state_free(TrainState* st);
+
+// Runs from the state's current position until cfg->epochs or cfg->max_steps is reached.
+// Returns the number of steps taken by this call.
+long long train_minibatch(const Dataset* data, TrainState* st, const MiniBatchConfig* cfg);
+
+// Consumes every batch of a Prefetcher, stepping opt on w; the next batches are
+// assembled in the background while the current one is differentiated.
+long long train_minibatch_prefetched(Prefetcher* pf, LossType loss, Optimizer* opt, double* w);
+
+#endif
@@ -0,0 +1,489 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/batched.h"
+#include "../include/aligned.h"
+#include "../include/pool.h"
+#include "../include/prof.h"
+
+#define L BATCH_LANES
+
+// Arena
+
+// Keys are (rows << 32 | model): ascending row count, ties by model id
+static int by_key(const void* a, const void* b) {
+    unsigned long long x = *(const unsigned long long*)a, y = *(const unsigned long long*)b;
+    return x < y ? -1 : x > y;
+}
+
+ModelBatch* batch_create(int num_models, int d, const int* rows) {
+    if (num_models <= 0 || d <= 0) return NULL;
+    ModelBatch* b = calloc(1, sizeof(ModelBatch));
+    if (!b) return NULL;
+    b->num_models = num_models;
+    b->d = d;
+    b->num_groups = (num_models + L - 1) / L;
+    b->rows = malloc(num_models * sizeof(int));
+    b->slot = malloc(num_models * sizeof(int));
+    b->model = malloc((size_t)b->num_groups * L * sizeof(int));
+    b->group_rows = calloc(b->num_groups, sizeof(int));
+    b->group_off = malloc((b->num_groups + 1) * sizeof(size_t));
+    unsigned long long* order = malloc(num_models * sizeof(unsigned long long));
+    if (!b->rows || !b->slot || !b->model || !b->group_rows || !b->group_off || !order) {
+        free(order);
+        batch_free(b);
+        return NULL;
+    }
+
+    memcpy(b->rows, rows, num_models * sizeof(int));
+    for (int i = 0; i < num_models; i++) order[i] = (unsigned long long)rows[i] << 32 | (unsigned)i;
+    qsort(order, num_models, sizeof(unsigned long long), by_key);
+
+    for (int s = 0; s < b->num_groups * L; s++) {
+        int i = s < num_models ? (int)(order[s] & 0xffffffffu) : -1;
+        b->model[s] = i;
+        if (i < 0) continue;
+        b->slot[i] = s;
+        if (rows[i] > b->group_rows[s / L]) b->group_rows[s / L] = rows[i];
+    }
+    free(order);
+
+    b->group_off[0] = 0;
+    for (int g = 0; g < b->num_groups; g++) b->group_off[g + 1] = b->group_off[g] + b->group_rows[g];
+    size_t total = b->group_off[b->num_groups];
+
+    // Zeroed, so padded rows and empty lanes contribute nothing
+    b->X = aligned_malloc(total * d * L * sizeof(double));
+    b->y = aligned_malloc(total * L * sizeof(double));
+    b->wt = aligned_malloc(total * L * sizeof(double));
+    if (!b->X || !b->y || !b->wt) {
+        fprintf(stderr, "batch_create: cannot allocate %zu rows of %d features\n", total * L, d);
+        batch_free(b);
+        return NULL;
+    }
+    memset(b->X, 0, total * d * L * sizeof(double));
+    memset(b->y, 0, total * L * sizeof(double));
+    memset(b->wt, 0, total * L * sizeof(double));
+    return b;
+}
+
+void batch_free(ModelBatch* b) {
+    if (!b) return;
+    free(b->rows);
+    free(b->slot);
+    free(b->model);
+    free(b->group_rows);
+    free(b->group_off);
+    aligned_free(b->X);
+    aligned_free(b->y);
+    aligned_free(b->wt);
+    free(b);
+}
+
+void batch_set_row(ModelBatch* b, int model, int row, const double* x, double y) {
+    int s = b->slot[model];
+    size_t r = b->group_off[s / L] + row;
+    int lane = s % L;
+    double* xr = b->X + r * b->d * L + lane;
+    for (int j = 0; j < b->d; j++) xr[(size_t)j * L] = x[j];
+    b->y[r * L + lane] = y;
+    b->wt[r * L + lane] = 1.0 / b->rows[model];
+}
+
+ModelBatch* batch_from_datasets(Dataset* const* sets, int num) {
+    if (num <= 0) return NULL;
+    int d = sets[0]->d;
+    int* rows = malloc(num * sizeof(int));
+    if (!rows) return NULL;
+    for (int i = 0; i < num; i++) {
+        if (sets[i]->d != d) {
+            fprintf(stderr, "batch_from_datasets: dataset %d has %d features, expected %d\n", i, sets[i]->d, d);
+            free(rows);
+            return NULL;
+        }
+        rows[i] = sets[i]->n;
+    }
+    ModelBatch* b = batch_create(num, d, rows);
+    free(rows);
+    if (!b) return NULL;
+    for (int i = 0; i < num; i++)
+        for (int r = 0; r < sets[i]->n; r++) batch_set_row(b, i, r, sets[i]->X[r], sets[i]->y[r]);
+    return b;
+}
+
+
+// Kernels: every inner loop runs over the BATCH_LANES models of a group
+
+// exp(-z[l]) for every lane without a libm call, so the loop vectorizes like the rest.
+// 2^k comes from the exponent bits, e^r from a degree-11 Taylor polynomial on
+// |r| <= ln2/2; relative error ~2e-16 on the clamped range.
+static void lanes_exp_neg(const double* restrict z, double* restrict out) {
+    const double shift = 0x1.8p52;
+    for (int l = 0; l < L; l++) {
+        // Clamp to [-708, 708] without a branch; exact inside the range
+        double x = -z[l];
+        double over = x - 708.0, under = x + 708.0;
+        x -= 0.5 * (over + fabs(over));
+        x += 0.5 * (fabs(under) - under);
+        double kd = x * 1.4426950408889634 + shift;
+        unsigned long long bits;
+        memcpy(&bits, &kd, sizeof(bits));
+        kd -= shift;
+        double r = x - kd * 6.93147180369123816490e-01 - kd * 1.90821492927058770002e-10;
+        double p = 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+        bits = (bits + 1023) << 52;
+        double scale;
+        memcpy(&scale, &bits, sizeof(scale));
+        out[l] = p * scale;
+    }
+}
+
+// One group of lanes being trained. Its rows point into the ModelBatch arena, or into a
+// compacted copy once stopped models have been squeezed out.
+typedef struct {
+    const double* X;    // rows x d x L
+    const double* y;    // rows x L
+    const double* wt;
+    int rows;
+    int model[L];       // -1 for an empty lane
+    int steps[L];
+    int converged[L];
+    double active[L];   // 1.0 while the lane's model trains, else 0.0
+    double* state;      // w, Adam m and v, gradient: d x L each, feature-major
+} Group;
+
+// Mean logistic gradient of the group's models at w (both d x L)
+static void group_grad(const Group* grp, int d, const double* w, double* restrict grad) {
+    double z[L], e[L];
+    int rows = grp->rows;
+    memset(grad, 0, (size_t)d * L * sizeof(double));
+    for (int r = 0; r < rows; r++) {
+        const double* x = grp->X + (size_t)r * d * L;
+        const double* y = grp->y + (size_t)r * L;
+        const double* wt = grp->wt + (size_t)r * L;
+
+        for (int l = 0; l < L; l++) z[l] = 0.0;
+        for (int j = 0; j < d; j++)
+            for (int l = 0; l < L; l++) z[l] += w[j * L + l] * x[j * L + l];
+        lanes_exp_neg(z, e);
+        for (int l = 0; l < L; l++) e[l] = (1.0 / (1.0 + e[l]) - y[l]) * wt[l];
+        for (int j = 0; j < d; j++)
+            for (int l = 0; l < L; l++) grad[j * L + l] += e[l] * x[j * L + l];
+    }
+}
+
+typedef struct {
+    Group* grp;
+    const BatchConfig* cfg;
+    int d;
+} GroupTask;
+
+// Up to BATCH_ROUND_STEPS Adam steps for every live lane of a group
+static void train_group(void* arg) {
+    GroupTask* t = arg;
+    Group* grp = t->grp;
+    const BatchConfig* cfg = t->cfg;
+    int d = t->d;
+    double* w = grp->state;
+    double* m = w + (size_t)d * L;
+    double* v = m + (size_t)d * L;
+    double* grad = v + (size_t)d * L;
+    double gmax[L], c1[L], c2[L];
+
+    for (int round = 0; round < BATCH_ROUND_STEPS; round++) {
+        group_grad(grp, d, w, grad);
+        for (int j = 1; j < d; j++)
+            for (int l = 0; l < L; l++) grad[j * L + l] += cfg->l2 * w[j * L + l];
+
+        // Per-model stopping test; a stopped lane keeps its weights from then on
+        for (int l = 0; l < L; l++) gmax[l] = 0.0;
+        for (int j = 0; j < d; j++)
+            for (int l = 0; l < L; l++) {
+                double a = fabs(grad[j * L + l]);
+                gmax[l] = a > gmax[l] ? a : gmax[l];
+            }
+        int live = 0;
+        for (int l = 0; l < L; l++) {
+            if (grp->active[l] != 0.0 && gmax[l] < cfg->tol) grp->converged[l] = 1;
+            if (grp->active[l] != 0.0 && (grp->converged[l] || grp->steps[l] >= cfg->max_iter)) grp->active[l] = 0.0;
+            live += grp->active[l] != 0.0;
+        }
+        if (live == 0) break;
+
+        // Bias corrections per lane: models that joined from different groups differ in t
+        for (int l = 0; l < L; l++) {
+            int s = grp->steps[l] + (grp->active[l] != 0.0);
+            grp->steps[l] = s;
+            c1[l] = 1 - pow(cfg->beta1, s > 0 ? s : 1);
+            c2[l] = 1 - pow(cfg->beta2, s > 0 ? s : 1);
+        }
+        for (int j = 0; j < d; j++) {
+            for (int l = 0; l < L; l++) {
+                double gj = grad[j * L + l];
+                double mj = m[j * L + l] = cfg->beta1 * m[j * L + l] + (1 - cfg->beta1) * gj;
+                double vj = v[j * L + l] = cfg->beta2 * v[j * L + l] + (1 - cfg->beta2) * gj * gj;
+                w[j * L + l] -= grp->active[l] * (cfg->lr * (mj / c1[l]) / (sqrt(vj / c2[l]) + cfg->epsilon));
+            }
+        }
+    }
+}
+
+static int group_live(const Group* grp) {
+    int live = 0;
+    for (int l = 0; l < L; l++) live += grp->active[l] != 0.0;
+    return live;
+}
+
+// Weights and step counts of every model in the groups back to the caller's arrays
+static void write_back(const Group* groups, int num_groups, int d, double* W, int* iters) {
+    for (int g = 0; g < num_groups; g++) {
+        const Group* grp = &groups[g];
+        for (int l = 0; l < L; l++) {
+            if (grp->model[l] < 0) continue;
+            double* dst = W + (size_t)grp->model[l] * d;
+            for (int j = 0; j < d; j++) dst[j] = grp->state[j * L + l];
+            if (iters) iters[grp->model[l]] = grp->steps[l];
+        }
+    }
+}
+
+static void free_groups(Group* groups, int num_groups) {
+    for (int g = 0; g < num_groups; g++) aligned_free(groups[g].state);
+    free(groups);
+}
+
+// Repacks the live lanes of `groups` into as few groups as possible, copying their rows
+// into a fresh arena (*arena) and their state. Stopped models are written back first.
+static Group* compact_groups(const ModelBatch* b, Group* groups, int* num_groups, double** arena,
+                             double* W, int* iters) {
+    int d = b->d;
+    int live = 0;
+    for (int g = 0; g < *num_groups; g++) live += group_live(&groups[g]);
+    write_back(groups, *num_groups, d, W, iters);
+
+    // Live lanes ordered by row count, as in batch_create()
+    unsigned long long* order = malloc((live > 0 ? live : 1) * sizeof(unsigned long long));
+    int count = (live + L - 1) / L;
+    Group* out = calloc(count > 0 ? count : 1, sizeof(Group));
+    if (!order || !out) {
+        fprintf(stderr, "train_batch: cannot allocate the compacted groups\n");
+        free(order);
+        free(out);
+        return NULL;
+    }
+    int k = 0;
+    for (int g = 0; g < *num_groups; g++)
+        for (int l = 0; l < L; l++)
+            if (groups[g].active[l] != 0.0)
+                order[k++] = (unsigned long long)b->rows[groups[g].model[l]] << 32 | (unsigned)(g * L + l);
+    qsort(order, live, sizeof(unsigned long long), by_key);
+
+    size_t total = 0;
+    for (int g = 0; g < count; g++) {
+        int last = (g + 1) * L < live ? (g + 1) * L - 1 : live - 1;
+        out[g].rows = (int)(order[last] >> 32);
+        total += out[g].rows;
+    }
+    double* X = aligned_malloc(total * (d + 2) * L * sizeof(double));
+    if (!X) {
+        fprintf(stderr, "train_batch: cannot allocate the compacted arena\n");
+        free(order);
+        free(out);
+        aligned_free(X);
+        return NULL;
+    }
+    memset(X, 0, total * (d + 2) * L * sizeof(double));
+
+    size_t off = 0;
+    for (int g = 0; g < count; g++) {
+        Group* dst = &out[g];
+        double* xd = X + off * d * L;
+        double* yd = X + total * d * L + off * L;
+        double* wd = X + total * (d + 1) * L + off * L;
+        dst->X = xd;
+        dst->y = yd;
+        dst->wt = wd;
+        off += dst->rows;
+        dst->state = aligned_malloc(4 * (size_t)d * L * sizeof(double));
+        if (!dst->state) {
+            fprintf(stderr, "train_batch: cannot allocate the optimizer state\n");
+            free(order);
+            free_groups(out, count);
+            aligned_free(X);
+            return NULL;
+        }
+        memset(dst->state, 0, 4 * (size_t)d * L * sizeof(double));
+
+        for (int l = 0; l < L; l++) {
+            int e = g * L + l;
+            if (e >= live) {
+                dst->model[l] = -1;
+                continue;
+            }
+            int code = (int)(order[e] & 0xffffffffu);
+            const Group* src = &groups[code / L];
+            int sl = code % L;
+            dst->model[l] = src->model[sl];
+            dst->steps[l] = src->steps[sl];
+            dst->active[l] = 1.0;
+            for (int r = 0; r < (int)(order[e] >> 32); r++) {
+                for (int j = 0; j < d; j++) xd[((size_t)r * d + j) * L + l] = src->X[((size_t)r * d + j) * L + sl];
+                yd[(size_t)r * L + l] = src->y[(size_t)r * L + sl];
+                wd[(size_t)r * L + l] = src->wt[(size_t)r * L + sl];
+            }
+            for (size_t k3 = 0; k3 < 3 * (size_t)d; k3++) dst->state[k3 * L + l] = src->state[k3 * L + sl];
+        }
+    }
+    free(order);
+    free_groups(groups, *num_groups);
+    aligned_free(*arena);
+    *arena = X;
+    *num_groups = count;
+    return out;
+}
+
+BatchConfig batch_default_config(void) {
+    BatchConfig cfg;
+    cfg.num_threads = 0;
+    cfg.max_iter = 500;
+    cfg.lr = 0.05;
+    cfg.beta1 = 0.9;
+    cfg.beta2 = 0.999;
+    cfg.epsilon = 1e-8;
+    cfg.l2 = 1e-4;
+    cfg.tol = 1e-4;
+    return cfg;
+}
+
+int train_batch(const ModelBatch* b, const BatchConfig* cfg, double* W, int* iters_out) {
+    PROF_BEGIN("train_batch");
+    int d = b->d;
+    int num_groups = b->num_groups;
+    Group* groups = calloc(num_groups, sizeof(Group));
+    GroupTask* tasks = malloc(num_groups * sizeof(GroupTask));
+    ThreadPool* pool = pool_create(cfg->num_threads);
+    if (!groups || !tasks || !pool) {
+        free(groups);
+        free(tasks);
+        if (pool) pool_destroy(pool);
+        PROF_END();
+        return -1;
+    }
+
+    for (int g = 0; g < num_groups; g++) {
+        Group* grp = &groups[g];
+        size_t off = b->group_off[g];
+        grp->X = b->X + off * d * L;
+        grp->y = b->y + off * L;
+        grp->wt = b->wt + off * L;
+        grp->rows = b->group_rows[g];
+        grp->state = aligned_malloc(4 * (size_t)d * L * sizeof(double));
+        if (!grp->state) {
+            fprintf(stderr, "train_batch: cannot allocate the optimizer state\n");
+            free_groups(groups, num_groups);
+            free(tasks);
+            pool_destroy(pool);
+            PROF_END();
+            return -1;
+        }
+        memset(grp->state, 0, 4 * (size_t)d * L * sizeof(double));
+        for (int l = 0; l < L; l++) {
+            int i = b->model[(size_t)g * L + l];
+            grp->model[l] = i;
+            grp->active[l] = i >= 0 ? 1.0 : 0.0;
+            if (i < 0) continue;
+            for (int j = 0; j < d; j++) grp->state[j * L + l] = W[(size_t)i * d + j];
+        }
+    }
+
+    // Rounds of BATCH_ROUND_STEPS steps. Lanes never interact, so repacking the live
+    // models between rounds changes the speed but not a single bit of the result.
+    double* arena = NULL;
+    int converged = 0;
+    for (;;) {
+        int submitted = 0;
+        for (int g = 0; g < num_groups; g++) {
+            if (group_live(&groups[g]) == 0) continue;
+            tasks[submitted].grp = &groups[g];
+            tasks[submitted].cfg = cfg;
+            tasks[submitted].d = d;
+            pool_submit(pool, train_group, &tasks[submitted]);
+            submitted++;
+        }
+        if (submitted == 0) break;
+        pool_wait(pool);
+
+        int live = 0, live_groups = 0;
+        for (int g = 0; g < num_groups; g++) {
+            int n = group_live(&groups[g]);
+            live += n;
+            live_groups += n > 0;
+        }
+        if (live > 0 && 4 * ((live + L - 1) / L) <= 3 * live_groups) {
+            // Convergence of the lanes about to be dropped, counted once they are gone
+            int dropped = 0;
+            for (int g = 0; g < num_groups; g++)
+                for (int l = 0; l < L; l++)
+                    if (groups[g].model[l] >= 0 && groups[g].active[l] == 0.0) dropped += groups[g].converged[l];
+            // On failure the current groups are kept and trained uncompacted
+            Group* packed = compact_groups(b, groups, &num_groups, &arena, W, iters_out);
+            if (!packed) continue;
+            converged += dropped;
+            groups = packed;
+        }
+    }
+
+    for (int g = 0; g < num_groups; g++)
+        for (int l = 0; l < L; l++)
+            if (groups[g].model[l] >= 0) converged += groups[g].converged[l];
+    write_back(groups, num_groups, d, W, iters_out);
+
+    free_groups(groups, num_groups);
+    aligned_free(arena);
+    free(tasks);
+    pool_destroy(pool);
+    PROF_END();
+    return converged;
+}
+
+void batch_loss(const ModelBatch* b, const double* W, double* loss_out) {
+    int d = b->d;
+    double* w = aligned_malloc((size_t)d * L * sizeof(double));
+    if (!w) return;
+    double z[L], sum[L];
+    for (int g = 0; g < b->num_groups; g++) {
+        const int* model = b->model + (size_t)g * L;
+        for (int l = 0; l < L; l++)
+            for (int j = 0; j < d; j++) w[j * L + l] = model[l] >= 0 ? W[(size_t)model[l] * d + j] : 0.0;
+
+        for (int l = 0; l < L; l++) sum[l] = 0.0;
+        for (int r = 0; r < b->group_rows[g]; r++) {
+            size_t row = b->group_off[g] + r;
+            const double* x = b->X + row * d * L;
+            const double* y = b->y + row * L;
+            const double* wt = b->wt + row * L;
+            for (int l = 0; l < L; l++) z[l] = 0.0;
+            for (int j = 0; j < d; j++)
+                for (int l = 0; l < L; l++) z[l] += w[j * L + l] * x[j * L + l];
+            for (int l = 0; l < L; l++) {
+                double p = 1.0 / (1.0 + exp(-z[l]));
+                sum[l] += wt[l] * (-y[l] * log(p + 1e-8) - (1 - y[l]) * log(1 - p + 1e-8));
+            }
+        }
+        for (int l = 0; l < L; l++)
+            if (model[l] >= 0) loss_out[model[l]] = sum[l];
+    }
+    aligned_free(w);
+}
@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/cd.h"
+#include "../include/prof.h"
+
+CDConfig cd_default_config(LossType loss, double lambda) {
+    CDConfig cfg;
+    cfg.loss = loss;
+    cfg.lambda = lambda;
+    cfg.alpha = 1.0;
+    cfg.tol = 1e-7;
+    cfg.max_epochs = 10000;
+    cfg.screening = 1;
+    return cfg;
+}
+
+typedef struct {
+    const ColumnDataset* data;
+    LossType loss;
+    int n, d;
+    double l1, l2;
+    double* w;
+    double* colsq;      // ||x_j||²
+    double* h;          // per-coordinate curvature (exact for MSE, 1/4 bound for logistic)
+    double* r;          // MSE: residual y - Xw
+    double* z;          // logistic: margins Xw
+    double* p;          // logistic: sigmoid(z)
+    char* screened;
+    int* active;
+    int nactive;
+    long long updates;
+} CDState;
+
+static const double* column(const CDState* s, int j) {
+    return s->data->cols + (size_t)j * s->n;
+}
+
+static double sigmoid(double z) {
+    return 1.0 / (1.0 + exp(-z));
+}
+
+static double softplus(double z) {
+    return (z > 0 ? z : 0.0) + log1p(exp(-fabs(z)));
+}
+
+static void state_init(CDState* s, const ColumnDataset* data, LossType loss, double l1, double l2, double* w) {
+    int n = data->n, d = data->d;
+    memset(s, 0, sizeof(*s));
+    s->data = data;
+    s->loss = loss;
+    s->n = n;
+    s->d = d;
+    s->l1 = l1;
+    s->l2 = l2;
+    s->w = w;
+    s->colsq = malloc(d * sizeof(double));
+    s->h = malloc(d * sizeof(double));
+    s->screened = calloc(d, 1);
+    s->active = malloc(d * sizeof(int));
+
+    for (int j = 0; j < d; j++) {
+        const double* x = column(s, j);
+        double sq = 0.0;
+        for (int i = 0; i < n; i++) sq += x[i] * x[i];
+        s->colsq[j] = sq;
+        s->h[j] = (loss == LOSS_MSE ? 2.0 : 0.25) * sq / n;
+    }
+
+    double* m = malloc(n * sizeof(double));
+    for (int i = 0; i < n; i++) m[i] = 0.0;
+    for (int j = 0; j < d; j++) {
+        if (w[j] == 0.0) continue;
+        const double* x = column(s, j);
+        for (int i = 0; i < n; i++) m[i] += w[j] * x[i];
+    }
+    if (loss == LOSS_MSE) {
+        for (int i = 0; i < n; i++) m[i] = data->y[i] - m[i];
+        s->r = m;
+    } else {
+        s->z = m;
+        s->p = malloc(n * sizeof(double));
+        for (int i = 0; i < n; i++) s->p[i] = sigmoid(m[i]);
+    }
+}
+
+static void state_free(CDState* s) {
+    free(s->colsq);
+    free(s->h);
+    free(s->screened);
+    free(s->active);
+    free(s->r);
+    free(s->z);
+    free(s->p);
+}
+
+// Gradient of the data loss along coordinate j
+static double coord_grad(const CDState* s, int j) {
+    const double* x = column(s, j);
+    double g = 0.0;
+    if (s->loss == LOSS_MSE) {
+        for (int i = 0; i < s->n; i++) g += x[i] * s->r[i];
+        return -2.0 * g / s->n;
+    }
+    for (int i = 0; i < s->n; i++) g += x[i] * (s->p[i] - s->data->y[i]);
+    return g / s->n;
+}
+
+// Moves w_j by delta and keeps the residual / margins in step
+static void apply_delta(CDState* s, int j, double delta) {
+    const double* x = column(s, j);
+    s->w[j] += delta;
+    if (s->loss == LOSS_MSE) {
+        for (int i = 0; i < s->n; i++) s->r[i] -= delta * x[i];
+    } else {
+        for (int i = 0; i < s->n; i++) {
+            if (x[i] == 0.0) continue;
+            s->z[i] += delta * x[i];
+            s->p[i] = sigmoid(s->z[i]);
+        }
+    }
+}
+
+// Exact minimization over the bias: closed form for MSE, Newton for logistic.
+// The dual point used for screening is only feasible when this gradient vanishes.
+static double update_bias(CDState* s) {
+    if (s->colsq[0] == 0.0) return 0.0;
+    if (s->loss == LOSS_MSE) {
+        double delta = -coord_grad(s, 0) / s->h[0];
+        if (delta != 0.0) apply_delta(s, 0, delta);
+        s->updates++;
+        return s->h[0] * delta * delta;
+    }
+
+    const double* x = column(s, 0);
+    double change = 0.0;
+    for (int it = 0; it < 50; it++) {
+        double g = 0.0, hess = 0.0;
+        for (int i = 0; i < s->n; i++) {
+            g += x[i] * (s->p[i] - s->data->y[i]);
+            hess += x[i] * x[i] * s->p[i] * (1.0 - s->p[i]);
+        }
+        s->updates++;
+        if (hess <= 0.0) break;
+        double delta = -g / hess;
+        apply_delta(s, 0, delta);
+        change += hess / s->n * delta * delta;
+        if (fabs(g) <= 1e-13 * s->n) break;
+    }
+    return change;
+}
+
+// Proximal coordinate step; returns h_j * delta², a measure of the decrease
+static double update_coord(CDState* s, int j) {
+    double h = s->h[j];
+    if (h == 0.0) return 0.0;
+    double u = h * s->w[j] - coord_grad(s, j);
+    double w_new = 0.0;
+    if (u > s->l1) w_new = (u - s->l1) / (h + s->l2);
+    else if (u < -s->l1) w_new = (u + s->l1) / (h + s->l2);
+
+    s->updates++;
+    double delta = w_new - s->w[j];
+    if (delta == 0.0) return 0.0;
+    apply_delta(s, j, delta);
+    return h * delta * delta;
+}
+
+static double objective(const CDState* s) {
+    double loss = 0.0;
+    if (s->loss == LOSS_MSE) {
+        for (int i = 0; i < s->n; i++) loss += s->r[i] * s->r[i];
+    } else {
+        for (int i = 0; i < s->n; i++) loss += softplus(s->z[i]) - s->data->y[i] * s->z[i];
+    }
+    loss /= s->n;
+    for (int j = 1; j < s->d; j++) loss += s->l1 * fabs(s->w[j]) + 0.5 * s->l2 * s->w[j] * s->w[j];
+    return loss;
+}
+
+static double xlogx(double u) {
+    return u > 0.0 ? u * log(u) : 0.0;
+}
+
+// Duality gap at the current w (objective units) and gap-safe screening of the
+// penalized coordinates. Scaled problems, with lambda' = n * l1 / 2 (MSE) or n * l1:
+//   MSE:      1/2 ||y - Xw||² + kappa/2 ||w||² + lambda' ||w||_1, kappa = n * l2 / 2,
+//             an augmented least-squares problem; dual sphere radius sqrt(2 G) / lambda'
+//   logistic: sum log(1 + e^z_i) - y_i z_i + lambda' ||w||_1;
+//             dual -sum Nh(y_i - lambda' theta_i), 4-strongly concave: radius sqrt(G / 2) / lambda'
+// Coordinates with |x_j·theta| + radius * ||x_j|| < 1 are zero at the optimum.
+static double gap_and_screen(CDState* s, int screen) {
+    int n = s->n, d = s->d;
+    int mse = s->loss == LOSS_MSE;
+    double lam = mse ? 0.5 * n * s->l1 : n * s->l1;
+    double kappa = mse ? 0.5 * n * s->l2 : 0.0;
+    if (lam <= 0.0 || (!mse && s->l2 > 0.0)) return -1.0;
+
+    // Dual scaling: theta = rho / scale with |x_j·theta| <= 1 for every penalized j
+    double* c = malloc(d * sizeof(double));
+    double scale = lam;
+    for (int j = 1; j < d; j++) {
+        const double* x = column(s, j);
+        double v = 0.0;
+        if (mse) {
+            for (int i = 0; i < n; i++) v += x[i] * s->r[i];
+            v -= kappa * s->w[j];
+        } else {
+            for (int i = 0; i < n; i++) v += x[i] * (s->data->y[i] - s->p[i]);
+        }
+        c[j] = v;
+        if (fabs(v) > scale) scale = fabs(v);
+    }
+
+    double l1norm = 0.0, l2sq = 0.0;
+    for (int j = 1; j < d; j++) {
+        l1norm += fabs(s->w[j]);
+        l2sq += s->w[j] * s->w[j];
+    }
+
+    double primal = 0.0, dual = 0.0, radius;
+    if (mse) {
+        double rr = 0.0, yy = 0.0, dist = 0.0;
+        for (int i = 0; i < n; i++) {
+            double yi = s->data->y[i];
+            rr += s->r[i] * s->r[i];
+            yy += yi * yi;
+            double t = s->r[i] / scale - yi / lam;
+            dist += t * t;
+        }
+        dist += kappa * l2sq / (scale * scale);
+        primal = 0.5 * rr + 0.5 * kappa * l2sq + lam * l1norm;
+        dual = 0.5 * yy - 0.5 * lam * lam * dist;
+    } else {
+        for (int i = 0; i < n; i++) {
+            double yi = s->data->y[i];
+            double u = yi - lam * (yi - s->p[i]) / scale;   // between y_i and p_i, so in [0, 1]
+            primal += softplus(s->z[i]) - yi * s->z[i];
+            dual -= xlogx(u) + xlogx(1.0 - u);
+        }
+        primal += lam * l1norm;
+    }
+    double gap = primal - dual;
+    if (gap < 0.0) gap = 0.0;
+    radius = mse ? sqrt(2.0 * gap) / lam : sqrt(0.5 * gap) / lam;
+
+    if (screen) {
+        for (int j = 1; j < d; j++) {
+            if (s->screened[j]) continue;
+            double norm = sqrt(s->colsq[j] + kappa);
+            if (fabs(c[j]) / scale + radius * norm < 1.0) {
+                s->screened[j] = 1;
+                if (s->w[j] != 0.0) apply_delta(s, j, -s->w[j]);
+            }
+        }
+    }
+
+    free(c);
+    return gap / (mse ? 0.5 * n : n);
+}
+
+static double lambda_max_from(CDState* s, double alpha) {
+    double gmax = 0.0;
+    for (int j = 1; j < s->d; j++) {
+        double g = fabs(coord_grad(s, j));
+        if (g > gmax) gmax = g;
+    }
+    return gmax / (alpha > 1e-3 ? alpha : 1e-3);
+}
+
+double cd_lambda_max(const ColumnDataset* data, LossType loss, double alpha) {
+    double* w = calloc(data->d, sizeof(double));
+    CDState s;
+    state_init(&s, data, loss, 0.0, 0.0, w);
+    update_bias(&s);
+    double lmax = lambda_max_from(&s, alpha);
+    state_free(&s);
+    free(w);
+    return lmax;
+}
+
+int cd_fit(const ColumnDataset* data, double* w, const CDConfig* cfg, CDResult* out) {
+    PROF_BEGIN("cd_fit");
+    CDState s;
+    state_init(&s, data, cfg->loss, cfg->alpha * cfg->lambda, (1.0 - cfg->alpha) * cfg->lambda, w);
+
+    int d = s.d, epochs = 0, converged = 0;
+    double gap = -1.0, obj = objective(&s);
+    while (epochs < cfg->max_epochs) {
+        // Full sweep over every coordinate still in play
+        double change = update_bias(&s);
+        for (int j = 1; j < d; j++)
+            if (!s.screened[j]) {
+                double c = update_coord(&s, j);
+                if (c > change) change = c;
+            }
+        epochs++;
+
+        obj = objective(&s);
+        update_bias(&s);
+        gap = gap_and_screen(&s, cfg->screening);
+        if (gap >= 0.0 ? gap <= cfg->tol * obj : change <= cfg->tol * obj) {
+            converged = 1;
+            break;
+        }
+
+        // Cycle the nonzero coordinates until they settle, then sweep everything again
+        s.nactive = 0;
+        for (int j = 1; j < d; j++)
+            if (!s.screened[j] && w[j] != 0.0) s.active[s.nactive++] = j;
+        while (epochs < cfg->max_epochs) {
+            change = update_bias(&s);
+            for (int a = 0; a < s.nactive; a++) {
+                double c = update_coord(&s, s.active[a]);
+                if (c > change) change = c;
+            }
+            epochs++;
+            if (change <= 0.1 * cfg->tol * obj) break;
+        }
+    }
+
+    if (out) {
+        out->epochs = epochs;
+        out->coord_updates = s.updates;
+        out->screened = 0;
+        out->nonzeros = 0;
+        for (int j = 1; j < d; j++) {
+            out->screened += s.screened[j];
+            out->nonzeros += w[j] != 0.0;
+        }
+        out->objective = objective(&s);
+        out->gap = gap;
+    }
+
+    state_free(&s);
+    PROF_END();
+    return converged ? 0 : -1;
+}
@@ -0,0 +1,312 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "../include/checkpoint.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+#define CKPT_MAGIC 0x54504B43u  // "CKPT"
+#define CKPT_VERSION 1u
+
+typedef struct {
+    uint32_t magic, version;
+    int32_t type, dim, n, batch_size, loss, t, epoch, pos;
+    int64_t step;
+    uint64_t rng;
+    double params[5];          // lr, momentum, beta1, beta2, epsilon
+    uint64_t workspace_len;
+} CheckpointHeader;
+
+
+// Serialization
+
+static size_t checkpoint_size(const TrainState* st) {
+    return sizeof(CheckpointHeader) + st->dim * sizeof(double) +
+           st->opt->workspace_len * sizeof(double) + st->n * sizeof(int32_t);
+}
+
+static void checkpoint_serialize(const TrainState* st, char* buf) {
+    const OptimizerParams* p = &st->opt->params;
+    CheckpointHeader h;
+    memset(&h, 0, sizeof(h));
+    h.magic = CKPT_MAGIC;
+    h.version = CKPT_VERSION;
+    h.type = p->type;
+    h.dim = st->dim;
+    h.n = st->n;
+    h.batch_size = st->batch_size;
+    h.loss = st->loss;
+    h.t = st->opt->t;
+    h.epoch = st->epoch;
+    h.pos = st->pos;
+    h.step = st->step;
+    h.rng = st->rng.s;
+    h.params[0] = p->lr;
+    h.params[1] = p->momentum;
+    h.params[2] = p->beta1;
+    h.params[3] = p->beta2;
+    h.params[4] = p->epsilon;
+    h.workspace_len = st->opt->workspace_len;
+
+    memcpy(buf, &h, sizeof(h));
+    buf += sizeof(h);
+    memcpy(buf, st->w, st->dim * sizeof(double));
+    buf += st->dim * sizeof(double);
+    memcpy(buf, st->opt->workspace, st->opt->workspace_len * sizeof(double));
+    buf += st->opt->workspace_len * sizeof(double);
+    for (int i = 0; i < st->n; i++) {
+        int32_t v = st->perm[i];
+        memcpy(buf + i * sizeof(int32_t), &v, sizeof(v));
+    }
+}
+
+int write_file_atomic(const char* path, int (*write_fn)(FILE* f, const void* ctx), const void* ctx) {
+    size_t cap = strlen(path) + 32;
+    char* tmp = malloc(cap);
+    if (!tmp) return -1;
+
+    // A temp name of our own, so two writers of the same path never share one
+    FILE* f = NULL;
+#ifdef _WIN32
+    static unsigned int counter = 0;
+    snprintf(tmp, cap, "%s.%lu.%u.tmp", path, (unsigned long)GetCurrentProcessId(),
+             __atomic_add_fetch(&counter, 1, __ATOMIC_RELAXED));
+    f = fopen(tmp, "wb");
+#else
+    snprintf(tmp, cap, "%s.XXXXXX", path);
+    int fd = mkstemp(tmp);
+    if (fd >= 0) {
+        fchmod(fd, 0644);
+        f = fdopen(fd, "wb");
+        if (!f) close(fd);
+    }
+#endif
+
+    int ok = 0;
+    if (f) {
+        ok = write_fn(f, ctx) == 0 && fflush(f) == 0;
+#ifdef _WIN32
+        ok = ok && _commit(_fileno(f)) == 0;
+#else
+        ok = ok && fsync(fileno(f)) == 0;
+#endif
+        if (fclose(f) != 0) ok = 0;
+    }
+
+    if (ok) {
+#ifdef _WIN32
+        ok = MoveFileExA(tmp, path, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+        ok = rename(tmp, path) == 0;
+#endif
+    }
+    if (!ok) {
+        fprintf(stderr, "%s: ", path);
+        perror("atomic write failed");
+        if (f) remove(tmp);
+    }
+
+    free(tmp);
+    return ok ? 0 : -1;
+}
+
+typedef struct {
+    const char* data;
+    size_t len;
+} Buffer;
+
+static int write_buffer(FILE* f, const void* ctx) {
+    const Buffer* b = ctx;
+    return fwrite(b->data, 1, b->len, f) == b->len ? 0 : -1;
+}
+
+static int write_atomic(const char* path, const char* buf, size_t len) {
+    Buffer b = { buf, len };
+    return write_file_atomic(path, write_buffer, &b);
+}
+
+int checkpoint_save(const char* path, const TrainState* st) {
+    size_t len = checkpoint_size(st);
+    char* buf = malloc(len);
+    if (!buf) return -1;
+    checkpoint_serialize(st, buf);
+    int rc = write_atomic(path, buf, len);
+    free(buf);
+    return rc;
+}
+
+int checkpoint_load(const char* path, TrainState* st) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        perror("Checkpoint error");
+        return -1;
+    }
+
+    CheckpointHeader h;
+    int ok = fread(&h, sizeof(h), 1, f) == 1 && h.magic == CKPT_MAGIC && h.version == CKPT_VERSION &&
+             h.type == (int32_t)st->opt->params.type && h.dim == st->dim && h.n == st->n &&
+             h.workspace_len == st->opt->workspace_len && h.batch_size >= 1 && h.epoch >= 0 &&
+             h.pos >= 0 && h.pos <= h.n;
+    if (!ok) {
+        fprintf(stderr, "%s: checkpoint is invalid or does not match this training state\n", path);
+        fclose(f);
+        return -1;
+    }
+
+    int32_t* perm = malloc((st->n > 0 ? st->n : 1) * sizeof(int32_t));
+    char* seen = calloc(st->n > 0 ? st->n : 1, 1);
+    if (!perm || !seen) {
+        perror("Checkpoint error");
+        free(perm);
+        free(seen);
+        fclose(f);
+        return -1;
+    }
+    ok = fread(st->w, sizeof(double), st->dim, f) == (size_t)st->dim &&
+         fread(st->opt->workspace, sizeof(double), h.workspace_len, f) == h.workspace_len &&
+         fread(perm, sizeof(int32_t), st->n, f) == (size_t)st->n;
+    fclose(f);
+    if (!ok) fprintf(stderr, "%s: truncated checkpoint\n", path);
+
+    // The row order must be a permutation of 0..n-1, or resuming would read outside the data
+    for (int i = 0; ok && i < st->n; i++) {
+        ok = perm[i] >= 0 && perm[i] < st->n && !seen[perm[i]];
+        if (ok) seen[perm[i]] = 1;
+        else fprintf(stderr, "%s: row order is not a permutation of the %d rows\n", path, st->n);
+    }
+
+    if (ok) {
+        for (int i = 0; i < st->n; i++) st->perm[i] = perm[i];
+        st->batch_size = h.batch_size;
+        st->loss = (LossType)h.loss;
+        st->opt->t = h.t;
+        st->epoch = h.epoch;
+        st->pos = h.pos;
+        st->step = h.step;
+        st->rng.s = h.rng;
+        st->opt->params.lr = h.params[0];
+        st->opt->params.momentum = h.params[1];
+        st->opt->params.beta1 = h.params[2];
+        st->opt->params.beta2 = h.params[3];
+        st->opt->params.epsilon = h.params[4];
+    }
+
+    free(perm);
+    free(seen);
+    return ok ? 0 : -1;
+}
+
+
+// Background writer
+
+typedef struct {
+    char* data;
+    size_t len, cap;
+} Snapshot;
+
+struct Checkpointer {
+    char* path;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    Snapshot* pending;   // newest snapshot not yet picked up by the writer
+    Snapshot* spare;     // recycled buffer, so steady state does not allocate
+    int stop;
+    int failures;
+};
+
+static void* writer_main(void* arg) {
+    Checkpointer* c = arg;
+
+    pthread_mutex_lock(&c->lock);
+    for (;;) {
+        while (!c->pending && !c->stop) pthread_cond_wait(&c->ready, &c->lock);
+        if (!c->pending) break;
+
+        Snapshot* snap = c->pending;
+        c->pending = NULL;
+        pthread_mutex_unlock(&c->lock);
+
+        int rc = write_atomic(c->path, snap->data, snap->len);
+
+        pthread_mutex_lock(&c->lock);
+        if (rc != 0) c->failures++;
+        if (!c->spare) {
+            c->spare = snap;
+        } else {
+            free(snap->data);
+            free(snap);
+        }
+    }
+    pthread_mutex_unlock(&c->lock);
+    return NULL;
+}
+
+Checkpointer* checkpointer_create(const char* path) {
+    Checkpointer* c = calloc(1, sizeof(Checkpointer));
+    c->path = malloc(strlen(path) + 1);
+    strcpy(c->path, path);
+    pthread_mutex_init(&c->lock, NULL);
+    pthread_cond_init(&c->ready, NULL);
+    if (pthread_create(&c->thread, NULL, writer_main, c) != 0) {
+        perror("Thread error");
+        pthread_mutex_destroy(&c->lock);
+        pthread_cond_destroy(&c->ready);
+        free(c->path);
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+void checkpointer_submit(Checkpointer* c, const TrainState* st) {
+    // Take a buffer: a still-pending snapshot is stale now, so overwrite it
+    pthread_mutex_lock(&c->lock);
+    Snapshot* snap = c->pending ? c->pending : c->spare;
+    if (snap == c->pending) c->pending = NULL;
+    else c->spare = NULL;
+    pthread_mutex_unlock(&c->lock);
+
+    if (!snap) snap = calloc(1, sizeof(Snapshot));
+    snap->len = checkpoint_size(st);
+    if (snap->cap < snap->len) {
+        free(snap->data);
+        snap->data = malloc(snap->len);
+        snap->cap = snap->len;
+    }
+    checkpoint_serialize(st, snap->data);
+
+    pthread_mutex_lock(&c->lock);
+    c->pending = snap;
+    pthread_cond_signal(&c->ready);
+    pthread_mutex_unlock(&c->lock);
+}
+
+int checkpointer_destroy(Checkpointer* c) {
+    if (!c) return 0;
+
+    pthread_mutex_lock(&c->lock);
+    c->stop = 1;
+    pthread_cond_signal(&c->ready);
+    pthread_mutex_unlock(&c->lock);
+    pthread_join(c->thread, NULL);
+
+    int failures = c->failures;
+    if (c->spare) {
+        free(c->spare->data);
+        free(c->spare);
+    }
+    pthread_mutex_destroy(&c->lock);
+    pthread_cond_destroy(&c->ready);
+    free(c->path);
+    free(c);
+    return failures ? -1 : 0;
+}
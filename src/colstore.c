@@ -0,0 +1,413 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/colstore.h"
+#include "../include/prof.h"
+
+// Half precision
+
+// Round to nearest even, overflow to infinity (F. Giesen's float_to_half_fast3_rtne)
+static uint16_t half_from_double(double v) {
+    float f = (float)v;
+    uint32_t u;
+    memcpy(&u, &f, sizeof(u));
+    uint32_t sign = u & 0x80000000u;
+    u ^= sign;
+
+    uint16_t h;
+    if (u >= 0x47800000u) {                 // >= 65536: infinity, or NaN
+        h = u > 0x7f800000u ? 0x7e00 : 0x7c00;
+    } else if (u < 0x38800000u) {           // below 2^-14: subnormal half, rounded by an add
+        float t;
+        memcpy(&t, &u, sizeof(t));
+        t += 0.5f;
+        memcpy(&u, &t, sizeof(u));
+        h = (uint16_t)(u - 0x3f000000u);
+    } else {
+        uint32_t odd = (u >> 13) & 1;
+        u += 0xc8000fffu + odd;             // rebias the exponent, round half to even
+        h = (uint16_t)(u >> 13);
+    }
+    return h | (uint16_t)(sign >> 16);
+}
+
+// Finite halves only (the encoder never stores infinities): shift into a float and
+// rescale the exponent, which also handles subnormals
+static inline float half_to_float(uint16_t h) {
+    uint32_t u = (uint32_t)(h & 0x7fff) << 13;
+    float f;
+    memcpy(&f, &u, sizeof(f));
+    f *= 0x1p112f;
+    memcpy(&u, &f, sizeof(u));
+    u |= (uint32_t)(h & 0x8000) << 16;
+    memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+
+// Encoding
+
+const char* col_encoding_name(ColEncoding enc) {
+    switch (enc) {
+        case COL_F64: return "f64";
+        case COL_F16: return "f16";
+        case COL_I8: return "i8";
+        case COL_DICT: return "dict";
+        default: return "auto";
+    }
+}
+
+// Codes are padded with zeros to whole tiles so the kernel loops have a fixed trip count
+static size_t padded_rows(int n) {
+    size_t tiles = n > 0 ? ((size_t)n + COLSTORE_TILE_ROWS - 1) / COLSTORE_TILE_ROWS : 1;
+    return tiles * COLSTORE_TILE_ROWS;
+}
+
+static double column_get(const Dataset* data, int i, int j) {
+    return data->X[i][j];
+}
+
+// Distinct values of column j in order of appearance; -1 if more than COLSTORE_DICT_MAX
+static int collect_distinct(const Dataset* data, int j, double* values) {
+    // Open addressing on the bit pattern, 4x oversized so probes stay short
+    enum { SLOTS = 4 * COLSTORE_DICT_MAX };
+    int slot[SLOTS];
+    memset(slot, -1, sizeof(slot));
+    int count = 0;
+    for (int i = 0; i < data->n; i++) {
+        double v = column_get(data, i, j);
+        uint64_t bits;
+        memcpy(&bits, &v, sizeof(bits));
+        uint64_t h = bits * 0x9e3779b97f4a7c15ULL;
+        int s = (int)(h >> 54) & (SLOTS - 1);
+        while (slot[s] >= 0 && memcmp(&values[slot[s]], &v, sizeof(v)) != 0) s = (s + 1) & (SLOTS - 1);
+        if (slot[s] >= 0) continue;
+        if (count == COLSTORE_DICT_MAX) return -1;
+        values[count] = v;
+        slot[s] = count++;
+    }
+    return count;
+}
+
+static int encode_dict(EncodedColumn* col, const Dataset* data, int j, const double* values, int count) {
+    uint8_t* q = calloc(padded_rows(data->n), 1);
+    col->dict = malloc(count * sizeof(double));
+    if (!q || !col->dict) {
+        free(q);
+        return -1;
+    }
+    memcpy(col->dict, values, count * sizeof(double));
+    col->dict_size = count;
+    for (int i = 0; i < data->n; i++) {
+        double v = column_get(data, i, j);
+        int k = 0;
+        while (memcmp(&col->dict[k], &v, sizeof(v)) != 0) k++;
+        q[i] = (uint8_t)k;
+    }
+    col->enc = COL_DICT;
+    col->codes = q;
+    col->max_error = 0.0;
+    return 0;
+}
+
+// Error the grid would have, without encoding
+static double i8_error(const Dataset* data, int j, double* lo_out, double* scale_out) {
+    double lo = INFINITY, hi = -INFINITY;
+    for (int i = 0; i < data->n; i++) {
+        double v = column_get(data, i, j);
+        lo = fmin(lo, v);
+        hi = fmax(hi, v);
+    }
+    double scale = hi > lo ? (hi - lo) / 255.0 : 0.0;
+    double err = 0.0;
+    for (int i = 0; i < data->n && scale > 0.0; i++) {
+        double v = column_get(data, i, j);
+        double q = round((v - lo) / scale);
+        err = fmax(err, fabs(lo + scale * q - v));
+    }
+    *lo_out = lo;
+    *scale_out = scale;
+    return err;
+}
+
+static int encode_i8(EncodedColumn* col, const Dataset* data, int j) {
+    double lo, scale;
+    col->max_error = i8_error(data, j, &lo, &scale);
+    uint8_t* q = calloc(padded_rows(data->n), 1);
+    if (!q) return -1;
+    for (int i = 0; i < data->n; i++) {
+        double c = scale > 0.0 ? round((column_get(data, i, j) - lo) / scale) : 0.0;
+        q[i] = (uint8_t)(c < 0 ? 0 : c > 255 ? 255 : c);
+    }
+    col->enc = COL_I8;
+    col->codes = q;
+    col->offset = lo;
+    col->scale = scale;
+    return 0;
+}
+
+static double f16_error(const Dataset* data, int j) {
+    double err = 0.0;
+    for (int i = 0; i < data->n; i++) {
+        double v = column_get(data, i, j);
+        uint16_t h = half_from_double(v);
+        if ((h & 0x7c00) == 0x7c00) return INFINITY;
+        err = fmax(err, fabs((double)half_to_float(h) - v));
+    }
+    return err;
+}
+
+static int encode_f64(EncodedColumn* col, const Dataset* data, int j);
+
+// Values outside the half range would be stored as infinities; such columns stay f64
+static int encode_f16(EncodedColumn* col, const Dataset* data, int j) {
+    col->max_error = f16_error(data, j);
+    if (isinf(col->max_error)) return encode_f64(col, data, j);
+    uint16_t* h = calloc(padded_rows(data->n), sizeof(uint16_t));
+    if (!h) return -1;
+    for (int i = 0; i < data->n; i++) h[i] = half_from_double(column_get(data, i, j));
+    col->enc = COL_F16;
+    col->codes = h;
+    return 0;
+}
+
+static int encode_f64(EncodedColumn* col, const Dataset* data, int j) {
+    double* x = calloc(padded_rows(data->n), sizeof(double));
+    if (!x) return -1;
+    for (int i = 0; i < data->n; i++) x[i] = column_get(data, i, j);
+    col->enc = COL_F64;
+    col->codes = x;
+    col->max_error = 0.0;
+    return 0;
+}
+
+static int encode_column(EncodedColumn* col, const Dataset* data, int j, ColEncoding enc, double tol) {
+    double values[COLSTORE_DICT_MAX];
+    if (enc == COL_AUTO || enc == COL_DICT) {
+        int count = collect_distinct(data, j, values);
+        if (count >= 0) return encode_dict(col, data, j, values, count);
+        if (enc == COL_DICT) return encode_f64(col, data, j);
+    }
+    if (enc == COL_AUTO) {
+        double lo, scale;
+        if (i8_error(data, j, &lo, &scale) <= tol) return encode_i8(col, data, j);
+        if (f16_error(data, j) <= tol) return encode_f16(col, data, j);
+        return encode_f64(col, data, j);
+    }
+    if (enc == COL_I8) return encode_i8(col, data, j);
+    if (enc == COL_F16) return encode_f16(col, data, j);
+    return encode_f64(col, data, j);
+}
+
+ColumnStore* colstore_encode(const Dataset* data, const ColEncoding* encodings, double tol) {
+    PROF_BEGIN("colstore_encode");
+    ColumnStore* cs = calloc(1, sizeof(ColumnStore));
+    if (!cs) {
+        PROF_END();
+        return NULL;
+    }
+    cs->n = data->n;
+    cs->d = data->d;
+    cs->cols = calloc(data->d, sizeof(EncodedColumn));
+    cs->y = malloc(data->n > 0 ? data->n * sizeof(double) : sizeof(double));
+    if (!cs->cols || !cs->y) {
+        colstore_free(cs);
+        PROF_END();
+        return NULL;
+    }
+    memcpy(cs->y, data->y, data->n * sizeof(double));
+
+    for (int j = 0; j < data->d; j++) {
+        if (encode_column(&cs->cols[j], data, j, encodings ? encodings[j] : COL_AUTO, tol) != 0) {
+            fprintf(stderr, "colstore_encode: out of memory at column %d\n", j);
+            colstore_free(cs);
+            PROF_END();
+            return NULL;
+        }
+    }
+    PROF_END();
+    return cs;
+}
+
+void colstore_free(ColumnStore* cs) {
+    if (!cs) return;
+    if (cs->cols) {
+        for (int j = 0; j < cs->d; j++) {
+            free(cs->cols[j].codes);
+            free(cs->cols[j].dict);
+        }
+    }
+    free(cs->cols);
+    free(cs->y);
+    free(cs);
+}
+
+size_t colstore_bytes(const ColumnStore* cs) {
+    size_t bytes = (size_t)cs->n * sizeof(double);
+    for (int j = 0; j < cs->d; j++) {
+        const EncodedColumn* col = &cs->cols[j];
+        size_t width = col->enc == COL_F64 ? 8 : col->enc == COL_F16 ? 2 : 1;
+        bytes += (size_t)cs->n * width + col->dict_size * sizeof(double);
+    }
+    return bytes;
+}
+
+double colstore_value(const ColumnStore* cs, int row, int col) {
+    const EncodedColumn* c = &cs->cols[col];
+    switch (c->enc) {
+        case COL_F16: return half_to_float(((const uint16_t*)c->codes)[row]);
+        case COL_I8: return c->offset + c->scale * ((const uint8_t*)c->codes)[row];
+        case COL_DICT: return c->dict[((const uint8_t*)c->codes)[row]];
+        default: return ((const double*)c->codes)[row];
+    }
+}
+
+void colstore_row(const ColumnStore* cs, int row, double* x_out) {
+    for (int j = 0; j < cs->d; j++) x_out[j] = colstore_value(cs, row, j);
+}
+
+
+// Kernels
+
+#define TILE COLSTORE_TILE_ROWS
+#define LANES 8     // independent partial sums, so the dot products vectorize without reassociation
+
+// z[0..TILE) += w * column[r0 .. r0 + TILE), decoded in the loop; wd is the dictionary times w
+static void add_column(const EncodedColumn* col, int r0, double w, const double* wd, double* restrict z) {
+    switch (col->enc) {
+        case COL_F16: {
+            const uint16_t* restrict h = (const uint16_t*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) z[r] += w * half_to_float(h[r]);
+            break;
+        }
+        case COL_I8: {
+            const uint8_t* restrict q = (const uint8_t*)col->codes + r0;
+            double a = w * col->scale, b = w * col->offset;
+            for (int r = 0; r < TILE; r++) z[r] += a * q[r] + b;
+            break;
+        }
+        case COL_DICT: {
+            const uint8_t* restrict q = (const uint8_t*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) z[r] += wd[q[r]];
+            break;
+        }
+        default: {
+            const double* restrict x = (const double*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) z[r] += w * x[r];
+        }
+    }
+}
+
+// Sum over the tile of e * column value. The products are formed elementwise (decode
+// and multiply vectorize like add_column), then summed in LANES independent partial sums;
+// I8 leaves out scale and offset, applied once per pass
+static double dot_column(const EncodedColumn* col, int r0, const double* restrict e, double* restrict prod) {
+    switch (col->enc) {
+        case COL_F16: {
+            const uint16_t* restrict h = (const uint16_t*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) prod[r] = e[r] * half_to_float(h[r]);
+            break;
+        }
+        case COL_I8: {
+            const uint8_t* restrict q = (const uint8_t*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) prod[r] = e[r] * q[r];
+            break;
+        }
+        case COL_DICT: {
+            const uint8_t* restrict q = (const uint8_t*)col->codes + r0;
+            const double* dict = col->dict;
+            for (int r = 0; r < TILE; r++) prod[r] = e[r] * dict[q[r]];
+            break;
+        }
+        default: {
+            const double* restrict x = (const double*)col->codes + r0;
+            for (int r = 0; r < TILE; r++) prod[r] = e[r] * x[r];
+        }
+    }
+    double s[LANES] = { 0 };
+    for (int r = 0; r < TILE; r += LANES)
+        for (int l = 0; l < LANES; l++) s[l] += prod[r + l];
+    return ((s[0] + s[1]) + (s[2] + s[3])) + ((s[4] + s[5]) + (s[6] + s[7]));
+}
+
+// One pass over the tiles; the loss term (a log per row) is skipped when only the gradient is wanted
+static double store_pass(const ColumnStore* cs, LossType loss, const double* w, double* grad_out, int with_loss) {
+    PROF_BEGIN("colstore_loss_grad");
+    int n = cs->n, d = cs->d;
+    double z[TILE], prod[TILE];
+
+    // w_j times each dictionary entry, for dictionary columns
+    int dict_total = 0;
+    for (int j = 0; j < d; j++) dict_total += cs->cols[j].dict_size;
+    double* wd = malloc((dict_total > 0 ? dict_total : 1) * sizeof(double));
+    int* dict_off = malloc((d > 0 ? d : 1) * sizeof(int));
+    if (!wd || !dict_off) {
+        fprintf(stderr, "colstore_loss_grad: out of memory\n");
+        free(wd);
+        free(dict_off);
+        PROF_END();
+        return -1;
+    }
+    for (int j = 0, off = 0; j < d; j++) {
+        dict_off[j] = off;
+        for (int k = 0; k < cs->cols[j].dict_size; k++) wd[off + k] = w[j] * cs->cols[j].dict[k];
+        off += cs->cols[j].dict_size;
+    }
+    if (grad_out) memset(grad_out, 0, d * sizeof(double));
+
+    double total = 0.0, e_sum = 0.0;
+    for (int r0 = 0; r0 < n; r0 += TILE) {
+        int R = n - r0 < TILE ? n - r0 : TILE;
+        memset(z, 0, sizeof(z));
+        for (int j = 0; j < d; j++) add_column(&cs->cols[j], r0, w[j], wd + dict_off[j], z);
+
+        // z becomes the loss derivative e in place; padding rows get e = 0
+        const double* y = cs->y + r0;
+        for (int r = 0; r < R; r++) {
+            if (with_loss) total += sample_loss(loss, z[r], y[r]);
+            z[r] = sample_dloss(loss, z[r], y[r]);
+            e_sum += z[r];
+        }
+        if (!grad_out) continue;
+        for (int r = R; r < TILE; r++) z[r] = 0.0;
+        for (int j = 0; j < d; j++) grad_out[j] += dot_column(&cs->cols[j], r0, z, prod);
+    }
+
+    if (grad_out) {
+        for (int j = 0; j < d; j++) {
+            const EncodedColumn* col = &cs->cols[j];
+            if (col->enc == COL_I8) grad_out[j] = col->scale * grad_out[j] + col->offset * e_sum;
+            grad_out[j] /= n;
+        }
+    }
+    free(wd);
+    free(dict_off);
+    PROF_END();
+    return total / n;
+}
+
+double colstore_loss_grad(const ColumnStore* cs, LossType loss, const double* w, double* grad_out) {
+    return store_pass(cs, loss, w, grad_out, 1);
+}
+
+
+// Objectives for the FuncPtrND optimizers
+
+static const ColumnStore* g_store = NULL;
+static LossType g_store_loss = LOSS_MSE;
+
+void set_column_store(const ColumnStore* cs, LossType loss) {
+    g_store = cs;
+    g_store_loss = loss;
+}
+
+double compressed_loss(double* w, int dim) {
+    if (!g_store || dim != g_store->d) return -1;
+    return colstore_loss_grad(g_store, g_store_loss, w, NULL);
+}
+
+void compressed_grad(double* w, double* grad_out, int dim) {
+    if (!g_store || dim != g_store->d) return;
+    store_pass(g_store, g_store_loss, w, grad_out, 0);
+}
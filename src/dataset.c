@@ -5,6 +5,9 @@
 #include <math.h>
 #include <time.h>
 #include "../include/dataset.h"
+#include "../include/stats.h"
+#include "../include/hashing.h"
+#include "../include/prof.h"
 
 
 
@@ -15,6 +18,7 @@ Dataset* load_csv(const char* filename, int features) {
         return NULL;
     }
 
+    PROF_BEGIN("load_csv");
     int cap = 100;
     double** X = malloc(cap * sizeof(double*));
     double* y = malloc(cap * sizeof(double));
@@ -54,45 +58,220 @@ Dataset* load_csv(const char* filename, int features) {
 
     fclose(f);
 
-    Dataset* data = malloc(sizeof(Dataset));
+    Dataset* data = calloc(1, sizeof(Dataset));
     data->X = X;
     data->y = y;
     data->n = n;
     data->d = features + 1;
+    PROF_END();
     return data;
 }
 
 
+// Label dictionary
+
+LabelDict* label_dict_create(void) {
+    LabelDict* dict = malloc(sizeof(LabelDict));
+    dict->num = 0;
+    dict->cap = 16;
+    dict->names = malloc(dict->cap * sizeof(char*));
+    dict->num_slots = 32;
+    dict->slots = calloc(dict->num_slots, sizeof(int));
+    return dict;
+}
+
+void label_dict_free(LabelDict* dict) {
+    if (!dict) return;
+    for (int i = 0; i < dict->num; i++) free(dict->names[i]);
+    free(dict->names);
+    free(dict->slots);
+    free(dict);
+}
+
+static int label_slot(const LabelDict* dict, const char* name) {
+    unsigned int mask = dict->num_slots - 1;
+    unsigned int s = hash_bytes(name, strlen(name), 0) & mask;
+    while (dict->slots[s] && strcmp(dict->names[dict->slots[s] - 1], name) != 0) s = (s + 1) & mask;
+    return s;
+}
+
+int label_dict_id(LabelDict* dict, const char* name, int insert) {
+    int s = label_slot(dict, name);
+    if (dict->slots[s]) return dict->slots[s] - 1;
+    if (!insert) return -1;
+
+    if (dict->num == dict->cap) {
+        dict->cap *= 2;
+        dict->names = realloc(dict->names, dict->cap * sizeof(char*));
+    }
+    int id = dict->num++;
+    dict->names[id] = strdup(name);
+    dict->slots[s] = id + 1;
+
+    // Keep the table at most half full
+    if (2 * dict->num > dict->num_slots) {
+        free(dict->slots);
+        dict->num_slots *= 2;
+        dict->slots = calloc(dict->num_slots, sizeof(int));
+        for (int i = 0; i < dict->num; i++) dict->slots[label_slot(dict, dict->names[i])] = i + 1;
+    }
+    return id;
+}
+
+const char* label_dict_name(const LabelDict* dict, int id) {
+    return id >= 0 && id < dict->num ? dict->names[id] : NULL;
+}
+
+// Strips surrounding whitespace and one pair of double quotes, in place
+static char* trim_label(char* s) {
+    while (isspace((unsigned char)*s)) s++;
+    char* end = s + strlen(s);
+    while (end > s && isspace((unsigned char)end[-1])) end--;
+    if (end - s >= 2 && *s == '"' && end[-1] == '"') {
+        s++;
+        end--;
+    }
+    *end = '\0';
+    return s;
+}
+
+// Ends the field starting at s at its delimiter, skipping a comma inside double quotes
+static char* cut_field(char* s) {
+    char* p = s;
+    while (isspace((unsigned char)*p)) p++;
+    if (*p == '"') {
+        char* close = strchr(p + 1, '"');
+        if (close) p = close + 1;
+    }
+    p[strcspn(p, ",")] = '\0';
+    return s;
+}
+
+Dataset* load_csv_dataset(const char* filename, int feature_count, int has_header, LabelDict* labels) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("File error");
+        return NULL;
+    }
+
+    PROF_BEGIN("load_csv_dataset");
+    int cap = 1024, n = 0, skipped = 0;
+    double** X = malloc(cap * sizeof(double*));
+    double* y = malloc(cap * sizeof(double));
+    char* line = NULL;
+    size_t line_cap = 0;
+
+    while (getline(&line, &line_cap, f) != -1) {
+        if (has_header) {
+            has_header = 0;
+            continue;
+        }
+        line[strcspn(line, "\r\n")] = '\0';
+        if (!*line) continue;
+
+        double* x = malloc((feature_count + 1) * sizeof(double));
+        x[0] = 1.0;
+        char* p = line;
+        int ok = 1;
+        for (int j = 0; ok && j < feature_count; j++) {
+            char* end;
+            x[j + 1] = strtod(p, &end);
+            ok = end != p && *end == ',';
+            p = end + 1;
+        }
+
+        double target = 0.0;
+        if (ok) {
+            char* label = trim_label(cut_field(p));
+            if (labels) {
+                ok = *label != '\0';
+                if (ok) target = label_dict_id(labels, label, 1);
+            } else {
+                char* end;
+                target = strtod(label, &end);
+                ok = end != label;
+            }
+        }
+        if (!ok) {
+            free(x);
+            skipped++;
+            continue;
+        }
+
+        if (n == cap) {
+            cap *= 2;
+            X = realloc(X, cap * sizeof(double*));
+            y = realloc(y, cap * sizeof(double));
+        }
+        X[n] = x;
+        y[n++] = target;
+    }
+
+    free(line);
+    fclose(f);
+    if (skipped) fprintf(stderr, "%s: skipped %d malformed line%s\n", filename, skipped, skipped == 1 ? "" : "s");
+
+    Dataset* data = calloc(1, sizeof(Dataset));
+    data->X = X;
+    data->y = y;
+    data->n = n;
+    data->d = feature_count + 1;
+    PROF_END();
+    return data;
+}
+
 void normalize_features(Dataset* data) {
-    for (int j = 1; j < data->d; j++) {
-        double mean = 0, std = 0;
-        for (int i = 0; i < data->n; i++) mean += data->X[i][j];
-        mean /= data->n;
-        for (int i = 0; i < data->n; i++) std += pow(data->X[i][j] - mean, 2);
-        std = sqrt(std / data->n);
+    PROF_BEGIN("normalize_features");
+    transform_free(standardize_dataset(data, NULL));
+    PROF_END();
+}
 
-        for (int i = 0; i < data->n; i++)
-            data->X[i][j] = (data->X[i][j] - mean) / (std + 1e-8);
+Dataset* create_dataset(int n, int d) {
+    Dataset* data = calloc(1, sizeof(Dataset));
+    if (!data) return NULL;
+    data->d = d;
+    data->X = calloc(n > 0 ? n : 1, sizeof(double*));
+    data->y = calloc(n > 0 ? n : 1, sizeof(double));
+    if (!data->X || !data->y) {
+        free_dataset(data);
+        return NULL;
+    }
+    for (; data->n < n; data->n++) {
+        data->X[data->n] = calloc(d, sizeof(double));
+        if (!data->X[data->n]) {
+            free_dataset(data);
+            return NULL;
+        }
     }
+    return data;
 }
 
 void free_dataset(Dataset* data) {
     if (!data) return;
-    for (int i = 0; i < data->n; i++) free(data->X[i]);
+    for (int i = 0; i < data->n && data->X; i++) free(data->X[i]);
     free(data->X);
     free(data->y);
+    free(data->Y);
     free(data);
 }
 
+int dataset_set_targets(Dataset* data, int m, const double* Y) {
+    double* copy = NULL;
+    if (m > 0) {
+        copy = malloc((size_t)data->n * m * sizeof(double));
+        if (!copy) return -1;
+        memcpy(copy, Y, (size_t)data->n * m * sizeof(double));
+    }
+    free(data->Y);
+    data->m = m > 0 ? m : 0;
+    data->Y = copy;
+    return 0;
+}
+
 
 // Hardcoded simple dataset (for demo)
 Dataset* create_sample_dataset() {
-    Dataset* data = (Dataset*)malloc(sizeof(Dataset));
-    data->n = 8;
-    data->d = 2; // bias + 1 feature
-
-    data->X = (double**)malloc(data->n * sizeof(double*));
-    data->y = (double*)malloc(data->n * sizeof(double));
+    Dataset* data = create_dataset(8, 2); // bias + 1 feature
 
     double raw_X[8][2] = {
         {1.0, 1.0}, {1.0, 2.0}, {1.0, 1.5}, {1.0, 0.5},
@@ -102,7 +281,6 @@ Dataset* create_sample_dataset() {
     double raw_y[8] = {0, 0, 0, 0, 1, 1, 1, 1};
 
     for (int i = 0; i < data->n; i++) {
-        data->X[i] = (double*)malloc(data->d * sizeof(double));
         for (int j = 0; j < data->d; j++) {
             data->X[i][j] = raw_X[i][j];
         }
@@ -115,12 +293,7 @@ Dataset* create_sample_dataset() {
 /*
 // Dataset with bias
 Dataset* create_sample_dataset() {
-    Dataset* data = (Dataset*)malloc(sizeof(Dataset));
-    data->n = 12;
-    data->d = 3; // bias + x1 + x2
-
-    data->X = (double**)malloc(data->n * sizeof(double*));
-    data->y = (double*)malloc(data->n * sizeof(double));
+    Dataset* data = create_dataset(12, 3); // bias + x1 + x2
 
     // Format: {bias, x1, x2}
     double raw_X[12][3] = {
@@ -144,7 +317,6 @@ Dataset* create_sample_dataset() {
     };
 
     for (int i = 0; i < data->n; i++) {
-        data->X[i] = (double*)malloc(data->d * sizeof(double));
         for (int j = 0; j < data->d; j++) {
             data->X[i][j] = raw_X[i][j];
         }
@@ -159,6 +331,7 @@ void train_test_split(Dataset* full, Dataset** train_out, Dataset** test_out, do
     int total = full->n;
     int test_size = (int)(total * test_ratio);
     int train_size = total - test_size;
+    PROF_BEGIN("train_test_split");
 
     // Randomly shuffle indices
     int* indices = malloc(total * sizeof(int));
@@ -172,32 +345,103 @@ void train_test_split(Dataset* full, Dataset** train_out, Dataset** test_out, do
     }
 
     // Allocate train
-    Dataset* train = malloc(sizeof(Dataset));
-    train->n = train_size;
-    train->d = full->d;
-    train->X = malloc(train_size * sizeof(double*));
-    train->y = malloc(train_size * sizeof(double));
+    Dataset* train = create_dataset(train_size, full->d);
+    train->m = full->m;
+    train->Y = full->m > 0 ? malloc((size_t)train_size * full->m * sizeof(double)) : NULL;
     for (int i = 0; i < train_size; i++) {
         int idx = indices[i];
-        train->X[i] = malloc(full->d * sizeof(double));
         for (int j = 0; j < full->d; j++) train->X[i][j] = full->X[idx][j];
+        if (full->m > 0) memcpy(train->Y + (size_t)i * full->m, full->Y + (size_t)idx * full->m, full->m * sizeof(double));
         train->y[i] = full->y[idx];
     }
 
     // Allocate test
-    Dataset* test = malloc(sizeof(Dataset));
-    test->n = test_size;
-    test->d = full->d;
-    test->X = malloc(test_size * sizeof(double*));
-    test->y = malloc(test_size * sizeof(double));
+    Dataset* test = create_dataset(test_size, full->d);
+    test->m = full->m;
+    test->Y = full->m > 0 ? malloc((size_t)test_size * full->m * sizeof(double)) : NULL;
     for (int i = 0; i < test_size; i++) {
         int idx = indices[i + train_size];
-        test->X[i] = malloc(full->d * sizeof(double));
         for (int j = 0; j < full->d; j++) test->X[i][j] = full->X[idx][j];
+        if (full->m > 0) memcpy(test->Y + (size_t)i * full->m, full->Y + (size_t)idx * full->m, full->m * sizeof(double));
         test->y[i] = full->y[idx];
     }
 
     free(indices);
     *train_out = train;
     *test_out = test;
+    PROF_END();
+}
+
+
+// Sparse (CSR) datasets
+
+SparseDataset* create_sparse_dataset(int n, int d, int nnz) {
+    SparseDataset* data = malloc(sizeof(SparseDataset));
+    data->n = n;
+    data->d = d;
+    data->row_ptr = calloc(n + 1, sizeof(int));
+    data->idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    data->val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+    data->y = calloc(n > 0 ? n : 1, sizeof(double));
+    return data;
+}
+
+SparseDataset* dense_to_sparse(const Dataset* data) {
+    int nnz = 0;
+    for (int i = 0; i < data->n; i++)
+        for (int j = 0; j < data->d; j++)
+            if (data->X[i][j] != 0.0) nnz++;
+
+    SparseDataset* sp = create_sparse_dataset(data->n, data->d, nnz);
+    int k = 0;
+    for (int i = 0; i < data->n; i++) {
+        sp->row_ptr[i] = k;
+        for (int j = 0; j < data->d; j++) {
+            if (data->X[i][j] != 0.0) {
+                sp->idx[k] = j;
+                sp->val[k] = data->X[i][j];
+                k++;
+            }
+        }
+        sp->y[i] = data->y[i];
+    }
+    sp->row_ptr[data->n] = k;
+    return sp;
+}
+
+void free_sparse_dataset(SparseDataset* data) {
+    if (!data) return;
+    free(data->row_ptr);
+    free(data->idx);
+    free(data->val);
+    free(data->y);
+    free(data);
+}
+
+
+// Column-major datasets
+
+ColumnDataset* create_column_dataset(int n, int d) {
+    ColumnDataset* data = malloc(sizeof(ColumnDataset));
+    data->n = n;
+    data->d = d;
+    data->cols = calloc((size_t)n * d > 0 ? (size_t)n * d : 1, sizeof(double));
+    data->y = calloc(n > 0 ? n : 1, sizeof(double));
+    return data;
+}
+
+ColumnDataset* dense_to_columns(const Dataset* data) {
+    ColumnDataset* cd = create_column_dataset(data->n, data->d);
+    for (int i = 0; i < data->n; i++) {
+        for (int j = 0; j < data->d; j++) cd->cols[(size_t)j * data->n + i] = data->X[i][j];
+        cd->y[i] = data->y[i];
+    }
+    return cd;
+}
+
+void free_column_dataset(ColumnDataset* data) {
+    if (!data) return;
+    free(data->cols);
+    free(data->y);
+    free(data);
 }
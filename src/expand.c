@@ -0,0 +1,225 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "../include/expand.h"
+#include "../include/rng.h"
+#include "../include/prof.h"
+
+FeatureExpansion* expand_poly2(int d) {
+    long long p = d - 1;
+    long long D = d + p * (p + 1) / 2;
+    if (d < 1 || D > INT_MAX) {
+        fprintf(stderr, "expand_poly2: %lld expanded features do not fit an int\n", D);
+        return NULL;
+    }
+
+    FeatureExpansion* e = calloc(1, sizeof(FeatureExpansion));
+    e->type = EXPAND_POLY2;
+    e->d = d;
+    e->D = (int)D;
+    e->pair_start = malloc((p + 2) * sizeof(long long));
+    e->pair_start[0] = 0;
+    e->pair_start[1] = 0;
+    for (long long i = 1; i <= p; i++) e->pair_start[i + 1] = e->pair_start[i] + (p - i + 1);
+    return e;
+}
+
+static double normal(Rng* rng) {
+    double u = rng_uniform(rng), v = rng_uniform(rng);
+    return sqrt(-2.0 * log(1.0 - u)) * cos(2.0 * M_PI * v);
+}
+
+FeatureExpansion* expand_rff(int d, int num_features, double gamma, unsigned long long seed) {
+    int p = d - 1;
+    FeatureExpansion* e = calloc(1, sizeof(FeatureExpansion));
+    e->type = EXPAND_RFF;
+    e->d = d;
+    e->D = 1 + num_features;
+    e->m = num_features;
+    e->omega = malloc((size_t)num_features * (p > 0 ? p : 1) * sizeof(double));
+    e->phase = malloc(num_features * sizeof(double));
+    e->amp = sqrt(2.0 / num_features);
+
+    Rng rng;
+    rng_seed(&rng, seed);
+    double sd = sqrt(2.0 * gamma);
+    for (int k = 0; k < num_features; k++) {
+        for (int j = 0; j < p; j++) e->omega[(size_t)k * p + j] = sd * normal(&rng);
+        e->phase[k] = 2.0 * M_PI * rng_uniform(&rng);
+    }
+    return e;
+}
+
+void expand_free(FeatureExpansion* e) {
+    if (!e) return;
+    free(e->pair_start);
+    free(e->omega);
+    free(e->phase);
+    free(e);
+}
+
+
+// Tile generation: tile[r * EXPAND_TILE_COLS + k] = phi(X[r])[start + k] for r < R, k < len
+
+static void fill_poly2(const FeatureExpansion* e, double* const* X, int R, int start, int len, double* tile) {
+    int d = e->d, p = d - 1;
+    int k = 0;
+
+    // Linear part
+    for (; k < len && start + k < d; k++)
+        for (int r = 0; r < R; r++) tile[r * EXPAND_TILE_COLS + k] = X[r][start + k];
+    if (k == len) return;
+
+    // Pairs: walk the upper triangle one contiguous run x_i * x[j0 .. j1) at a time
+    long long q = (long long)start + k - d;
+    int lo = 1, hi = p;
+    while (lo < hi) {       // last i with pair_start[i] <= q
+        int mid = (lo + hi + 1) / 2;
+        if (e->pair_start[mid] <= q) lo = mid;
+        else hi = mid - 1;
+    }
+    int i = lo;
+    int j = i + (int)(q - e->pair_start[i]);
+
+    while (k < len) {
+        int run = p + 1 - j;
+        if (run > len - k) run = len - k;
+        for (int r = 0; r < R; r++) {
+            const double* x = X[r];
+            double xi = x[i];
+            double* out = tile + r * EXPAND_TILE_COLS + k;
+            for (int t = 0; t < run; t++) out[t] = xi * x[j + t];
+        }
+        k += run;
+        i++;
+        j = i;
+    }
+}
+
+static void fill_rff(const FeatureExpansion* e, double* const* X, int R, int start, int len, double* tile) {
+    int p = e->d - 1;
+    for (int k = 0; k < len; k++) {
+        int f = start + k;
+        if (f == 0) {
+            for (int r = 0; r < R; r++) tile[r * EXPAND_TILE_COLS + k] = 1.0;
+            continue;
+        }
+        const double* om = e->omega + (size_t)(f - 1) * p;
+        double b = e->phase[f - 1];
+        for (int r = 0; r < R; r++) {
+            const double* x = X[r] + 1;
+            double s = b;
+            for (int j = 0; j < p; j++) s += om[j] * x[j];
+            tile[r * EXPAND_TILE_COLS + k] = e->amp * cos(s);
+        }
+    }
+}
+
+static void fill_tile(const FeatureExpansion* e, double* const* X, int R, int start, int len, double* tile) {
+    if (e->type == EXPAND_POLY2) fill_poly2(e, X, R, start, len, tile);
+    else fill_rff(e, X, R, start, len, tile);
+}
+
+void expand_row(const FeatureExpansion* e, const double* x, double* phi_out) {
+    double* tile = malloc(EXPAND_TILE_COLS * sizeof(double));
+    double* const rows[1] = { (double*)x };
+    for (int c0 = 0; c0 < e->D; c0 += EXPAND_TILE_COLS) {
+        int len = e->D - c0 < EXPAND_TILE_COLS ? e->D - c0 : EXPAND_TILE_COLS;
+        fill_tile(e, rows, 1, c0, len, tile);
+        memcpy(phi_out + c0, tile, len * sizeof(double));
+    }
+    free(tile);
+}
+
+
+// Kernels
+
+// z[r] = w . phi(X[r]) for one row tile; the last block is left in the tile
+static void tile_margins(const FeatureExpansion* e, double* const* X, int R, const double* w, double* tile, double* z) {
+    for (int r = 0; r < R; r++) z[r] = 0.0;
+    for (int c0 = 0; c0 < e->D; c0 += EXPAND_TILE_COLS) {
+        int len = e->D - c0 < EXPAND_TILE_COLS ? e->D - c0 : EXPAND_TILE_COLS;
+        fill_tile(e, X, R, c0, len, tile);
+        const double* wb = w + c0;
+        for (int r = 0; r < R; r++) {
+            const double* t = tile + r * EXPAND_TILE_COLS;
+            double s = 0.0;
+            for (int k = 0; k < len; k++) s += t[k] * wb[k];
+            z[r] += s;
+        }
+    }
+}
+
+void expand_margins(const FeatureExpansion* e, double* const* X, int n, const double* w, double* z_out) {
+    PROF_BEGIN("expand_margins");
+    double* tile = malloc(EXPAND_TILE_ROWS * EXPAND_TILE_COLS * sizeof(double));
+    for (int r0 = 0; r0 < n; r0 += EXPAND_TILE_ROWS) {
+        int R = n - r0 < EXPAND_TILE_ROWS ? n - r0 : EXPAND_TILE_ROWS;
+        tile_margins(e, X + r0, R, w, tile, z_out + r0);
+    }
+    free(tile);
+    PROF_END();
+}
+
+double expand_loss_grad(const FeatureExpansion* e, double* const* X, const double* y, int n,
+                        LossType loss, const double* w, double* grad_out) {
+    PROF_BEGIN("expand_loss_grad");
+    int D = e->D;
+    double* tile = malloc(EXPAND_TILE_ROWS * EXPAND_TILE_COLS * sizeof(double));
+    double z[EXPAND_TILE_ROWS], g[EXPAND_TILE_ROWS];
+    if (grad_out) memset(grad_out, 0, D * sizeof(double));
+
+    double total = 0.0;
+    for (int r0 = 0; r0 < n; r0 += EXPAND_TILE_ROWS) {
+        int R = n - r0 < EXPAND_TILE_ROWS ? n - r0 : EXPAND_TILE_ROWS;
+        tile_margins(e, X + r0, R, w, tile, z);
+        for (int r = 0; r < R; r++) {
+            total += sample_loss(loss, z[r], y[r0 + r]);
+            g[r] = sample_dloss(loss, z[r], y[r0 + r]) / n;
+        }
+        if (!grad_out) continue;
+
+        // Second sweep regenerates each block; a single block is still in the tile
+        for (int c0 = 0; c0 < D; c0 += EXPAND_TILE_COLS) {
+            int len = D - c0 < EXPAND_TILE_COLS ? D - c0 : EXPAND_TILE_COLS;
+            if (D > EXPAND_TILE_COLS) fill_tile(e, X + r0, R, c0, len, tile);
+            double* gb = grad_out + c0;
+            for (int r = 0; r < R; r++) {
+                const double* t = tile + r * EXPAND_TILE_COLS;
+                double gr = g[r];
+                for (int k = 0; k < len; k++) gb[k] += gr * t[k];
+            }
+        }
+    }
+
+    free(tile);
+    PROF_END();
+    return total / n;
+}
+
+
+// Global objective for FuncPtrND / GradPtrND optimizers
+
+static const FeatureExpansion* g_expansion = NULL;
+static const Dataset* g_expand_data = NULL;
+static LossType g_expand_loss = LOSS_MSE;
+
+void set_expansion(const FeatureExpansion* e, const Dataset* data, LossType loss) {
+    g_expansion = e;
+    g_expand_data = data;
+    g_expand_loss = loss;
+}
+
+double expanded_loss(double* w, int dim) {
+    if (!g_expansion || !g_expand_data || dim != g_expansion->D) return -1;
+    return expand_loss_grad(g_expansion, g_expand_data->X, g_expand_data->y, g_expand_data->n,
+                            g_expand_loss, w, NULL);
+}
+
+void expanded_grad(double* w, double* grad_out, int dim) {
+    if (!g_expansion || !g_expand_data || dim != g_expansion->D) return;
+    expand_loss_grad(g_expansion, g_expand_data->X, g_expand_data->y, g_expand_data->n,
+                     g_expand_loss, w, grad_out);
+}
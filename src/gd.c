@@ -2,6 +2,15 @@
 #include <math.h>
 #include <stdlib.h>
 #include "../include/gd.h"
+#include "../include/prof.h"
+
+static int g_verbose = 1;
+
+int gd_set_verbose(int verbose) {
+    int prev = g_verbose;
+    g_verbose = verbose;
+    return prev;
+}
 
 void gradient_descent(FuncPtr f, GradPtr grad, double* x0, double lr, int max_iters, double tol) {
     int i;
@@ -11,15 +20,15 @@ void gradient_descent(FuncPtr f, GradPtr grad, double* x0, double lr, int max_it
         *x0 = *x0 - lr * g;
 
         double diff = fabs(*x0 - prev_x);
-        printf("Iter %3d | x = %.6f | f(x) = %.6f | grad = %.6f\n", i+1, *x0, f(*x0), g);
+        if (g_verbose) printf("Iter %3d | x = %.6f | f(x) = %.6f | grad = %.6f\n", i+1, *x0, f(*x0), g);
 
         if (diff < tol) {
-            printf("Converged in %d iterations.\n", i+1);
+            if (g_verbose) printf("Converged in %d iterations.\n", i+1);
             break;
         }
     }
     if (i == max_iters) {
-        printf("Stopped after %d iterations (didn't converge).\n", max_iters);
+        if (g_verbose) printf("Stopped after %d iterations (didn't converge).\n", max_iters);
     }
 }
 
@@ -31,23 +40,25 @@ void gradient_descent_multi(FuncPtrND f, GradPtrND grad, double* x, int dim, dou
     for (i = 0; i < max_iters; i++) {
         grad(x, g, dim);
 
+        PROF_BEGIN("gd.update");
         double prev_sum = 0.0, new_sum = 0.0;
         for (int j = 0; j < dim; j++) {
             prev_sum += x[j] * x[j];
             x[j] = x[j] - lr * g[j];
             new_sum += x[j] * x[j];
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | grad_norm = %.6f\n", i + 1, f(x, dim), sqrt(new_sum));
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | grad_norm = %.6f\n", i + 1, f(x, dim), sqrt(new_sum));
 
         if (fabs(new_sum - prev_sum) < tol) {
-            printf("Converged in %d iterations.\n", i + 1);
+            if (g_verbose) printf("Converged in %d iterations.\n", i + 1);
             break;
         }
     }
 
     if (i == max_iters) {
-        printf("Did not converge within %d iterations.\n", max_iters);
+        if (g_verbose) printf("Did not converge within %d iterations.\n", max_iters);
     }
 
     free(g);
@@ -73,6 +84,7 @@ void gradient_descent_armijo(FuncPtrND f, GradPtrND grad, double* x, int dim, do
         double grad_norm2 = norm_squared(g, dim);
         double fx = f(x, dim);
 
+        PROF_BEGIN("armijo.line_search");
         double alpha = alpha_init;
         while (1) {
             for (int j = 0; j < dim; j++) {
@@ -86,6 +98,7 @@ void gradient_descent_armijo(FuncPtrND f, GradPtrND grad, double* x, int dim, do
             alpha *= beta;
             if (alpha < 1e-10) break; // Prevent getting stuck
         }
+        PROF_END();
 
         double diff = 0.0;
         for (int j = 0; j < dim; j++) {
@@ -93,16 +106,16 @@ void gradient_descent_armijo(FuncPtrND f, GradPtrND grad, double* x, int dim, do
             x[j] = x_new[j];
         }
 
-        printf("Iter %3d | f(x) = %.6f | alpha = %.6f\n", i + 1, f(x, dim), alpha);
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | alpha = %.6f\n", i + 1, f(x, dim), alpha);
 
         if (diff < tol) {
-            printf("Converged in %d iterations.\n", i + 1);
+            if (g_verbose) printf("Converged in %d iterations.\n", i + 1);
             break;
         }
     }
 
     if (i == max_iters) {
-        printf("Did not converge within %d iterations.\n", max_iters);
+        if (g_verbose) printf("Did not converge within %d iterations.\n", max_iters);
     }
 
     free(g);
@@ -120,23 +133,25 @@ void gradient_descent_momentum(FuncPtrND f, GradPtrND grad, double* x, int dim,
     for (i = 0; i < max_iters; i++) {
         grad(x, g, dim);
 
+        PROF_BEGIN("momentum.update");
         double change = 0.0;
         for (int j = 0; j < dim; j++) {
             v[j] = gamma * v[j] - lr * g[j];  // update velocity
             x[j] += v[j];                     // apply velocity
             change += fabs(v[j]);
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | velocity_norm = %.6f\n", i + 1, f(x, dim), sqrt(norm_squared(v, dim)));
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | velocity_norm = %.6f\n", i + 1, f(x, dim), sqrt(norm_squared(v, dim)));
 
         if (change < tol) {
-            printf("Converged in %d iterations.\n", i + 1);
+            if (g_verbose) printf("Converged in %d iterations.\n", i + 1);
             break;
         }
     }
 
     if (i == max_iters) {
-        printf("Did not converge within %d iterations.\n", max_iters);
+        if (g_verbose) printf("Did not converge within %d iterations.\n", max_iters);
     }
 
     free(g);
@@ -154,6 +169,7 @@ void gradient_descent_adam(FuncPtrND f, GradPtrND grad, double* x, int dim, doub
     for (int t = 1; t <= max_iters; t++) {
         grad(x, g, dim);
 
+        PROF_BEGIN("adam.update");
         double change = 0.0;
         for (int i = 0; i < dim; i++) {
             // Update biased first and second moment estimates
@@ -169,11 +185,12 @@ void gradient_descent_adam(FuncPtrND f, GradPtrND grad, double* x, int dim, doub
             x[i] -= delta;
             change += fabs(delta);
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
 
         if (change < tol) {
-            printf("Converged in %d iterations.\n", t);
+            if (g_verbose) printf("Converged in %d iterations.\n", t);
             break;
         }
     }
@@ -192,6 +209,7 @@ void gradient_descent_adagrad(FuncPtrND f, GradPtrND grad, double* x, int dim, d
     for (int t = 1; t <= max_iters; t++) {
         grad(x, g, dim);
 
+        PROF_BEGIN("adagrad.update");
         double change = 0.0;
         for (int i = 0; i < dim; i++) {
             G[i] += g[i] * g[i];
@@ -200,11 +218,12 @@ void gradient_descent_adagrad(FuncPtrND f, GradPtrND grad, double* x, int dim, d
             x[i] -= delta;
             change += fabs(delta);
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
 
         if (change < tol) {
-            printf("Converged in %d iterations.\n", t);
+            if (g_verbose) printf("Converged in %d iterations.\n", t);
             break;
         }
     }
@@ -221,6 +240,7 @@ void gradient_descent_rmsprop(FuncPtrND f, GradPtrND grad, double* x, int dim, d
     for (int t = 1; t <= max_iters; t++) {
         grad(x, g, dim);
 
+        PROF_BEGIN("rmsprop.update");
         double change = 0.0;
         for (int i = 0; i < dim; i++) {
             G[i] = beta * G[i] + (1 - beta) * g[i] * g[i]; // EMA of g²
@@ -229,11 +249,12 @@ void gradient_descent_rmsprop(FuncPtrND f, GradPtrND grad, double* x, int dim, d
             x[i] -= delta;
             change += fabs(delta);
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
 
         if (change < tol) {
-            printf("Converged in %d iterations.\n", t);
+            if (g_verbose) printf("Converged in %d iterations.\n", t);
             break;
         }
     }
@@ -258,17 +279,19 @@ void gradient_descent_nesterov(FuncPtrND f, GradPtrND grad, double* x, int dim,
         // gradient at lookahead point
         grad(x_lookahead, g, dim);
 
+        PROF_BEGIN("nesterov.update");
         double change = 0.0;
         for (int i = 0; i < dim; i++) {
             v[i] = gamma * v[i] - lr * g[i];
             x[i] += v[i];
             change += fabs(v[i]);
         }
+        PROF_END();
 
-        printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
+        if (g_verbose) printf("Iter %3d | f(x) = %.6f | change = %.6f\n", t, f(x, dim), change);
 
         if (change < tol) {
-            printf("Converged in %d iterations.\n", t);
+            if (g_verbose) printf("Converged in %d iterations.\n", t);
             break;
         }
     }
@@ -277,3 +300,29 @@ void gradient_descent_nesterov(FuncPtrND f, GradPtrND grad, double* x, int dim,
     free(g);
     free(x_lookahead);
 }
+
+
+// Generic dispatch
+
+OptimizerParams optimizer_default_params(OptimizerType type) {
+    OptimizerParams p;
+    p.type = type;
+    p.lr = 0.01;
+    p.momentum = 0.9;
+    p.beta1 = 0.9;
+    p.beta2 = type == OPT_RMSPROP ? 0.9 : 0.999;
+    p.epsilon = 1e-8;
+    return p;
+}
+
+const char* optimizer_name(OptimizerType type) {
+    switch (type) {
+        case OPT_GD:       return "GD";
+        case OPT_MOMENTUM: return "Momentum";
+        case OPT_NESTEROV: return "Nesterov";
+        case OPT_ADAGRAD:  return "Adagrad";
+        case OPT_RMSPROP:  return "RMSProp";
+        case OPT_ADAM:     return "Adam";
+    }
+    return "?";
+}
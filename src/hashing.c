@@ -0,0 +1,309 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "../include/hashing.h"
+#include "../include/prof.h"
+
+#define HASH_MAX_NGRAM 8
+
+HashConfig hash_default_config(const char* schema, int bits) {
+    HashConfig cfg;
+    cfg.bits = bits;
+    cfg.schema = schema;
+    cfg.ngram = 1;
+    cfg.has_header = 0;
+    cfg.delimiter = ',';
+    cfg.positive = NULL;
+    cfg.seed = 0x9747b28cu;
+    return cfg;
+}
+
+int hash_dim(const HashConfig* cfg) {
+    return (1 << cfg->bits) + 1;
+}
+
+static uint32_t rotl32(uint32_t x, int r) {
+    return (x << r) | (x >> (32 - r));
+}
+
+uint32_t hash_bytes(const void* key, size_t len, uint32_t seed) {
+    const uint8_t* data = key;
+    const uint32_t c1 = 0xcc9e2d51u, c2 = 0x1b873593u;
+    uint32_t h = seed;
+
+    size_t blocks = len / 4;
+    for (size_t i = 0; i < blocks; i++) {
+        uint32_t k;
+        memcpy(&k, data + 4 * i, 4);
+        k *= c1;
+        k = rotl32(k, 15);
+        k *= c2;
+        h ^= k;
+        h = rotl32(h, 13);
+        h = h * 5 + 0xe6546b64u;
+    }
+
+    const uint8_t* tail = data + 4 * blocks;
+    uint32_t k = 0;
+    switch (len & 3) {
+        case 3: k ^= (uint32_t)tail[2] << 16;   /* fall through */
+        case 2: k ^= (uint32_t)tail[1] << 8;    /* fall through */
+        case 1:
+            k ^= tail[0];
+            k *= c1;
+            k = rotl32(k, 15);
+            k *= c2;
+            h ^= k;
+    }
+
+    h ^= (uint32_t)len;
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+
+// Rows
+
+void hashed_row_init(HashedRow* row) {
+    row->nnz = 0;
+    row->cap = 64;
+    row->idx = malloc(row->cap * sizeof(int));
+    row->val = malloc(row->cap * sizeof(double));
+    row->y = 0.0;
+}
+
+void hashed_row_free(HashedRow* row) {
+    free(row->idx);
+    free(row->val);
+    row->idx = NULL;
+    row->val = NULL;
+    row->nnz = row->cap = 0;
+}
+
+static void row_push(HashedRow* row, int j, double v) {
+    if (row->nnz == row->cap) {
+        row->cap *= 2;
+        row->idx = realloc(row->idx, row->cap * sizeof(int));
+        row->val = realloc(row->val, row->cap * sizeof(double));
+    }
+    row->idx[row->nnz] = j;
+    row->val[row->nnz] = v;
+    row->nnz++;
+}
+
+// Bucket from the low bits, sign from bit 31
+static void emit(HashedRow* row, uint32_t h, double v, uint32_t mask) {
+    row_push(row, 1 + (int)(h & mask), (h >> 31) ? -v : v);
+}
+
+// Shell sort on the parallel arrays, then sum duplicates and drop cancelled entries
+static void sort_and_merge(HashedRow* row) {
+    int n = row->nnz;
+    int* idx = row->idx;
+    double* val = row->val;
+    for (int gap = n / 2; gap > 0; gap = gap == 2 ? 1 : gap * 5 / 11) {
+        for (int i = gap; i < n; i++) {
+            int ki = idx[i];
+            double kv = val[i];
+            int j = i;
+            for (; j >= gap && idx[j - gap] > ki; j -= gap) {
+                idx[j] = idx[j - gap];
+                val[j] = val[j - gap];
+            }
+            idx[j] = ki;
+            val[j] = kv;
+        }
+    }
+
+    int out = 0;
+    for (int i = 0; i < n; ) {
+        int j = idx[i];
+        double sum = 0.0;
+        for (; i < n && idx[i] == j; i++) sum += val[i];
+        if (sum != 0.0) {
+            idx[out] = j;
+            val[out] = sum;
+            out++;
+        }
+    }
+    row->nnz = out;
+}
+
+
+// Parsing
+
+// Next field of the line, unquoted in place ("" is an escaped quote); NULL past the last one
+static char* next_field(char** cursor, char delim) {
+    char* p = *cursor;
+    if (!p) return NULL;
+
+    if (*p == '"') {
+        char* start = ++p;
+        char* out = start;
+        while (*p) {
+            if (*p == '"') {
+                if (p[1] != '"') {
+                    p++;
+                    break;
+                }
+                p++;
+            }
+            *out++ = *p++;
+        }
+        while (*p && *p != delim) p++;
+        *cursor = *p ? p + 1 : NULL;
+        *out = '\0';
+        return start;
+    }
+
+    char* start = p;
+    while (*p && *p != delim) p++;
+    if (*p) {
+        *p = '\0';
+        *cursor = p + 1;
+    } else {
+        *cursor = NULL;
+    }
+    return start;
+}
+
+// Words are maximal alphanumeric runs, lower-cased; an n-gram hashes the chain of its word hashes
+static void hash_text(const HashConfig* cfg, char* text, uint32_t col_seed, HashedRow* row, uint32_t mask) {
+    int ngram = cfg->ngram < 1 ? 1 : (cfg->ngram > HASH_MAX_NGRAM ? HASH_MAX_NGRAM : cfg->ngram);
+    uint32_t recent[HASH_MAX_NGRAM];     // hashes of the last `ngram` words, recent[t % ngram]
+    int t = 0;
+
+    char* p = text;
+    while (*p) {
+        while (*p && !isalnum((unsigned char)*p)) p++;
+        if (!*p) break;
+        char* word = p;
+        for (; isalnum((unsigned char)*p); p++) *p = (char)tolower((unsigned char)*p);
+
+        recent[t % ngram] = hash_bytes(word, p - word, cfg->seed);
+        t++;
+        for (int len = 1; len <= ngram && len <= t; len++) {
+            uint32_t h = col_seed;
+            for (int m = t - len; m < t; m++) h = hash_bytes(&recent[m % ngram], sizeof(uint32_t), h);
+            emit(row, h, 1.0, mask);
+        }
+    }
+}
+
+int hash_record(const HashConfig* cfg, char* line, HashedRow* row) {
+    line[strcspn(line, "\r\n")] = '\0';
+    uint32_t mask = (1u << cfg->bits) - 1;
+    row->nnz = 0;
+    row->y = 0.0;
+    row_push(row, 0, 1.0);   // bias
+
+    char* cursor = line;
+    for (int c = 0; cfg->schema[c]; c++) {
+        char* field = next_field(&cursor, cfg->delimiter);
+        if (!field) return -1;
+        uint32_t col_seed = hash_bytes(&c, sizeof(int), cfg->seed);
+        char* end;
+
+        switch (cfg->schema[c]) {
+            case 'n': {
+                double v = strtod(field, &end);
+                if (end != field && v != 0.0) emit(row, col_seed, v, mask);
+                break;
+            }
+            case 'c':
+                if (*field) emit(row, hash_bytes(field, strlen(field), col_seed), 1.0, mask);
+                break;
+            case 't':
+                hash_text(cfg, field, col_seed, row, mask);
+                break;
+            case 'l':
+                if (cfg->positive) {
+                    row->y = strcmp(field, cfg->positive) == 0 ? 1.0 : 0.0;
+                } else {
+                    row->y = strtod(field, &end);
+                    if (end == field) return -1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+
+    sort_and_merge(row);
+    return 0;
+}
+
+SparseDataset* load_hashed_csv(const char* filename, const HashConfig* cfg) {
+    if (cfg->bits < 1 || cfg->bits > 30) {
+        fprintf(stderr, "load_hashed_csv: bits must be in 1..30\n");
+        return NULL;
+    }
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        perror("File error");
+        return NULL;
+    }
+
+    PROF_BEGIN("load_hashed_csv");
+    int cap_rows = 1024, n = 0;
+    long long cap_nnz = 16384, nnz = 0;
+    int* row_ptr = malloc((cap_rows + 1) * sizeof(int));
+    double* y = malloc(cap_rows * sizeof(double));
+    int* idx = malloc(cap_nnz * sizeof(int));
+    double* val = malloc(cap_nnz * sizeof(double));
+
+    HashedRow row;
+    hashed_row_init(&row);
+    char* line = NULL;
+    size_t line_cap = 0;
+    int skipped = 0, first = 1;
+
+    while (getline(&line, &line_cap, f) != -1) {
+        if (first && cfg->has_header) {
+            first = 0;
+            continue;
+        }
+        first = 0;
+        if (hash_record(cfg, line, &row) != 0) {
+            skipped++;
+            continue;
+        }
+
+        if (n == cap_rows) {
+            cap_rows *= 2;
+            row_ptr = realloc(row_ptr, (cap_rows + 1) * sizeof(int));
+            y = realloc(y, cap_rows * sizeof(double));
+        }
+        while (nnz + row.nnz > cap_nnz) {
+            cap_nnz *= 2;
+            idx = realloc(idx, cap_nnz * sizeof(int));
+            val = realloc(val, cap_nnz * sizeof(double));
+        }
+        row_ptr[n] = (int)nnz;
+        memcpy(idx + nnz, row.idx, row.nnz * sizeof(int));
+        memcpy(val + nnz, row.val, row.nnz * sizeof(double));
+        nnz += row.nnz;
+        y[n++] = row.y;
+    }
+    row_ptr[n] = (int)nnz;
+
+    free(line);
+    hashed_row_free(&row);
+    fclose(f);
+    if (skipped) fprintf(stderr, "%s: skipped %d malformed line%s\n", filename, skipped, skipped == 1 ? "" : "s");
+
+    SparseDataset* data = malloc(sizeof(SparseDataset));
+    data->n = n;
+    data->d = hash_dim(cfg);
+    data->row_ptr = row_ptr;
+    data->idx = idx;
+    data->val = val;
+    data->y = y;
+    PROF_END();
+    return data;
+}
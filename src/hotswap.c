@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/hotswap.h"
+#include "../include/aligned.h"
+#include "../include/prof.h"
+
+typedef struct Snapshot {
+    Model* model;
+    long long version;
+    unsigned long long retired;     // epoch at which it was replaced
+    struct Snapshot* next;          // retired list
+} Snapshot;
+
+// epoch == 0: not reading. Otherwise the global epoch seen by the reader's current acquire.
+typedef struct {
+    unsigned long long epoch;
+    int used;
+    char pad[CACHE_LINE - sizeof(unsigned long long) - sizeof(int)];   // one reader per line
+} ReaderSlot;
+
+struct ModelHandle {
+    ModelType type;
+    int k, d;
+    Snapshot* current;              // atomic
+    unsigned long long epoch;       // atomic, starts at 1
+    long long version;              // atomic copy of current->version
+    ReaderSlot* readers;            // HOT_MAX_READERS, cache-line aligned
+
+    // Publisher only, except the counters read by hot_stats
+    Snapshot* retired;
+    long long published;
+    long long reclaimed;
+};
+
+static Snapshot* snapshot_create(const ModelHandle* h, const double* W, long long version) {
+    Snapshot* snap = malloc(sizeof(Snapshot));
+    Model* m = create_model(h->type, h->k, h->d);
+    if (!snap || !m) {
+        perror("hot_publish");
+        free(snap);
+        free_model(m);
+        return NULL;
+    }
+    memcpy(m->W, W, (size_t)h->k * h->d * sizeof(double));
+    snap->model = m;
+    snap->version = version;
+    snap->retired = 0;
+    snap->next = NULL;
+    return snap;
+}
+
+static void snapshot_free(Snapshot* snap) {
+    free_model(snap->model);
+    free(snap);
+}
+
+ModelHandle* hot_create(ModelType type, int k, int d, const double* W) {
+    ModelHandle* h = calloc(1, sizeof(ModelHandle));
+    if (!h) return NULL;
+    h->type = type;
+    h->k = k;
+    h->d = d;
+    h->epoch = 1;
+    h->readers = aligned_malloc(HOT_MAX_READERS * sizeof(ReaderSlot));
+    h->current = h->readers ? snapshot_create(h, W, 1) : NULL;
+    if (!h->current) {
+        aligned_free(h->readers);
+        free(h);
+        return NULL;
+    }
+    memset(h->readers, 0, HOT_MAX_READERS * sizeof(ReaderSlot));
+    h->version = 1;
+    h->published = 1;
+    return h;
+}
+
+void hot_destroy(ModelHandle* h) {
+    if (!h) return;
+    while (h->retired) {
+        Snapshot* next = h->retired->next;
+        snapshot_free(h->retired);
+        h->retired = next;
+    }
+    snapshot_free(h->current);
+    aligned_free(h->readers);
+    free(h);
+}
+
+
+// Readers
+
+int hot_reader_register(ModelHandle* h) {
+    for (int r = 0; r < HOT_MAX_READERS; r++) {
+        int expected = 0;
+        if (__atomic_compare_exchange_n(&h->readers[r].used, &expected, 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+            return r;
+    }
+    fprintf(stderr, "hot_reader_register: all %d reader slots in use\n", HOT_MAX_READERS);
+    return -1;
+}
+
+void hot_reader_unregister(ModelHandle* h, int reader) {
+    if (reader < 0 || reader >= HOT_MAX_READERS) return;
+    __atomic_store_n(&h->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&h->readers[reader].used, 0, __ATOMIC_RELEASE);
+}
+
+// The slot is announced before the snapshot is loaded, both sequentially consistent: a
+// publisher that swaps after our load retires the old snapshot at an epoch >= ours and
+// keeps it, and one whose scan misses our store swapped before our load, so we hold the new one.
+const Model* hot_acquire(ModelHandle* h, int reader, long long* version_out) {
+    if (reader < 0 || reader >= HOT_MAX_READERS) {
+        fprintf(stderr, "hot_acquire: %d is not a registered reader slot\n", reader);
+        return NULL;
+    }
+    ReaderSlot* slot = &h->readers[reader];
+    unsigned long long e = __atomic_load_n(&h->epoch, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&slot->epoch, e, __ATOMIC_SEQ_CST);
+    Snapshot* snap = __atomic_load_n(&h->current, __ATOMIC_SEQ_CST);
+    if (version_out) *version_out = snap->version;
+    return snap->model;
+}
+
+void hot_release(ModelHandle* h, int reader) {
+    if (reader < 0 || reader >= HOT_MAX_READERS) return;
+    __atomic_store_n(&h->readers[reader].epoch, 0, __ATOMIC_RELEASE);
+}
+
+long long hot_predict_batch(ModelHandle* h, int reader, const double* X, int n, double* scores_out, int* labels_out) {
+    long long version;
+    const Model* m = hot_acquire(h, reader, &version);
+    if (!m) return -1;
+    predict_batch(m, X, n, scores_out, labels_out);
+    hot_release(h, reader);
+    return version;
+}
+
+
+// Publisher
+
+// Frees the retired snapshots no reader can still hold: those replaced before the oldest
+// epoch any reader announces
+int hot_reclaim(ModelHandle* h) {
+    unsigned long long oldest = ~0ULL;
+    for (int r = 0; r < HOT_MAX_READERS; r++) {
+        unsigned long long e = __atomic_load_n(&h->readers[r].epoch, __ATOMIC_SEQ_CST);
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    int pending = 0;
+    Snapshot** link = &h->retired;
+    while (*link) {
+        Snapshot* snap = *link;
+        if (snap->retired < oldest) {
+            *link = snap->next;
+            snapshot_free(snap);
+            __atomic_add_fetch(&h->reclaimed, 1, __ATOMIC_RELAXED);
+        } else {
+            link = &snap->next;
+            pending++;
+        }
+    }
+    return pending;
+}
+
+long long hot_publish(ModelHandle* h, const double* W) {
+    PROF_BEGIN("hot_publish");
+    long long version = h->published + 1;
+    Snapshot* snap = snapshot_create(h, W, version);
+    if (!snap) {
+        PROF_END();
+        return -1;
+    }
+    Snapshot* old = __atomic_exchange_n(&h->current, snap, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&h->version, version, __ATOMIC_RELEASE);
+    old->retired = __atomic_fetch_add(&h->epoch, 1, __ATOMIC_SEQ_CST);
+    old->next = h->retired;
+    h->retired = old;
+    __atomic_store_n(&h->published, version, __ATOMIC_RELAXED);
+    hot_reclaim(h);
+    PROF_END();
+    return version;
+}
+
+long long hot_version(const ModelHandle* h) {
+    return __atomic_load_n(&h->version, __ATOMIC_ACQUIRE);
+}
+
+HotStats hot_stats(ModelHandle* h) {
+    HotStats s;
+    s.published = __atomic_load_n(&h->published, __ATOMIC_RELAXED);
+    s.reclaimed = __atomic_load_n(&h->reclaimed, __ATOMIC_RELAXED);
+    s.pending = (int)(s.published - 1 - s.reclaimed);
+    return s;
+}
+
+void hot_job_publish(const double* w, int dim, int iter, void* ctx) {
+    (void)iter;
+    ModelHandle* h = ctx;
+    if (dim != h->k * h->d) {
+        fprintf(stderr, "hot_job_publish: job has %d weights, model %d x %d\n", dim, h->k, h->d);
+        return;
+    }
+    hot_publish(h, w);
+}
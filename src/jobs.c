@@ -0,0 +1,347 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/jobs.h"
+#include "../include/optim.h"
+#include "../include/pool.h"
+#include "../include/prof.h"
+
+struct TrainJob {
+    JobConfig cfg;
+    int dim;
+    double* w_out;          // caller's buffer, written once when the job stops
+
+    // Objective: global FuncPtrND pair, or a dataset bound to the job
+    FuncPtrND f;
+    GradPtrND grad;
+    const Dataset* data;
+    LossType loss;
+
+    double* w;              // working weights, touched only by the executor thread
+    double* g;
+
+    pthread_mutex_t lock;
+    pthread_cond_t stopped;
+    JobProgress progress;   // under lock, as are published and the times
+    double* published;      // weights after progress.iter iterations
+    double t_start, t_end;
+    int done;
+
+    int cancel;             // atomic: set by job_cancel, read before every iteration
+    int refs;               // atomic: caller's handle + the executor's task
+    int started;            // under ex->lock
+    TrainJob* next;         // executor's list of jobs that have not stopped
+};
+
+// Each submit queues one pool task, and every task runs the oldest job not yet started:
+// jobs start in submission order even though the pool's own deques are LIFO
+struct JobExecutor {
+    ThreadPool* pool;
+    pthread_mutex_t lock;
+    TrainJob* active;       // in submission order
+    TrainJob* last;
+};
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static struct timespec to_timespec(double t) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)t;
+    ts.tv_nsec = (long)((t - (double)ts.tv_sec) * 1e9);
+    return ts;
+}
+
+const char* job_status_name(JobStatus status) {
+    switch (status) {
+        case JOB_QUEUED:    return "queued";
+        case JOB_RUNNING:   return "running";
+        case JOB_CONVERGED: return "converged";
+        case JOB_FINISHED:  return "finished";
+        case JOB_CANCELLED: return "cancelled";
+        default:            return "failed";
+    }
+}
+
+JobConfig job_default_config(OptimizerType type) {
+    JobConfig cfg;
+    cfg.opt = optimizer_default_params(type);
+    cfg.max_iters = 1000;
+    cfg.tol = 1e-6;
+    cfg.loss_every = 10;
+    cfg.on_done = NULL;
+    cfg.user = NULL;
+    cfg.publish = NULL;
+    cfg.publish_ctx = NULL;
+    cfg.publish_every = 0;
+    cfg.publish_interval_s = 0.0;
+    return cfg;
+}
+
+
+// Executor
+
+JobExecutor* executor_create(int num_threads) {
+    JobExecutor* ex = calloc(1, sizeof(JobExecutor));
+    if (!ex) return NULL;
+    ex->pool = pool_create(num_threads);
+    if (!ex->pool) {
+        free(ex);
+        return NULL;
+    }
+    pthread_mutex_init(&ex->lock, NULL);
+    return ex;
+}
+
+void executor_destroy(JobExecutor* ex) {
+    if (!ex) return;
+    pthread_mutex_lock(&ex->lock);
+    for (TrainJob* job = ex->active; job; job = job->next) __atomic_store_n(&job->cancel, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&ex->lock);
+    pool_destroy(ex->pool);     // queued jobs still run, and stop at once
+    pthread_mutex_destroy(&ex->lock);
+    free(ex);
+}
+
+
+// Objectives
+
+static double dataset_loss(const Dataset* data, LossType loss, const double* w) {
+    double total = 0.0;
+    for (int i = 0; i < data->n; i++) {
+        const double* x = data->X[i];
+        double z = 0.0;
+        for (int j = 0; j < data->d; j++) z += w[j] * x[j];
+        total += sample_loss(loss, z, data->y[i]);
+    }
+    return total / data->n;
+}
+
+static void dataset_grad(const Dataset* data, LossType loss, const double* w, double* grad_out) {
+    int d = data->d;
+    memset(grad_out, 0, d * sizeof(double));
+    for (int i = 0; i < data->n; i++) {
+        const double* x = data->X[i];
+        double z = 0.0;
+        for (int j = 0; j < d; j++) z += w[j] * x[j];
+        double e = sample_dloss(loss, z, data->y[i]);
+        for (int j = 0; j < d; j++) grad_out[j] += e * x[j];
+    }
+    for (int j = 0; j < d; j++) grad_out[j] /= data->n;
+}
+
+static double job_loss(TrainJob* job, double* w) {
+    if (job->data) return dataset_loss(job->data, job->loss, w);
+    return job->f ? job->f(w, job->dim) : NAN;
+}
+
+static void job_grad(TrainJob* job, double* w, double* grad_out) {
+    if (job->data) dataset_grad(job->data, job->loss, w, grad_out);
+    else job->grad(w, grad_out, job->dim);
+}
+
+
+// Jobs
+
+static void job_unref(TrainJob* job) {
+    if (__atomic_sub_fetch(&job->refs, 1, __ATOMIC_ACQ_REL) != 0) return;
+    pthread_mutex_destroy(&job->lock);
+    pthread_cond_destroy(&job->stopped);
+    free(job->w);
+    free(job->g);
+    free(job->published);
+    free(job);
+}
+
+static void publish(TrainJob* job, int iter, double change, double loss, int loss_iter) {
+    pthread_mutex_lock(&job->lock);
+    job->progress.iter = iter;
+    job->progress.change = change;
+    if (loss_iter > job->progress.loss_iter) {
+        job->progress.loss = loss;
+        job->progress.loss_iter = loss_iter;
+    }
+    memcpy(job->published, job->w, job->dim * sizeof(double));
+    pthread_mutex_unlock(&job->lock);
+}
+
+static void run_job(void* arg) {
+    JobExecutor* ex = arg;
+    pthread_mutex_lock(&ex->lock);
+    TrainJob* job = ex->active;
+    while (job->started) job = job->next;
+    job->started = 1;
+    pthread_mutex_unlock(&ex->lock);
+
+    const JobConfig* cfg = &job->cfg;
+    PROF_BEGIN("run_job");
+
+    pthread_mutex_lock(&job->lock);
+    job->progress.status = JOB_RUNNING;
+    job->t_start = now_s();
+    pthread_mutex_unlock(&job->lock);
+
+    Optimizer* opt = optimizer_create(&cfg->opt, NULL, job->dim);
+    JobStatus status = opt ? JOB_FINISHED : JOB_FAILED;
+    int iter = 0, loss_iter = 0, published_iter = 0;
+    double change = 0.0, loss = NAN, t_published = now_s();
+    while (opt && iter < cfg->max_iters) {
+        if (__atomic_load_n(&job->cancel, __ATOMIC_RELAXED)) {
+            status = JOB_CANCELLED;
+            break;
+        }
+        job_grad(job, (double*)optimizer_eval_point(opt, job->w), job->g);
+        change = optimizer_apply(opt, job->w, job->g);
+        iter++;
+        if (cfg->loss_every > 0 && iter % cfg->loss_every == 0) {
+            loss = job_loss(job, job->w);
+            loss_iter = iter;
+        }
+        publish(job, iter, change, loss, loss_iter);
+        if (cfg->publish && ((cfg->publish_every > 0 && iter % cfg->publish_every == 0) ||
+                             (cfg->publish_interval_s > 0.0 && now_s() - t_published >= cfg->publish_interval_s))) {
+            cfg->publish(job->w, job->dim, iter, cfg->publish_ctx);
+            published_iter = iter;
+            t_published = now_s();
+        }
+        if (change < cfg->tol) {
+            status = JOB_CONVERGED;
+            break;
+        }
+    }
+    optimizer_destroy(opt);
+
+    if (loss_iter != iter && status != JOB_CANCELLED && status != JOB_FAILED) {
+        loss = job_loss(job, job->w);
+        loss_iter = iter;
+        publish(job, iter, change, loss, loss_iter);
+    }
+    if (cfg->publish && published_iter != iter) cfg->publish(job->w, job->dim, iter, cfg->publish_ctx);
+    memcpy(job->w_out, job->w, job->dim * sizeof(double));
+
+    pthread_mutex_lock(&ex->lock);
+    TrainJob** link = &ex->active;
+    TrainJob* prev = NULL;
+    while (*link != job) {
+        prev = *link;
+        link = &(*link)->next;
+    }
+    *link = job->next;
+    if (ex->last == job) ex->last = prev;
+    pthread_mutex_unlock(&ex->lock);
+
+    pthread_mutex_lock(&job->lock);
+    job->t_end = now_s();
+    job->progress.status = status;
+    job->progress.elapsed_s = job->t_end - job->t_start;
+    JobProgress final = job->progress;
+    pthread_mutex_unlock(&job->lock);
+
+    if (cfg->on_done) cfg->on_done(job, &final, cfg->user);
+
+    pthread_mutex_lock(&job->lock);
+    job->done = 1;
+    pthread_cond_broadcast(&job->stopped);
+    pthread_mutex_unlock(&job->lock);
+    PROF_END();
+    job_unref(job);
+}
+
+static TrainJob* submit(JobExecutor* ex, TrainJob* job, double* w, int dim, const JobConfig* cfg) {
+    job->cfg = *cfg;
+    job->dim = dim;
+    job->w_out = w;
+    job->w = malloc(dim * sizeof(double));
+    job->g = malloc(dim * sizeof(double));
+    job->published = malloc(dim * sizeof(double));
+    if (!job->w || !job->g || !job->published) {
+        perror("job_submit");
+        free(job->w);
+        free(job->g);
+        free(job->published);
+        free(job);
+        return NULL;
+    }
+    memcpy(job->w, w, dim * sizeof(double));
+    memcpy(job->published, w, dim * sizeof(double));
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&job->stopped, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&job->lock, NULL);
+
+    job->progress.status = JOB_QUEUED;
+    job->progress.loss = NAN;
+    job->refs = 2;
+
+    pthread_mutex_lock(&ex->lock);
+    if (ex->last) ex->last->next = job;
+    else ex->active = job;
+    ex->last = job;
+    pthread_mutex_unlock(&ex->lock);
+    pool_submit(ex->pool, run_job, ex);
+    return job;
+}
+
+TrainJob* job_submit(JobExecutor* ex, FuncPtrND f, GradPtrND grad, double* w, int dim, const JobConfig* cfg) {
+    TrainJob* job = calloc(1, sizeof(TrainJob));
+    if (!job) return NULL;
+    job->f = f;
+    job->grad = grad;
+    return submit(ex, job, w, dim, cfg);
+}
+
+TrainJob* job_submit_dataset(JobExecutor* ex, const Dataset* data, LossType loss, double* w, const JobConfig* cfg) {
+    if (data->n <= 0) {
+        fprintf(stderr, "job_submit_dataset: empty dataset\n");
+        return NULL;
+    }
+    TrainJob* job = calloc(1, sizeof(TrainJob));
+    if (!job) return NULL;
+    job->data = data;
+    job->loss = loss;
+    return submit(ex, job, w, data->d, cfg);
+}
+
+JobProgress job_poll(TrainJob* job) {
+    pthread_mutex_lock(&job->lock);
+    JobProgress p = job->progress;
+    if (p.status == JOB_RUNNING) p.elapsed_s = now_s() - job->t_start;
+    pthread_mutex_unlock(&job->lock);
+    return p;
+}
+
+void job_snapshot(TrainJob* job, double* w_out) {
+    pthread_mutex_lock(&job->lock);
+    memcpy(w_out, job->published, job->dim * sizeof(double));
+    pthread_mutex_unlock(&job->lock);
+}
+
+int job_wait(TrainJob* job, double timeout_s) {
+    pthread_mutex_lock(&job->lock);
+    if (timeout_s < 0) {
+        while (!job->done) pthread_cond_wait(&job->stopped, &job->lock);
+    } else {
+        struct timespec deadline = to_timespec(now_s() + timeout_s);
+        while (!job->done && pthread_cond_timedwait(&job->stopped, &job->lock, &deadline) == 0) {}
+    }
+    int done = job->done;
+    pthread_mutex_unlock(&job->lock);
+    return done;
+}
+
+void job_cancel(TrainJob* job) {
+    __atomic_store_n(&job->cancel, 1, __ATOMIC_RELAXED);
+}
+
+void job_release(TrainJob* job) {
+    if (job) job_unref(job);
+}
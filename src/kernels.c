@@ -0,0 +1,113 @@
+#include <math.h>
+#include <stddef.h>
+#include "../include/kernels.h"
+
+#if defined(__GNUC__)
+#define UNROLL _Pragma("GCC unroll 32")
+#else
+#define UNROLL
+#endif
+
+static inline double sigmoid(double z) {
+    return 1.0 / (1.0 + exp(-z));
+}
+
+// Loss/gradient kernels for one fixed dimension D.
+// Every loop over j has a constant trip count, so wr[] and acc[] become registers.
+#define DEFINE_FIXED_KERNELS(D) \
+static double dot_##D(const double* w, const double* x) { \
+    double z = 0.0; \
+    UNROLL for (int j = 0; j < D; j++) z += w[j] * x[j]; \
+    return z; \
+} \
+\
+static double mse_loss_##D(const double* w, double* const* X, const double* y, int n) { \
+    double wr[D]; \
+    UNROLL for (int j = 0; j < D; j++) wr[j] = w[j]; \
+    double loss = 0.0; \
+    for (int i = 0; i < n; i++) { \
+        const double* x = X[i]; \
+        double z = 0.0; \
+        UNROLL for (int j = 0; j < D; j++) z += x[j] * wr[j]; \
+        double error = z - y[i]; \
+        loss += error * error; \
+    } \
+    return loss / n; \
+} \
+\
+static void mse_grad_##D(const double* w, double* const* X, const double* y, int n, double* grad_out) { \
+    double wr[D], acc[D]; \
+    UNROLL for (int j = 0; j < D; j++) { wr[j] = w[j]; acc[j] = 0.0; } \
+    for (int i = 0; i < n; i++) { \
+        const double* x = X[i]; \
+        double z = 0.0; \
+        UNROLL for (int j = 0; j < D; j++) z += x[j] * wr[j]; \
+        double error = z - y[i]; \
+        UNROLL for (int j = 0; j < D; j++) acc[j] += 2 * error * x[j]; \
+    } \
+    UNROLL for (int j = 0; j < D; j++) grad_out[j] = acc[j] / n; \
+} \
+\
+static void logistic_grad_##D(const double* w, double* const* X, const double* y, int n, double* grad_out) { \
+    double wr[D], acc[D]; \
+    UNROLL for (int j = 0; j < D; j++) { wr[j] = w[j]; acc[j] = 0.0; } \
+    for (int i = 0; i < n; i++) { \
+        const double* x = X[i]; \
+        double z = 0.0; \
+        UNROLL for (int j = 0; j < D; j++) z += x[j] * wr[j]; \
+        double error = sigmoid(z) - y[i]; \
+        UNROLL for (int j = 0; j < D; j++) acc[j] += error * x[j]; \
+    } \
+    UNROLL for (int j = 0; j < D; j++) grad_out[j] = acc[j] / n; \
+}
+
+#define FIXED_ENTRY(D) { D, dot_##D, mse_loss_##D, mse_grad_##D, logistic_grad_##D }
+
+DEFINE_FIXED_KERNELS(1)
+DEFINE_FIXED_KERNELS(2)
+DEFINE_FIXED_KERNELS(3)
+DEFINE_FIXED_KERNELS(4)
+DEFINE_FIXED_KERNELS(5)
+DEFINE_FIXED_KERNELS(6)
+DEFINE_FIXED_KERNELS(7)
+DEFINE_FIXED_KERNELS(8)
+DEFINE_FIXED_KERNELS(9)
+DEFINE_FIXED_KERNELS(10)
+DEFINE_FIXED_KERNELS(11)
+DEFINE_FIXED_KERNELS(12)
+DEFINE_FIXED_KERNELS(13)
+DEFINE_FIXED_KERNELS(14)
+DEFINE_FIXED_KERNELS(15)
+DEFINE_FIXED_KERNELS(16)
+DEFINE_FIXED_KERNELS(17)
+DEFINE_FIXED_KERNELS(18)
+DEFINE_FIXED_KERNELS(19)
+DEFINE_FIXED_KERNELS(20)
+DEFINE_FIXED_KERNELS(21)
+DEFINE_FIXED_KERNELS(22)
+DEFINE_FIXED_KERNELS(23)
+DEFINE_FIXED_KERNELS(24)
+DEFINE_FIXED_KERNELS(25)
+DEFINE_FIXED_KERNELS(26)
+DEFINE_FIXED_KERNELS(27)
+DEFINE_FIXED_KERNELS(28)
+DEFINE_FIXED_KERNELS(29)
+DEFINE_FIXED_KERNELS(30)
+DEFINE_FIXED_KERNELS(31)
+DEFINE_FIXED_KERNELS(32)
+
+static const FixedKernels fixed_table[FIXED_MAX_DIM] = {
+    FIXED_ENTRY(1),  FIXED_ENTRY(2),  FIXED_ENTRY(3),  FIXED_ENTRY(4),
+    FIXED_ENTRY(5),  FIXED_ENTRY(6),  FIXED_ENTRY(7),  FIXED_ENTRY(8),
+    FIXED_ENTRY(9),  FIXED_ENTRY(10), FIXED_ENTRY(11), FIXED_ENTRY(12),
+    FIXED_ENTRY(13), FIXED_ENTRY(14), FIXED_ENTRY(15), FIXED_ENTRY(16),
+    FIXED_ENTRY(17), FIXED_ENTRY(18), FIXED_ENTRY(19), FIXED_ENTRY(20),
+    FIXED_ENTRY(21), FIXED_ENTRY(22), FIXED_ENTRY(23), FIXED_ENTRY(24),
+    FIXED_ENTRY(25), FIXED_ENTRY(26), FIXED_ENTRY(27), FIXED_ENTRY(28),
+    FIXED_ENTRY(29), FIXED_ENTRY(30), FIXED_ENTRY(31), FIXED_ENTRY(32)
+};
+
+const FixedKernels* fixed_kernels(int d) {
+    if (d < 1 || d > FIXED_MAX_DIM) return NULL;
+    return &fixed_table[d - 1];
+}
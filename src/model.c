@@ -2,21 +2,263 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
 #include "../include/model.h"
 #include "../include/dataset.h"
+#include "../include/prof.h"
+#include "../include/kernels.h"
+#include "../include/multitarget.h"
+#include "../include/reduce.h"
 
 
 // Global dataset pointer
 static Dataset* g_data = NULL;
 
+// Specialized kernels for the current dataset's dimension (NULL when d is too large)
+static const FixedKernels* g_fixed = NULL;
+static int g_use_fixed = 1;
+
+// Transform fused into the loss kernels (NULL: weights act on the raw features)
+static const FeatureTransform* g_transform = NULL;
+
+// Penalty strengths for the reg_* objectives
+static double g_l1 = 0.0;
+static double g_l2 = 0.0;
+
+// Parallel sums for the loss and gradient kernels (NULL: serial loops). Each thread has
+// its own, so pool tasks and other callers never share partial sums or scratch.
+static _Thread_local Reducer* g_reducer = NULL;
+
 void set_dataset(Dataset* data) {
     g_data = data;
+    g_fixed = g_use_fixed && data ? fixed_kernels(data->d) : NULL;
+}
+
+void use_fixed_kernels(int on) {
+    g_use_fixed = on;
+    g_fixed = on && g_data ? fixed_kernels(g_data->d) : NULL;
+}
+
+void set_feature_transform(const FeatureTransform* t) {
+    g_transform = t;
+}
+
+void set_reduction(ReduceMode mode, int num_threads) {
+    reducer_free(g_reducer);
+    g_reducer = reducer_create(mode, num_threads);
+}
+
+
+// Row kernels for reducer_sum(): each adds the contributions of rows [begin, end)
+
+typedef struct {
+    const double* w;
+    double** W;     // softmax rows
+    int dim;
+    int k;
+} RowArgs;
+
+static double sigmoid(double z);
+void compute_softmax(double* z, double* softmax_out, int k);
+
+static void mse_loss_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    for (int i = begin; i < end; i++) {
+        const double* x = g_data->X[i];
+        double y_pred = 0.0;
+        for (int j = 0; j < a->dim; j++) y_pred += x[j] * a->w[j];
+        double error = y_pred - g_data->y[i];
+        acc[0] += error * error;
+    }
+}
+
+static void mse_grad_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    for (int i = begin; i < end; i++) {
+        const double* x = g_data->X[i];
+        double y_pred = 0.0;
+        for (int j = 0; j < a->dim; j++) y_pred += x[j] * a->w[j];
+        double error = y_pred - g_data->y[i];
+        for (int j = 0; j < a->dim; j++) acc[j] += 2 * error * x[j];
+    }
+}
+
+static void logistic_loss_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    for (int i = begin; i < end; i++) {
+        const double* x = g_data->X[i];
+        double z = 0.0;
+        for (int j = 0; j < a->dim; j++) z += x[j] * a->w[j];
+        double pred = sigmoid(z);
+        double y = g_data->y[i];
+        acc[0] += -y * log(pred + 1e-8) - (1 - y) * log(1 - pred + 1e-8);
+    }
+}
+
+static void logistic_grad_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    for (int i = begin; i < end; i++) {
+        const double* x = g_data->X[i];
+        double z = 0.0;
+        for (int j = 0; j < a->dim; j++) z += x[j] * a->w[j];
+        double error = sigmoid(z) - g_data->y[i];
+        for (int j = 0; j < a->dim; j++) acc[j] += error * x[j];
+    }
+}
+
+// scratch: z and prob, k each
+static void softmax_probs(const RowArgs* a, const double* x, double* scratch) {
+    for (int c = 0; c < a->k; c++) {
+        double z = 0.0;
+        for (int j = 0; j < a->dim; j++) z += a->W[c][j] * x[j];
+        scratch[c] = z;
+    }
+    compute_softmax(scratch, scratch + a->k, a->k);
+}
+
+static void softmax_loss_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    for (int i = begin; i < end; i++) {
+        softmax_probs(a, g_data->X[i], scratch);
+        acc[0] += -log(scratch[a->k + (int)g_data->y[i]] + 1e-8);
+    }
+}
+
+static void softmax_grad_rows(void* ctx, int begin, int end, double* acc, double* scratch) {
+    const RowArgs* a = ctx;
+    const double* prob = scratch + a->k;
+    for (int i = begin; i < end; i++) {
+        const double* x = g_data->X[i];
+        softmax_probs(a, x, scratch);
+        int y = (int)g_data->y[i];
+        for (int c = 0; c < a->k; c++) {
+            double error = prob[c] - (c == y ? 1.0 : 0.0);
+            double* g = acc + (size_t)c * a->dim;
+            for (int j = 0; j < a->dim; j++) g[j] += error * x[j];
+        }
+    }
+}
+
+// Mean over the rows of a reduced loss
+static double reduced_loss(RowSumFn fn, const RowArgs* a, int scratch_len) {
+    double sum;
+    reducer_sum(g_reducer, g_data->n, 1, scratch_len, fn, (void*)a, &sum);
+    return sum / g_data->n;
+}
+
+static void reduced_grad(RowSumFn fn, const RowArgs* a, double* grad_out) {
+    reducer_sum(g_reducer, g_data->n, a->dim, 0, fn, (void*)a, grad_out);
+    for (int j = 0; j < a->dim; j++) grad_out[j] /= g_data->n;
+}
+
+// Weights folded into raw space, one set of buffers per thread grown on first use, so
+// fused objectives neither allocate per call nor share state between concurrent callers.
+// A thread's buffers are freed when it exits (pool threads come and go with their pools).
+typedef struct {
+    double* w;
+    size_t cap;
+    double** rows;
+    int rows_cap;
+} FoldBuffers;
+
+static _Thread_local FoldBuffers* t_fold = NULL;
+static pthread_key_t g_fold_key;
+static pthread_once_t g_fold_once = PTHREAD_ONCE_INIT;
+
+static void free_fold_buffers(void* arg) {
+    FoldBuffers* f = arg;
+    free(f->w);
+    free(f->rows);
+    free(f);
+}
+
+static void create_fold_key(void) {
+    pthread_key_create(&g_fold_key, free_fold_buffers);
+}
+
+static FoldBuffers* fold_buffers(void) {
+    if (t_fold) return t_fold;
+    pthread_once(&g_fold_once, create_fold_key);
+    FoldBuffers* f = calloc(1, sizeof(FoldBuffers));
+    if (!f || pthread_setspecific(g_fold_key, f) != 0) {
+        perror("fold_buffers");
+        free(f);
+        return NULL;
+    }
+    t_fold = f;
+    return f;
+}
+
+static double* fold_buffer(size_t count) {
+    FoldBuffers* f = fold_buffers();
+    if (!f) return NULL;
+    if (count > f->cap) {
+        double* p = realloc(f->w, count * sizeof(double));
+        if (!p) {
+            perror("fold_buffer");
+            return NULL;
+        }
+        f->w = p;
+        f->cap = count;
+    }
+    return f->w;
+}
+
+// Evaluates loss(fold(w)) through the unfused objective
+static double fused_loss(const FeatureTransform* t, double (*loss)(double*, int), double* weights, int dim) {
+    double* raw = fold_buffer(dim);
+    if (!raw) return -1;
+    transform_fold_weights(t, weights, raw, 1);
+    return loss(raw, dim);
+}
+
+static void fused_grad(const FeatureTransform* t, void (*grad)(double*, double*, int), double* weights, double* grad_out, int dim) {
+    double* raw = fold_buffer(dim);
+    if (!raw) return;
+    transform_fold_weights(t, weights, raw, 1);
+    grad(raw, grad_out, dim);
+    transform_unfold_grad(t, grad_out, 1);
+}
+
+// Softmax rows are separate pointers; fold them through one contiguous k x d block
+static double** fold_rows(const FeatureTransform* t, double** W, int k, int d) {
+    double* block = fold_buffer((size_t)k * d);
+    if (!block) return NULL;
+    FoldBuffers* f = t_fold;
+    if (k > f->rows_cap) {
+        double** p = realloc(f->rows, k * sizeof(double*));
+        if (!p) {
+            perror("fold_rows");
+            return NULL;
+        }
+        f->rows = p;
+        f->rows_cap = k;
+    }
+    for (int c = 0; c < k; c++) {
+        f->rows[c] = block + (size_t)c * d;
+        memcpy(f->rows[c], W[c], d * sizeof(double));
+    }
+    transform_fold_weights(t, block, block, k);
+    return f->rows;
 }
 
 // y_pred = Xw
-double mse_loss(double* weights, int dim) {
+static double mse_loss_raw(double* weights, int dim) {
     if (!g_data) return -1;
 
+    PROF_BEGIN("mse_loss");
+    if (g_reducer) {
+        RowArgs a = { weights, NULL, dim, 1 };
+        double loss = reduced_loss(mse_loss_rows, &a, 0);
+        PROF_END();
+        return loss;
+    }
+    if (g_fixed && g_fixed->d == dim) {
+        double loss = g_fixed->mse_loss(weights, g_data->X, g_data->y, g_data->n);
+        PROF_END();
+        return loss;
+    }
+
     double loss = 0.0;
     for (int i = 0; i < g_data->n; i++) {
         double y_pred = 0.0;
@@ -26,12 +268,31 @@ double mse_loss(double* weights, int dim) {
         double error = y_pred - g_data->y[i];
         loss += error * error;
     }
+    PROF_END();
     return loss / g_data->n;
 }
 
-void mse_grad(double* weights, double* grad_out, int dim) {
+double mse_loss(double* weights, int dim) {
+    const FeatureTransform* t = g_transform;
+    return t ? fused_loss(t, mse_loss_raw, weights, dim) : mse_loss_raw(weights, dim);
+}
+
+static void mse_grad_raw(double* weights, double* grad_out, int dim) {
     if (!g_data) return;
 
+    PROF_BEGIN("mse_grad");
+    if (g_reducer) {
+        RowArgs a = { weights, NULL, dim, 1 };
+        reduced_grad(mse_grad_rows, &a, grad_out);
+        PROF_END();
+        return;
+    }
+    if (g_fixed && g_fixed->d == dim) {
+        g_fixed->mse_grad(weights, g_data->X, g_data->y, g_data->n, grad_out);
+        PROF_END();
+        return;
+    }
+
     for (int j = 0; j < dim; j++) grad_out[j] = 0.0;
 
     for (int i = 0; i < g_data->n; i++) {
@@ -48,6 +309,13 @@ void mse_grad(double* weights, double* grad_out, int dim) {
     for (int j = 0; j < dim; j++) {
         grad_out[j] /= g_data->n;
     }
+    PROF_END();
+}
+
+void mse_grad(double* weights, double* grad_out, int dim) {
+    const FeatureTransform* t = g_transform;
+    if (t) fused_grad(t, mse_grad_raw, weights, grad_out, dim);
+    else mse_grad_raw(weights, grad_out, dim);
 }
 
 
@@ -57,9 +325,17 @@ static double sigmoid(double z) {
     return 1.0 / (1.0 + exp(-z));
 }
 
-double logistic_loss(double* weights, int dim) {
+static double logistic_loss_raw(double* weights, int dim) {
     if (!g_data) return -1;
 
+    PROF_BEGIN("logistic_loss");
+    if (g_reducer) {
+        RowArgs a = { weights, NULL, dim, 1 };
+        double loss = reduced_loss(logistic_loss_rows, &a, 0);
+        PROF_END();
+        return loss;
+    }
+
     double loss = 0.0;
     for (int i = 0; i < g_data->n; i++) {
         double z = 0.0;
@@ -70,12 +346,31 @@ double logistic_loss(double* weights, int dim) {
         double y = g_data->y[i];
         loss += -y * log(pred + 1e-8) - (1 - y) * log(1 - pred + 1e-8);
     }
+    PROF_END();
     return loss / g_data->n;
 }
 
-void logistic_grad(double* weights, double* grad_out, int dim) {
+double logistic_loss(double* weights, int dim) {
+    const FeatureTransform* t = g_transform;
+    return t ? fused_loss(t, logistic_loss_raw, weights, dim) : logistic_loss_raw(weights, dim);
+}
+
+static void logistic_grad_raw(double* weights, double* grad_out, int dim) {
     if (!g_data) return;
 
+    PROF_BEGIN("logistic_grad");
+    if (g_reducer) {
+        RowArgs a = { weights, NULL, dim, 1 };
+        reduced_grad(logistic_grad_rows, &a, grad_out);
+        PROF_END();
+        return;
+    }
+    if (g_fixed && g_fixed->d == dim) {
+        g_fixed->logistic_grad(weights, g_data->X, g_data->y, g_data->n, grad_out);
+        PROF_END();
+        return;
+    }
+
     for (int j = 0; j < dim; j++) grad_out[j] = 0.0;
 
     for (int i = 0; i < g_data->n; i++) {
@@ -94,6 +389,58 @@ void logistic_grad(double* weights, double* grad_out, int dim) {
     for (int j = 0; j < dim; j++) {
         grad_out[j] /= g_data->n;
     }
+    PROF_END();
+}
+
+void logistic_grad(double* weights, double* grad_out, int dim) {
+    const FeatureTransform* t = g_transform;
+    if (t) fused_grad(t, logistic_grad_raw, weights, grad_out, dim);
+    else logistic_grad_raw(weights, grad_out, dim);
+}
+
+
+// Per-sample losses
+double sample_loss(LossType type, double z, double y) {
+    if (type == LOSS_MSE) {
+        double error = z - y;
+        return error * error;
+    }
+    double pred = sigmoid(z);
+    return -y * log(pred + 1e-8) - (1 - y) * log(1 - pred + 1e-8);
+}
+
+double sample_dloss(LossType type, double z, double y) {
+    if (type == LOSS_MSE) return 2 * (z - y);
+    return sigmoid(z) - y;
+}
+
+void sample_grad(LossType type, const double* w, const double* x, double y, int d, double* grad_out) {
+    double z = 0.0;
+    for (int j = 0; j < d; j++) z += w[j] * x[j];
+    double g = sample_dloss(type, z, y);
+    for (int j = 0; j < d; j++) grad_out[j] = g * x[j];
+}
+
+double sparse_loss(LossType type, const SparseDataset* data, const double* w) {
+    double loss = 0.0;
+    for (int i = 0; i < data->n; i++) {
+        double z = 0.0;
+        for (int k = data->row_ptr[i]; k < data->row_ptr[i + 1]; k++)
+            z += w[data->idx[k]] * data->val[k];
+        loss += sample_loss(type, z, data->y[i]);
+    }
+    return loss / data->n;
+}
+
+
+double multi_target_loss(double* W, int dim) {
+    if (!g_data || dim != g_data->m * g_data->d) return -1;
+    return multi_mse(g_data, W, NULL);
+}
+
+void multi_target_grad(double* W, double* grad_out, int dim) {
+    if (!g_data || dim != g_data->m * g_data->d) return;
+    multi_mse_grad(g_data, W, grad_out);
 }
 
 
@@ -111,9 +458,17 @@ void compute_softmax(double* z, double* softmax_out, int k) {
     for (int i = 0; i < k; i++) softmax_out[i] /= sum;
 }
 
-double softmax_loss(double** W, int k, int d) {
+static double softmax_loss_raw(double** W, int k, int d) {
     if (!g_data) return -1;
 
+    PROF_BEGIN("softmax_loss");
+    if (g_reducer) {
+        RowArgs a = { NULL, W, d, k };
+        double loss = reduced_loss(softmax_loss_rows, &a, 2 * k);
+        PROF_END();
+        return loss;
+    }
+
     double loss = 0.0;
     double* z = (double*)malloc(k * sizeof(double));
     double* prob = (double*)malloc(k * sizeof(double));
@@ -134,13 +489,31 @@ double softmax_loss(double** W, int k, int d) {
 
     free(z);
     free(prob);
+    PROF_END();
     return loss / g_data->n;
 }
 
+double softmax_loss(double** W, int k, int d) {
+    const FeatureTransform* t = g_transform;
+    if (!t) return softmax_loss_raw(W, k, d);
+    double** raw = fold_rows(t, W, k, d);
+    return raw ? softmax_loss_raw(raw, k, d) : -1;
+}
 
-void softmax_grad(double** W, double** grad_out, int k, int d) {
+
+static void softmax_grad_raw(double** W, double** grad_out, int k, int d) {
     if (!g_data) return;
 
+    PROF_BEGIN("softmax_grad");
+    if (g_reducer) {
+        RowArgs a = { NULL, W, d, k };
+        const double* sum = reducer_sum(g_reducer, g_data->n, k * d, 2 * k, softmax_grad_rows, &a, NULL);
+        for (int c = 0; c < k; c++)
+            for (int j = 0; j < d; j++) grad_out[c][j] = sum ? sum[(size_t)c * d + j] / g_data->n : 0.0;
+        PROF_END();
+        return;
+    }
+
     for (int c = 0; c < k; c++)
         for (int j = 0; j < d; j++)
             grad_out[c][j] = 0.0;
@@ -174,12 +547,82 @@ void softmax_grad(double** W, double** grad_out, int k, int d) {
 
     free(z);
     free(prob);
+    PROF_END();
+}
+
+void softmax_grad(double** W, double** grad_out, int k, int d) {
+    const FeatureTransform* t = g_transform;
+    if (!t) {
+        softmax_grad_raw(W, grad_out, k, d);
+        return;
+    }
+    double** raw = fold_rows(t, W, k, d);
+    if (!raw) return;
+    softmax_grad_raw(raw, grad_out, k, d);
+    for (int c = 0; c < k; c++) transform_unfold_grad(t, grad_out[c], 1);
+}
+
+
+// Regularized objectives
+
+void set_penalty(double l1, double l2) {
+    g_l1 = l1;
+    g_l2 = l2;
+}
+
+double penalty_value(const double* w, int dim) {
+    double p = 0.0;
+    for (int j = 1; j < dim; j++) p += g_l1 * fabs(w[j]) + 0.5 * g_l2 * w[j] * w[j];
+    return p;
+}
+
+static void add_penalty_grad(const double* w, double* grad_out, int dim) {
+    for (int j = 1; j < dim; j++) {
+        double sign = w[j] > 0 ? 1.0 : (w[j] < 0 ? -1.0 : 0.0);
+        grad_out[j] += g_l1 * sign + g_l2 * w[j];
+    }
+}
+
+double reg_mse_loss(double* weights, int dim) {
+    if (!g_data) return -1;
+    return mse_loss(weights, dim) + penalty_value(weights, dim);
+}
+
+void reg_mse_grad(double* weights, double* grad_out, int dim) {
+    if (!g_data) return;
+    mse_grad(weights, grad_out, dim);
+    add_penalty_grad(weights, grad_out, dim);
+}
+
+double reg_logistic_loss(double* weights, int dim) {
+    if (!g_data) return -1;
+    return logistic_loss(weights, dim) + penalty_value(weights, dim);
+}
+
+void reg_logistic_grad(double* weights, double* grad_out, int dim) {
+    if (!g_data) return;
+    logistic_grad(weights, grad_out, dim);
+    add_penalty_grad(weights, grad_out, dim);
+}
+
+double reg_softmax_loss(double** W, int k, int d) {
+    if (!g_data) return -1;
+    double loss = softmax_loss(W, k, d);
+    for (int c = 0; c < k; c++) loss += penalty_value(W[c], d);
+    return loss;
+}
+
+void reg_softmax_grad(double** W, double** grad_out, int k, int d) {
+    if (!g_data) return;
+    softmax_grad(W, grad_out, k, d);
+    for (int c = 0; c < k; c++) add_penalty_grad(W[c], grad_out[c], d);
 }
 
 
 void train_logistic(Dataset* data, double* w, double lr, int max_iter) {
     int n = data->n;
     int d = data->d;
+    PROF_BEGIN("train_logistic");
     double* grad = malloc(d * sizeof(double));
 
     for (int iter = 0; iter < max_iter; iter++) {
@@ -200,10 +643,333 @@ void train_logistic(Dataset* data, double* w, double lr, int max_iter) {
     }
 
     free(grad);
+    PROF_END();
 }
 
 double predict_sample(double* w, double* x, int d) {
+    const FixedKernels* fk = g_use_fixed ? fixed_kernels(d) : NULL;
+    if (fk) return sigmoid(fk->dot(w, x));
+
     double z = 0;
     for (int i = 0; i < d; i++) z += w[i] * x[i];
     return sigmoid(z);
-}
\ No newline at end of file
+}
+
+// Saved models
+
+#define MODEL_MAGIC 0x54504F43u  // "COPT"
+#define MODEL_VERSION 1u
+
+Model* create_model(ModelType type, int k, int d) {
+    Model* m = malloc(sizeof(Model));
+    if (!m) return NULL;
+    m->type = type;
+    m->k = k;
+    m->d = d;
+    m->W = calloc((size_t)k * d, sizeof(double));
+    if (!m->W) {
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void free_model(Model* m) {
+    if (!m) return;
+    free(m->W);
+    free(m);
+}
+
+int write_model(FILE* f, const Model* m) {
+    unsigned int header[2] = { MODEL_MAGIC, MODEL_VERSION };
+    int shape[3] = { (int)m->type, m->k, m->d };
+    size_t count = (size_t)m->k * m->d;
+    int ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+             fwrite(shape, sizeof(shape), 1, f) == 1 &&
+             fwrite(m->W, sizeof(double), count, f) == count;
+    return ok ? 0 : -1;
+}
+
+int save_model(const char* filename, const Model* m) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        perror("Model file error");
+        return -1;
+    }
+
+    int ok = write_model(f, m) == 0;
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+Model* load_model(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        perror("Model file error");
+        return NULL;
+    }
+
+    unsigned int header[2];
+    int shape[3];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != MODEL_MAGIC || header[1] != MODEL_VERSION ||
+        fread(shape, sizeof(shape), 1, f) != 1 || shape[1] <= 0 || shape[2] <= 0 ||
+        shape[0] < MODEL_LINEAR || shape[0] > MODEL_OVR) {
+        fprintf(stderr, "%s: not a model file\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    Model* m = create_model((ModelType)shape[0], shape[1], shape[2]);
+    size_t count = (size_t)shape[1] * shape[2];
+    if (m && fread(m->W, sizeof(double), count, f) != count) {
+        fprintf(stderr, "%s: truncated model file\n", filename);
+        free_model(m);
+        m = NULL;
+    }
+
+    fclose(f);
+    return m;
+}
+
+static void emit_binary(ModelType type, double z, double* score, int* label) {
+    if (type == MODEL_LINEAR) {
+        if (score) *score = z;
+        if (label) *label = 0;
+    } else {
+        double p = sigmoid(z);
+        if (score) *score = p;
+        if (label) *label = p >= 0.5;
+    }
+}
+
+// Batched argmax over the k rows: four input rows share every weight row load, and each
+// keeps its running max (plus the rescaled exp sum for softmax) instead of k margins
+static void predict_multiclass(const Model* m, const double* X, int n, double* scores_out, int* labels_out) {
+    int d = m->d, softmax = m->type == MODEL_SOFTMAX;
+    for (int i0 = 0; i0 < n; i0 += 4) {
+        int rows = n - i0 < 4 ? n - i0 : 4;
+        const double* x[4];
+        for (int r = 0; r < 4; r++) x[r] = X + (size_t)(i0 + (r < rows ? r : 0)) * d;
+
+        double z_max[4] = { -INFINITY, -INFINITY, -INFINITY, -INFINITY };
+        double sum[4] = { 0.0, 0.0, 0.0, 0.0 };
+        int best[4] = { 0, 0, 0, 0 };
+        for (int c = 0; c < m->k; c++) {
+            const double* w = m->W + (size_t)c * d;
+            double z[4] = { 0.0, 0.0, 0.0, 0.0 };
+            for (int j = 0; j < d; j++) {
+                double wj = w[j];
+                z[0] += wj * x[0][j];
+                z[1] += wj * x[1][j];
+                z[2] += wj * x[2][j];
+                z[3] += wj * x[3][j];
+            }
+            for (int r = 0; r < 4; r++) {
+                if (z[r] > z_max[r]) {
+                    if (softmax) sum[r] = sum[r] * exp(z_max[r] - z[r]) + 1.0;
+                    z_max[r] = z[r];
+                    best[r] = c;
+                } else if (softmax) {
+                    sum[r] += exp(z[r] - z_max[r]);
+                }
+            }
+        }
+
+        for (int r = 0; r < rows; r++) {
+            if (scores_out) scores_out[i0 + r] = softmax ? 1.0 / sum[r] : sigmoid(z_max[r]);
+            if (labels_out) labels_out[i0 + r] = best[r];
+        }
+    }
+}
+
+void predict_batch(const Model* m, const double* X, int n, double* scores_out, int* labels_out) {
+    int d = m->d;
+
+    PROF_BEGIN("predict_batch");
+    if (m->type == MODEL_SOFTMAX || m->type == MODEL_OVR) {
+        predict_multiclass(m, X, n, scores_out, labels_out);
+        PROF_END();
+        return;
+    }
+
+    // Four rows per pass so each weight load feeds four independent accumulators
+    const double* w = m->W;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const double* x0 = X + (size_t)i * d;
+        const double* x1 = x0 + d;
+        const double* x2 = x1 + d;
+        const double* x3 = x2 + d;
+        double z0 = 0.0, z1 = 0.0, z2 = 0.0, z3 = 0.0;
+        for (int j = 0; j < d; j++) {
+            double wj = w[j];
+            z0 += wj * x0[j];
+            z1 += wj * x1[j];
+            z2 += wj * x2[j];
+            z3 += wj * x3[j];
+        }
+        emit_binary(m->type, z0, scores_out ? &scores_out[i] : NULL, labels_out ? &labels_out[i] : NULL);
+        emit_binary(m->type, z1, scores_out ? &scores_out[i + 1] : NULL, labels_out ? &labels_out[i + 1] : NULL);
+        emit_binary(m->type, z2, scores_out ? &scores_out[i + 2] : NULL, labels_out ? &labels_out[i + 2] : NULL);
+        emit_binary(m->type, z3, scores_out ? &scores_out[i + 3] : NULL, labels_out ? &labels_out[i + 3] : NULL);
+    }
+    for (; i < n; i++) {
+        const double* x = X + (size_t)i * d;
+        double z = 0.0;
+        for (int j = 0; j < d; j++) z += w[j] * x[j];
+        emit_binary(m->type, z, scores_out ? &scores_out[i] : NULL, labels_out ? &labels_out[i] : NULL);
+    }
+    PROF_END();
+}
+
+
+// Sparse models
+
+#define SPARSE_MODEL_MAGIC 0x53504F43u  // "COPS"
+#define SPARSE_MODEL_VERSION 1u
+
+static SparseModel* create_sparse_model(ModelType type, int k, int d, int nnz) {
+    SparseModel* sm = malloc(sizeof(SparseModel));
+    if (!sm) return NULL;
+    sm->type = type;
+    sm->k = k;
+    sm->d = d;
+    sm->nnz = nnz;
+    sm->row_ptr = calloc(k + 1, sizeof(int));
+    sm->idx = malloc((nnz > 0 ? nnz : 1) * sizeof(int));
+    sm->val = malloc((nnz > 0 ? nnz : 1) * sizeof(double));
+    if (!sm->row_ptr || !sm->idx || !sm->val) {
+        free_sparse_model(sm);
+        return NULL;
+    }
+    return sm;
+}
+
+SparseModel* sparse_model_from(const Model* m) {
+    size_t count = (size_t)m->k * m->d;
+    int nnz = 0;
+    for (size_t t = 0; t < count; t++) nnz += m->W[t] != 0.0;
+
+    SparseModel* sm = create_sparse_model(m->type, m->k, m->d, nnz);
+    if (!sm) return NULL;
+    int t = 0;
+    for (int c = 0; c < m->k; c++) {
+        sm->row_ptr[c] = t;
+        for (int j = 0; j < m->d; j++) {
+            double v = m->W[(size_t)c * m->d + j];
+            if (v == 0.0) continue;
+            sm->idx[t] = j;
+            sm->val[t] = v;
+            t++;
+        }
+    }
+    sm->row_ptr[m->k] = t;
+    return sm;
+}
+
+Model* sparse_model_to_dense(const SparseModel* sm) {
+    Model* m = create_model(sm->type, sm->k, sm->d);
+    if (!m) return NULL;
+    for (int c = 0; c < sm->k; c++)
+        for (int t = sm->row_ptr[c]; t < sm->row_ptr[c + 1]; t++)
+            m->W[(size_t)c * sm->d + sm->idx[t]] = sm->val[t];
+    return m;
+}
+
+void free_sparse_model(SparseModel* sm) {
+    if (!sm) return;
+    free(sm->row_ptr);
+    free(sm->idx);
+    free(sm->val);
+    free(sm);
+}
+
+int save_sparse_model(const char* filename, const SparseModel* sm) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        perror("Model file error");
+        return -1;
+    }
+
+    unsigned int header[2] = { SPARSE_MODEL_MAGIC, SPARSE_MODEL_VERSION };
+    int shape[4] = { (int)sm->type, sm->k, sm->d, sm->nnz };
+    int ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+             fwrite(shape, sizeof(shape), 1, f) == 1 &&
+             fwrite(sm->row_ptr, sizeof(int), sm->k + 1, f) == (size_t)sm->k + 1 &&
+             fwrite(sm->idx, sizeof(int), sm->nnz, f) == (size_t)sm->nnz &&
+             fwrite(sm->val, sizeof(double), sm->nnz, f) == (size_t)sm->nnz;
+
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+SparseModel* load_sparse_model(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        perror("Model file error");
+        return NULL;
+    }
+
+    unsigned int header[2];
+    int shape[4];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != SPARSE_MODEL_MAGIC ||
+        header[1] != SPARSE_MODEL_VERSION || fread(shape, sizeof(shape), 1, f) != 1 ||
+        shape[1] <= 0 || shape[2] <= 0 || shape[3] < 0 || (long long)shape[3] > (long long)shape[1] * shape[2] ||
+        shape[0] < MODEL_LINEAR || shape[0] > MODEL_OVR) {
+        fprintf(stderr, "%s: not a sparse model file\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    SparseModel* sm = create_sparse_model((ModelType)shape[0], shape[1], shape[2], shape[3]);
+    int ok = sm &&
+             fread(sm->row_ptr, sizeof(int), sm->k + 1, f) == (size_t)sm->k + 1 &&
+             fread(sm->idx, sizeof(int), sm->nnz, f) == (size_t)sm->nnz &&
+             fread(sm->val, sizeof(double), sm->nnz, f) == (size_t)sm->nnz;
+    fclose(f);
+
+    // Offsets and indices come from the file; check them before anyone indexes with them
+    if (ok) {
+        ok = sm->row_ptr[0] == 0 && sm->row_ptr[sm->k] == sm->nnz;
+        for (int c = 0; ok && c < sm->k; c++) ok = sm->row_ptr[c] <= sm->row_ptr[c + 1];
+        for (int t = 0; ok && t < sm->nnz; t++) ok = sm->idx[t] >= 0 && sm->idx[t] < sm->d;
+    }
+    if (!ok) {
+        if (sm) fprintf(stderr, "%s: truncated or corrupt sparse model file\n", filename);
+        free_sparse_model(sm);
+        return NULL;
+    }
+    return sm;
+}
+
+void predict_sparse_batch(const SparseModel* sm, const double* X, int n, double* scores_out, int* labels_out) {
+    int d = sm->d;
+
+    PROF_BEGIN("predict_sparse_batch");
+    for (int i = 0; i < n; i++) {
+        const double* x = X + (size_t)i * d;
+        if (sm->type != MODEL_SOFTMAX && sm->type != MODEL_OVR) {
+            double z = 0.0;
+            for (int t = sm->row_ptr[0]; t < sm->row_ptr[1]; t++) z += sm->val[t] * x[sm->idx[t]];
+            emit_binary(sm->type, z, scores_out ? &scores_out[i] : NULL, labels_out ? &labels_out[i] : NULL);
+            continue;
+        }
+
+        double z_max = -INFINITY, sum = 0.0;
+        int best = 0;
+        for (int c = 0; c < sm->k; c++) {
+            double z = 0.0;
+            for (int t = sm->row_ptr[c]; t < sm->row_ptr[c + 1]; t++) z += sm->val[t] * x[sm->idx[t]];
+            if (z > z_max) {
+                sum = sum * exp(z_max - z) + 1.0;
+                z_max = z;
+                best = c;
+            } else {
+                sum += exp(z - z_max);
+            }
+        }
+        if (scores_out) scores_out[i] = sm->type == MODEL_OVR ? sigmoid(z_max) : 1.0 / sum;
+        if (labels_out) labels_out[i] = best;
+    }
+    PROF_END();
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/multiclass.h"
+#include "../include/optim.h"
+#include "../include/pool.h"
+#include "../include/prof.h"
+
+OvrConfig ovr_default_config(void) {
+    OvrConfig cfg;
+    cfg.num_threads = 0;
+    cfg.max_iter = 200;
+    cfg.lr = 0.05;
+    cfg.l2 = 1e-4;
+    cfg.tol = 1e-4;
+    return cfg;
+}
+
+typedef struct {
+    const Dataset* data;
+    const OvrConfig* cfg;
+    int cls;
+    double* w;          // this class's row of the model
+    int iters;
+} OvrTask;
+
+// Mean logistic gradient for targets [y_i == cls], plus the ridge term
+static void class_grad(const OvrTask* t, const double* w, double* g) {
+    const Dataset* data = t->data;
+    int d = data->d;
+    memset(g, 0, d * sizeof(double));
+    for (int i = 0; i < data->n; i++) {
+        const double* x = data->X[i];
+        double z = 0.0;
+        for (int j = 0; j < d; j++) z += w[j] * x[j];
+        double e = 1.0 / (1.0 + exp(-z)) - (data->y[i] == t->cls ? 1.0 : 0.0);
+        for (int j = 0; j < d; j++) g[j] += e * x[j];
+    }
+    for (int j = 0; j < d; j++) g[j] /= data->n;
+    for (int j = 1; j < d; j++) g[j] += t->cfg->l2 * w[j];
+}
+
+static void train_class(void* arg) {
+    OvrTask* t = arg;
+    int d = t->data->d;
+    OptimizerParams params = optimizer_default_params(OPT_ADAM);
+    params.lr = t->cfg->lr;
+    Optimizer* opt = optimizer_create(&params, NULL, d);
+    double* g = malloc(d * sizeof(double));
+
+    int it = 0;
+    while (it < t->cfg->max_iter) {
+        class_grad(t, optimizer_eval_point(opt, t->w), g);
+        double gmax = 0.0;
+        for (int j = 0; j < d; j++) gmax = fmax(gmax, fabs(g[j]));
+        if (gmax < t->cfg->tol) break;
+        optimizer_apply(opt, t->w, g);
+        it++;
+    }
+    t->iters = it;
+
+    free(g);
+    optimizer_destroy(opt);
+}
+
+Model* train_ovr(const Dataset* data, int num_classes, const OvrConfig* cfg, int* iters_out) {
+    if (num_classes <= 0)
+        for (int i = 0; i < data->n; i++)
+            if ((int)data->y[i] + 1 > num_classes) num_classes = (int)data->y[i] + 1;
+    if (num_classes <= 0) return NULL;
+
+    PROF_BEGIN("train_ovr");
+    Model* m = create_model(MODEL_OVR, num_classes, data->d);
+    OvrTask* tasks = malloc(num_classes * sizeof(OvrTask));
+    ThreadPool* pool = pool_create(cfg->num_threads);
+    if (!m || !tasks || !pool) {
+        free_model(m);
+        free(tasks);
+        if (pool) pool_destroy(pool);
+        PROF_END();
+        return NULL;
+    }
+
+    for (int c = 0; c < num_classes; c++) {
+        tasks[c].data = data;
+        tasks[c].cfg = cfg;
+        tasks[c].cls = c;
+        tasks[c].w = m->W + (size_t)c * data->d;
+        tasks[c].iters = 0;
+        pool_submit(pool, train_class, &tasks[c]);
+    }
+    pool_wait(pool);
+    pool_destroy(pool);
+
+    if (iters_out)
+        for (int c = 0; c < num_classes; c++) iters_out[c] = tasks[c].iters;
+    free(tasks);
+    PROF_END();
+    return m;
+}
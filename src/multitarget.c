@@ -0,0 +1,271 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/multitarget.h"
+#include "../include/prof.h"
+
+// P[r * m + t] = W[t] . x_r for R rows, in 2 x 4 register blocks: each load of
+// x feeds four targets and each weight load two rows
+static void tile_products(const double* const* X, int R, const double* W, int m, int d, double* P) {
+    int t = 0;
+    for (; t + 4 <= m; t += 4) {
+        const double* w0 = W + (size_t)t * d;
+        const double* w1 = w0 + d;
+        const double* w2 = w1 + d;
+        const double* w3 = w2 + d;
+        int r = 0;
+        for (; r + 2 <= R; r += 2) {
+            const double* x = X[r];
+            const double* u = X[r + 1];
+            double a0 = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+            double b0 = 0.0, b1 = 0.0, b2 = 0.0, b3 = 0.0;
+            for (int j = 0; j < d; j++) {
+                double xj = x[j], uj = u[j];
+                a0 += w0[j] * xj;
+                a1 += w1[j] * xj;
+                a2 += w2[j] * xj;
+                a3 += w3[j] * xj;
+                b0 += w0[j] * uj;
+                b1 += w1[j] * uj;
+                b2 += w2[j] * uj;
+                b3 += w3[j] * uj;
+            }
+            double* p = P + (size_t)r * m + t;
+            p[0] = a0;
+            p[1] = a1;
+            p[2] = a2;
+            p[3] = a3;
+            p += m;
+            p[0] = b0;
+            p[1] = b1;
+            p[2] = b2;
+            p[3] = b3;
+        }
+        for (; r < R; r++) {
+            const double* x = X[r];
+            double z0 = 0.0, z1 = 0.0, z2 = 0.0, z3 = 0.0;
+            for (int j = 0; j < d; j++) {
+                double xj = x[j];
+                z0 += w0[j] * xj;
+                z1 += w1[j] * xj;
+                z2 += w2[j] * xj;
+                z3 += w3[j] * xj;
+            }
+            double* p = P + (size_t)r * m + t;
+            p[0] = z0;
+            p[1] = z1;
+            p[2] = z2;
+            p[3] = z3;
+        }
+    }
+    for (; t < m; t++) {
+        const double* w = W + (size_t)t * d;
+        for (int r = 0; r < R; r++) {
+            const double* x = X[r];
+            double z = 0.0;
+            for (int j = 0; j < d; j++) z += w[j] * x[j];
+            P[(size_t)r * m + t] = z;
+        }
+    }
+}
+
+// G[t] += sum_r E[r * m + t] * x_r; two rows per update halve the loads and stores of G
+static void tile_accumulate(const double* const* X, int R, const double* E, int m, int d, double* G) {
+    int t = 0;
+    for (; t + 4 <= m; t += 4) {
+        double* g0 = G + (size_t)t * d;
+        double* g1 = g0 + d;
+        double* g2 = g1 + d;
+        double* g3 = g2 + d;
+        int r = 0;
+        for (; r + 2 <= R; r += 2) {
+            const double* x = X[r];
+            const double* u = X[r + 1];
+            const double* e = E + (size_t)r * m + t;
+            const double* f = e + m;
+            double e0 = e[0], e1 = e[1], e2 = e[2], e3 = e[3];
+            double f0 = f[0], f1 = f[1], f2 = f[2], f3 = f[3];
+            for (int j = 0; j < d; j++) {
+                double xj = x[j], uj = u[j];
+                g0[j] += e0 * xj + f0 * uj;
+                g1[j] += e1 * xj + f1 * uj;
+                g2[j] += e2 * xj + f2 * uj;
+                g3[j] += e3 * xj + f3 * uj;
+            }
+        }
+        for (; r < R; r++) {
+            const double* x = X[r];
+            const double* e = E + (size_t)r * m + t;
+            double e0 = e[0], e1 = e[1], e2 = e[2], e3 = e[3];
+            for (int j = 0; j < d; j++) {
+                double xj = x[j];
+                g0[j] += e0 * xj;
+                g1[j] += e1 * xj;
+                g2[j] += e2 * xj;
+                g3[j] += e3 * xj;
+            }
+        }
+    }
+    for (; t < m; t++) {
+        double* g = G + (size_t)t * d;
+        for (int r = 0; r < R; r++) {
+            const double* x = X[r];
+            double e = E[(size_t)r * m + t];
+            for (int j = 0; j < d; j++) g[j] += e * x[j];
+        }
+    }
+}
+
+static int check_targets(const Dataset* data, const char* who) {
+    if (data->m > 0 && data->Y) return 1;
+    fprintf(stderr, "%s: dataset has no target matrix\n", who);
+    return 0;
+}
+
+// Shared pass for the loss and, when G != NULL, its gradient
+static double mse_pass(const Dataset* data, const double* W, double* per_target_out, double* G) {
+    int n = data->n, d = data->d, m = data->m;
+    double* E = malloc((size_t)MULTI_TILE_ROWS * m * sizeof(double));
+    double* sums = calloc(m, sizeof(double));
+    if (G) memset(G, 0, (size_t)m * d * sizeof(double));
+
+    for (int r0 = 0; r0 < n; r0 += MULTI_TILE_ROWS) {
+        int R = n - r0 < MULTI_TILE_ROWS ? n - r0 : MULTI_TILE_ROWS;
+        const double* const* X = (const double* const*)data->X + r0;
+        tile_products(X, R, W, m, d, E);
+
+        const double* Y = data->Y + (size_t)r0 * m;
+        for (size_t k = 0; k < (size_t)R * m; k++) E[k] -= Y[k];
+        for (int r = 0; r < R; r++) {
+            const double* e = E + (size_t)r * m;
+            for (int t = 0; t < m; t++) sums[t] += e[t] * e[t];
+        }
+        if (G) tile_accumulate(X, R, E, m, d, G);
+    }
+
+    double total = 0.0;
+    for (int t = 0; t < m; t++) {
+        sums[t] /= n;
+        total += sums[t];
+        if (per_target_out) per_target_out[t] = sums[t];
+    }
+    if (G) {
+        double scale = 2.0 / n;
+        for (size_t k = 0; k < (size_t)m * d; k++) G[k] *= scale;
+    }
+    free(E);
+    free(sums);
+    return total;
+}
+
+double multi_mse(const Dataset* data, const double* W, double* per_target_out) {
+    if (!check_targets(data, "multi_mse")) return -1;
+    PROF_BEGIN("multi_mse");
+    double loss = mse_pass(data, W, per_target_out, NULL);
+    PROF_END();
+    return loss;
+}
+
+double multi_mse_grad(const Dataset* data, const double* W, double* G) {
+    if (!check_targets(data, "multi_mse_grad")) return -1;
+    PROF_BEGIN("multi_mse_grad");
+    double loss = mse_pass(data, W, NULL, G);
+    PROF_END();
+    return loss;
+}
+
+
+// Closed form
+
+// In-place lower Cholesky factor of the d x d matrix A; -1 if not positive definite
+static int cholesky(double* A, int d) {
+    for (int j = 0; j < d; j++) {
+        double* aj = A + (size_t)j * d;
+        double diag = aj[j];
+        for (int l = 0; l < j; l++) diag -= aj[l] * aj[l];
+        if (diag <= 0.0) return -1;
+        double ljj = sqrt(diag);
+        aj[j] = ljj;
+        for (int i = j + 1; i < d; i++) {
+            double* ai = A + (size_t)i * d;
+            double s = ai[j];
+            for (int l = 0; l < j; l++) s -= ai[l] * aj[l];
+            ai[j] = s / ljj;
+        }
+    }
+    return 0;
+}
+
+int multi_ridge_solve(const Dataset* data, double l2, double* W) {
+    if (!check_targets(data, "multi_ridge_solve")) return -1;
+    PROF_BEGIN("multi_ridge_solve");
+    int n = data->n, d = data->d, m = data->m;
+    double* A = calloc((size_t)d * d, sizeof(double));
+    double* B = calloc((size_t)d * m, sizeof(double));
+
+    // One pass: upper triangle of X^T X and all of X^T Y
+    for (int i = 0; i < n; i++) {
+        const double* x = data->X[i];
+        const double* y = data->Y + (size_t)i * m;
+        for (int j = 0; j < d; j++) {
+            double xj = x[j];
+            if (xj == 0.0) continue;
+            double* aj = A + (size_t)j * d;
+            for (int l = j; l < d; l++) aj[l] += xj * x[l];
+            double* bj = B + (size_t)j * m;
+            for (int t = 0; t < m; t++) bj[t] += xj * y[t];
+        }
+    }
+
+    // Normal equations of (1/n)||XW^T - Y||² + l2/2 ||W_{:,1:}||²: (X^T X + (n l2 / 2) I') W^T = X^T Y
+    for (int j = 0; j < d; j++) {
+        for (int l = 0; l < j; l++) A[(size_t)j * d + l] = A[(size_t)l * d + j];
+        if (j > 0) A[(size_t)j * d + j] += 0.5 * n * l2;
+    }
+
+    int rc = cholesky(A, d);
+    if (rc == 0) {
+        // L Z = B, then L^T V = Z, one row of m right-hand sides at a time
+        for (int j = 0; j < d; j++) {
+            double* bj = B + (size_t)j * m;
+            for (int l = 0; l < j; l++) {
+                double a = A[(size_t)j * d + l];
+                const double* bl = B + (size_t)l * m;
+                for (int t = 0; t < m; t++) bj[t] -= a * bl[t];
+            }
+            double inv = 1.0 / A[(size_t)j * d + j];
+            for (int t = 0; t < m; t++) bj[t] *= inv;
+        }
+        for (int j = d - 1; j >= 0; j--) {
+            double* bj = B + (size_t)j * m;
+            for (int l = j + 1; l < d; l++) {
+                double a = A[(size_t)l * d + j];
+                const double* bl = B + (size_t)l * m;
+                for (int t = 0; t < m; t++) bj[t] -= a * bl[t];
+            }
+            double inv = 1.0 / A[(size_t)j * d + j];
+            for (int t = 0; t < m; t++) bj[t] *= inv;
+        }
+        for (int t = 0; t < m; t++)
+            for (int j = 0; j < d; j++) W[(size_t)t * d + j] = B[(size_t)j * m + t];
+    } else {
+        fprintf(stderr, "multi_ridge_solve: X^T X + l2 I is not positive definite\n");
+    }
+
+    free(A);
+    free(B);
+    PROF_END();
+    return rc;
+}
+
+void predict_multi(const Model* m, const double* X, int n, double* out) {
+    PROF_BEGIN("predict_multi");
+    const double* rows[MULTI_TILE_ROWS];
+    for (int r0 = 0; r0 < n; r0 += MULTI_TILE_ROWS) {
+        int R = n - r0 < MULTI_TILE_ROWS ? n - r0 : MULTI_TILE_ROWS;
+        for (int r = 0; r < R; r++) rows[r] = X + (size_t)(r0 + r) * m->d;
+        tile_products(rows, R, m->W, m->k, m->d, out + (size_t)r0 * m->k);
+    }
+    PROF_END();
+}
@@ -0,0 +1,218 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/online.h"
+#include "../include/aligned.h"
+#include "../include/checkpoint.h"
+
+struct OnlineLearner {
+    OnlineConfig cfg;
+    Model* model;       // live weights
+    Model* snap;        // published copy, reused for every snapshot
+    int kd;             // rows * d weights
+
+    // Per-coordinate state, k x d like the weights
+    double* G;          // Adagrad: sum of g²; FTRL: n
+    double* z;          // FTRL only
+
+    double* score;      // k scratch margins / probabilities
+
+    long long rows;
+    double loss_sum, recent_loss;
+    long long correct;
+    double recent_acc;
+};
+
+OnlineConfig online_default_config(ModelType type, int k, int d) {
+    OnlineConfig cfg;
+    memset(&cfg, 0, sizeof(cfg));
+    cfg.type = type;
+    cfg.k = type == MODEL_SOFTMAX ? k : 1;
+    cfg.d = d;
+    cfg.rule = ONLINE_ADAGRAD;
+    cfg.lr = 0.1;
+    cfg.beta = 1.0;
+    cfg.l1 = 0.0;
+    cfg.l2 = 0.0;
+    cfg.epsilon = 1e-8;
+    cfg.decay = 0.999;
+    return cfg;
+}
+
+OnlineLearner* online_create(const OnlineConfig* cfg) {
+    int k = cfg->type == MODEL_SOFTMAX ? cfg->k : 1;
+    if (k <= 0 || cfg->d <= 0) return NULL;
+
+    OnlineLearner* ol = calloc(1, sizeof(OnlineLearner));
+    if (!ol) return NULL;
+    ol->cfg = *cfg;
+    ol->cfg.k = k;
+    ol->kd = k * cfg->d;
+    ol->model = create_model(cfg->type, k, cfg->d);
+    ol->snap = create_model(cfg->type, k, cfg->d);
+    ol->G = aligned_malloc(aligned_doubles(ol->kd) * sizeof(double));
+    ol->z = cfg->rule == ONLINE_FTRL ? aligned_malloc(aligned_doubles(ol->kd) * sizeof(double)) : NULL;
+    ol->score = malloc(k * sizeof(double));
+
+    if (!ol->model || !ol->snap || !ol->G || (cfg->rule == ONLINE_FTRL && !ol->z) || !ol->score) {
+        online_destroy(ol);
+        return NULL;
+    }
+    memset(ol->G, 0, ol->kd * sizeof(double));
+    if (ol->z) memset(ol->z, 0, ol->kd * sizeof(double));
+    return ol;
+}
+
+void online_destroy(OnlineLearner* ol) {
+    if (!ol) return;
+    if (ol->model) free_model(ol->model);
+    if (ol->snap) free_model(ol->snap);
+    aligned_free(ol->G);
+    aligned_free(ol->z);
+    free(ol->score);
+    free(ol);
+}
+
+
+// Per-coordinate updates for one weight row, given dloss/dmargin
+
+static void adagrad_row(OnlineLearner* ol, double* w, double* G, const double* x, double dz) {
+    double lr = ol->cfg.lr, eps = ol->cfg.epsilon;
+    for (int j = 0; j < ol->cfg.d; j++) {
+        double g = dz * x[j];
+        if (g == 0.0) continue;
+        G[j] += g * g;
+        w[j] -= lr * g / (sqrt(G[j]) + eps);
+    }
+}
+
+// FTRL-Proximal (McMahan et al.): w is recomputed in closed form from (z, n),
+// so coordinates whose |z| stays below l1 are held at exactly zero.
+static void ftrl_row(OnlineLearner* ol, double* w, double* n, double* z, const double* x, double dz) {
+    double alpha = ol->cfg.lr, beta = ol->cfg.beta, l1 = ol->cfg.l1, l2 = ol->cfg.l2;
+    for (int j = 0; j < ol->cfg.d; j++) {
+        double g = dz * x[j];
+        if (g == 0.0) continue;
+        double n_new = n[j] + g * g;
+        double sigma = (sqrt(n_new) - sqrt(n[j])) / alpha;
+        z[j] += g - sigma * w[j];
+        n[j] = n_new;
+
+        if (fabs(z[j]) <= l1) {
+            w[j] = 0.0;
+        } else {
+            double sign = z[j] < 0 ? -1.0 : 1.0;
+            w[j] = -(z[j] - sign * l1) / ((beta + sqrt(n_new)) / alpha + l2);
+        }
+    }
+}
+
+static void update_row(OnlineLearner* ol, int c, const double* x, double dz) {
+    size_t off = (size_t)c * ol->cfg.d;
+    if (ol->cfg.rule == ONLINE_FTRL)
+        ftrl_row(ol, ol->model->W + off, ol->G + off, ol->z + off, x, dz);
+    else
+        adagrad_row(ol, ol->model->W + off, ol->G + off, x, dz);
+}
+
+
+// Learning
+
+double online_update(OnlineLearner* ol, const double* x, double y) {
+    int k = ol->cfg.k, d = ol->cfg.d;
+    const double* W = ol->model->W;
+
+    for (int c = 0; c < k; c++) {
+        double s = 0.0;
+        for (int j = 0; j < d; j++) s += W[(size_t)c * d + j] * x[j];
+        ol->score[c] = s;
+    }
+
+    double pred, loss;
+    int hit = 0;
+    if (ol->cfg.type == MODEL_SOFTMAX) {
+        int label = (int)y;
+        int best = 0;
+        double max_s = ol->score[0];
+        for (int c = 1; c < k; c++)
+            if (ol->score[c] > max_s) { max_s = ol->score[c]; best = c; }
+
+        double sum = 0.0;
+        for (int c = 0; c < k; c++) {
+            ol->score[c] = exp(ol->score[c] - max_s);
+            sum += ol->score[c];
+        }
+        for (int c = 0; c < k; c++) ol->score[c] /= sum;
+
+        pred = ol->score[best];
+        hit = best == label;
+        loss = label >= 0 && label < k ? -log(ol->score[label] + 1e-8) : 0.0;
+
+        // dloss/dz_c = p_c - [c == label]
+        for (int c = 0; c < k; c++)
+            update_row(ol, c, x, ol->score[c] - (c == label ? 1.0 : 0.0));
+    } else {
+        LossType lt = ol->cfg.type == MODEL_LOGISTIC ? LOSS_LOGISTIC : LOSS_MSE;
+        double z = ol->score[0];
+        loss = sample_loss(lt, z, y);
+        if (lt == LOSS_LOGISTIC) {
+            pred = 1.0 / (1.0 + exp(-z));
+            hit = (pred >= 0.5) == (y >= 0.5);
+        } else {
+            pred = z;
+        }
+        update_row(ol, 0, x, sample_dloss(lt, z, y));
+    }
+
+    // Progressive metrics: the row was scored before the update above
+    double a = ol->rows == 0 ? 0.0 : ol->cfg.decay;
+    ol->rows++;
+    ol->loss_sum += loss;
+    ol->recent_loss = a * ol->recent_loss + (1 - a) * loss;
+    ol->correct += hit;
+    ol->recent_acc = a * ol->recent_acc + (1 - a) * hit;
+
+    if (ol->cfg.snapshot_every > 0 && ol->rows % ol->cfg.snapshot_every == 0)
+        online_snapshot(ol);
+    return pred;
+}
+
+void online_update_batch(OnlineLearner* ol, const double* X, const double* y, int n) {
+    for (int i = 0; i < n; i++) online_update(ol, X + (size_t)i * ol->cfg.d, y[i]);
+}
+
+void online_metrics(const OnlineLearner* ol, OnlineMetrics* out) {
+    int classify = ol->cfg.type != MODEL_LINEAR;
+    out->rows = ol->rows;
+    out->loss = ol->rows ? ol->loss_sum / ol->rows : 0.0;
+    out->recent_loss = ol->recent_loss;
+    out->accuracy = classify && ol->rows ? (double)ol->correct / ol->rows : 0.0;
+    out->recent_accuracy = classify ? ol->recent_acc : 0.0;
+    out->nonzeros = 0;
+    for (int i = 0; i < ol->kd; i++) out->nonzeros += ol->model->W[i] != 0.0;
+}
+
+const Model* online_model(OnlineLearner* ol) {
+    return ol->model;
+}
+
+
+// Snapshots
+
+static int write_snapshot(FILE* f, const void* ctx) {
+    return write_model(f, ctx);
+}
+
+int online_snapshot(OnlineLearner* ol) {
+    memcpy(ol->snap->W, ol->model->W, ol->kd * sizeof(double));
+
+    int rc = 0;
+    if (ol->cfg.snapshot_path) rc = write_file_atomic(ol->cfg.snapshot_path, write_snapshot, ol->snap);  // readers never see a partial model
+    if (ol->cfg.on_snapshot) {
+        OnlineMetrics m;
+        online_metrics(ol, &m);
+        ol->cfg.on_snapshot(ol->snap, &m, ol->cfg.ctx);
+    }
+    return rc;
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/optim.h"
+#include "../include/aligned.h"
+#include "../include/prof.h"
+
+Optimizer* optimizer_create(const OptimizerParams* params, GradPtrND grad, int dim) {
+    Optimizer* opt = calloc(1, sizeof(Optimizer));
+    if (!opt) return NULL;
+    opt->params = *params;
+    opt->grad = grad;
+    opt->dim = dim;
+
+    // Carve every array the method needs out of one block, each on its own cache lines
+    OptimizerType type = params->type;
+    int arrays = 1
+        + (type == OPT_ADAM) * 2
+        + (type == OPT_ADAGRAD || type == OPT_RMSPROP)
+        + (type == OPT_MOMENTUM || type == OPT_NESTEROV)
+        + (type == OPT_NESTEROV);
+    size_t stride = aligned_doubles(dim);
+
+    opt->workspace_len = arrays * stride;
+    opt->workspace = aligned_malloc(opt->workspace_len * sizeof(double));
+    if (!opt->workspace) {
+        free(opt);
+        return NULL;
+    }
+
+    double* p = opt->workspace;
+    opt->g = p;
+    p += stride;
+    if (type == OPT_ADAM) {
+        opt->m = p;
+        p += stride;
+        opt->v = p;
+        p += stride;
+    }
+    if (type == OPT_ADAGRAD || type == OPT_RMSPROP) {
+        opt->G = p;
+        p += stride;
+    }
+    if (type == OPT_MOMENTUM || type == OPT_NESTEROV) {
+        opt->velocity = p;
+        p += stride;
+    }
+    if (type == OPT_NESTEROV) opt->lookahead = p;
+
+    optimizer_reset(opt);
+    return opt;
+}
+
+void optimizer_reset(Optimizer* opt) {
+    memset(opt->workspace, 0, opt->workspace_len * sizeof(double));
+    opt->t = 0;
+}
+
+void optimizer_destroy(Optimizer* opt) {
+    if (!opt) return;
+    aligned_free(opt->workspace);
+    free(opt);
+}
+
+const double* optimizer_eval_point(Optimizer* opt, const double* x) {
+    if (opt->params.type != OPT_NESTEROV) return x;
+
+    // x_lookahead = x + gamma * v
+    double gamma = opt->params.momentum;
+    for (int i = 0; i < opt->dim; i++) opt->lookahead[i] = x[i] + gamma * opt->velocity[i];
+    return opt->lookahead;
+}
+
+double optimizer_apply(Optimizer* opt, double* x, const double* g) {
+    const OptimizerParams* p = &opt->params;
+    int dim = opt->dim;
+    double change = 0.0;
+    opt->t++;
+    PROF_BEGIN("optimizer_apply");
+
+    switch (p->type) {
+        case OPT_GD:
+            for (int i = 0; i < dim; i++) {
+                double delta = p->lr * g[i];
+                x[i] -= delta;
+                change += fabs(delta);
+            }
+            break;
+
+        case OPT_MOMENTUM:
+        case OPT_NESTEROV:
+            for (int i = 0; i < dim; i++) {
+                opt->velocity[i] = p->momentum * opt->velocity[i] - p->lr * g[i];
+                x[i] += opt->velocity[i];
+                change += fabs(opt->velocity[i]);
+            }
+            break;
+
+        case OPT_ADAGRAD:
+            for (int i = 0; i < dim; i++) {
+                opt->G[i] += g[i] * g[i];
+                double delta = p->lr / (sqrt(opt->G[i]) + p->epsilon) * g[i];
+                x[i] -= delta;
+                change += fabs(delta);
+            }
+            break;
+
+        case OPT_RMSPROP:
+            for (int i = 0; i < dim; i++) {
+                opt->G[i] = p->beta2 * opt->G[i] + (1 - p->beta2) * g[i] * g[i];
+                double delta = p->lr / (sqrt(opt->G[i]) + p->epsilon) * g[i];
+                x[i] -= delta;
+                change += fabs(delta);
+            }
+            break;
+
+        case OPT_ADAM: {
+            // Bias corrections depend only on t, so compute them once per step
+            double c1 = 1 - pow(p->beta1, opt->t);
+            double c2 = 1 - pow(p->beta2, opt->t);
+            for (int i = 0; i < dim; i++) {
+                opt->m[i] = p->beta1 * opt->m[i] + (1 - p->beta1) * g[i];
+                opt->v[i] = p->beta2 * opt->v[i] + (1 - p->beta2) * g[i] * g[i];
+                double m_hat = opt->m[i] / c1;
+                double v_hat = opt->v[i] / c2;
+                double delta = p->lr * m_hat / (sqrt(v_hat) + p->epsilon);
+                x[i] -= delta;
+                change += fabs(delta);
+            }
+            break;
+        }
+    }
+    PROF_END();
+    return change;
+}
+
+double optimizer_step(Optimizer* opt, double* x) {
+    const double* at = optimizer_eval_point(opt, x);
+    opt->grad((double*)at, opt->g, opt->dim);
+    return optimizer_apply(opt, x, opt->g);
+}
+
+int optimizer_run(Optimizer* opt, double* x, int max_iters, double tol) {
+    for (int i = 0; i < max_iters; i++) {
+        if (optimizer_step(opt, x) < tol) return i + 1;
+    }
+    return max_iters;
+}
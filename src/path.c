@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/path.h"
+#include "../include/prof.h"
+
+PathConfig path_default_config(ModelType type, int k) {
+    PathConfig cfg;
+    cfg.type = type;
+    cfg.k = type == MODEL_SOFTMAX ? k : 1;
+    cfg.alpha = 1.0;
+    cfg.num_lambdas = 100;
+    cfg.lambda_min_ratio = 1e-3;
+    cfg.lambda_max = 0.0;
+    cfg.tol = 1e-6;
+    cfg.max_iter = 5000;
+    cfg.warm_start = 1;
+    return cfg;
+}
+
+typedef struct {
+    ModelType type;
+    int n, d, k, kd;
+    const double* y;
+    double* X;          // n x d row-major copy (logistic / softmax)
+
+    // MSE statistics: loss(w) = w'Gw - 2 b'w + yy
+    double* G;          // X'X / n
+    double* b;          // X'y / n
+    double yy;          // mean y²
+    double lip;         // Lipschitz constant of the data-loss gradient
+
+    double* w;          // current iterate, k x d
+    double* v;          // extrapolated point
+    double* w_new;
+    double* grad;
+    double* Zw;         // margins at w, n x k
+    double* Zv;         // margins at v
+    double* Zprev;      // margins at the previous iterate
+    double* R;          // residuals dloss/dz at v
+    int* act;           // coordinates being iterated on; all others are held at zero
+    int nact;
+    int* moved;         // coordinates changed by the last step
+    double* delta;
+} PathSolver;
+
+
+// Cached statistics
+
+static double* gram(const double* X, int n, int d) {
+    double* G = calloc((size_t)d * d, sizeof(double));
+    if (!G) return NULL;
+    for (int i = 0; i < n; i++) {
+        const double* x = X + (size_t)i * d;
+        for (int a = 0; a < d; a++) {
+            double xa = x[a];
+            if (xa == 0.0) continue;
+            for (int c = a; c < d; c++) G[(size_t)a * d + c] += xa * x[c];
+        }
+    }
+    for (int a = 0; a < d; a++)
+        for (int c = a; c < d; c++) {
+            G[(size_t)a * d + c] /= n;
+            G[(size_t)c * d + a] = G[(size_t)a * d + c];
+        }
+    return G;
+}
+
+// Largest eigenvalue of X'X / n by power iteration, through the Gram matrix G when it
+// exists and through the rows of X otherwise; -1 if out of memory
+static double top_eigenvalue(const double* G, const double* X, int n, int d) {
+    double* u = malloc(d * sizeof(double));
+    double* Gu = malloc(d * sizeof(double));
+    if (!u || !Gu) {
+        free(u);
+        free(Gu);
+        return -1.0;
+    }
+    for (int j = 0; j < d; j++) u[j] = 1.0 / sqrt(d) * (1.0 + 0.01 * j);
+
+    double lambda = 0.0;
+    for (int it = 0; it < 200; it++) {
+        if (G) {
+            for (int a = 0; a < d; a++) {
+                double s = 0.0;
+                for (int c = 0; c < d; c++) s += G[(size_t)a * d + c] * u[c];
+                Gu[a] = s;
+            }
+        } else {
+            memset(Gu, 0, d * sizeof(double));
+            for (int i = 0; i < n; i++) {
+                const double* x = X + (size_t)i * d;
+                double xu = 0.0;
+                for (int j = 0; j < d; j++) xu += x[j] * u[j];
+                for (int j = 0; j < d; j++) Gu[j] += x[j] * xu;
+            }
+            for (int j = 0; j < d; j++) Gu[j] /= n;
+        }
+        double norm = 0.0;
+        for (int a = 0; a < d; a++) norm += Gu[a] * Gu[a];
+        norm = sqrt(norm);
+        if (norm == 0.0) break;
+        for (int j = 0; j < d; j++) u[j] = Gu[j] / norm;
+        if (fabs(norm - lambda) <= 1e-9 * norm) {
+            lambda = norm;
+            break;
+        }
+        lambda = norm;
+    }
+
+    free(u);
+    free(Gu);
+    return lambda * 1.01;   // power iteration approaches from below
+}
+
+static int solver_init(PathSolver* s, const Dataset* data, const PathConfig* cfg) {
+    memset(s, 0, sizeof(*s));
+    s->type = cfg->type;
+    s->n = data->n;
+    s->d = data->d;
+    s->k = cfg->type == MODEL_SOFTMAX ? cfg->k : 1;
+    s->kd = s->k * s->d;
+    s->y = data->y;
+
+    int n = s->n, d = s->d;
+    s->X = malloc((size_t)n * d * sizeof(double));
+    if (!s->X) return -1;
+    for (int i = 0; i < n; i++) memcpy(s->X + (size_t)i * d, data->X[i], d * sizeof(double));
+
+    if (s->type == MODEL_LINEAR) {
+        s->G = gram(s->X, n, d);
+        s->b = calloc(d, sizeof(double));
+        if (!s->G || !s->b) return -1;
+        double top = top_eigenvalue(s->G, NULL, n, d);
+        if (top < 0) return -1;
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < d; j++) s->b[j] += s->X[(size_t)i * d + j] * s->y[i];
+            s->yy += s->y[i] * s->y[i];
+        }
+        for (int j = 0; j < d; j++) s->b[j] /= n;
+        s->yy /= n;
+        s->lip = 2.0 * top;
+
+        // The Gram matrix is all MSE needs from here on
+        free(s->X);
+        s->X = NULL;
+    } else {
+        // Logistic and softmax work on the margins; the Gram matrix is never built
+        double top = top_eigenvalue(NULL, s->X, n, d);
+        if (top < 0) return -1;
+        s->lip = s->type == MODEL_LOGISTIC ? 0.25 * top : 0.5 * top;
+        s->Zw = calloc((size_t)n * s->k, sizeof(double));
+        s->Zv = calloc((size_t)n * s->k, sizeof(double));
+        s->Zprev = malloc((size_t)n * s->k * sizeof(double));
+        s->R = malloc((size_t)n * s->k * sizeof(double));
+        if (!s->Zw || !s->Zv || !s->Zprev || !s->R) return -1;
+    }
+
+    s->w = calloc(s->kd, sizeof(double));
+    s->v = calloc(s->kd, sizeof(double));
+    s->w_new = calloc(s->kd, sizeof(double));
+    s->grad = malloc(s->kd * sizeof(double));
+    s->act = malloc(s->kd * sizeof(int));
+    s->moved = malloc(s->kd * sizeof(int));
+    s->delta = malloc(s->kd * sizeof(double));
+    return s->w && s->v && s->w_new && s->grad && s->act && s->moved && s->delta ? 0 : -1;
+}
+
+static void solver_free(PathSolver* s) {
+    free(s->X);
+    free(s->G);
+    free(s->b);
+    free(s->w);
+    free(s->v);
+    free(s->w_new);
+    free(s->grad);
+    free(s->Zw);
+    free(s->Zv);
+    free(s->Zprev);
+    free(s->R);
+    free(s->act);
+    free(s->moved);
+    free(s->delta);
+}
+
+
+// Gradient of the data loss at v, using the cached margins Zv; without grad the loss
+// itself is returned instead (0 otherwise). With an active set (act != NULL) only those
+// gradient entries are computed and v must be zero outside the set.
+
+static double softplus(double z) {
+    return (z > 0 ? z : 0.0) + log1p(exp(-fabs(z)));
+}
+
+static double data_loss_grad(PathSolver* s, const double* v, const double* Zv, double* grad,
+                             const int* act, int nact) {
+    int n = s->n, d = s->d, k = s->k;
+    if (!act) nact = s->kd;
+
+    if (s->type == MODEL_LINEAR) {
+        double loss = s->yy;
+        for (int m = 0; m < nact; m++) {
+            int a = act ? act[m] : m;
+            double Gv = 0.0;
+            for (int c = 0; c < d; c++) Gv += s->G[(size_t)a * d + c] * v[c];
+            if (grad) grad[a] = 2.0 * (Gv - s->b[a]);
+            loss += v[a] * Gv - 2.0 * s->b[a] * v[a];
+        }
+        return grad ? 0.0 : loss;
+    }
+
+    double loss = 0.0;
+    for (int i = 0; i < n; i++) {
+        const double* z = Zv + (size_t)i * k;
+        double* r = s->R + (size_t)i * k;
+        if (s->type == MODEL_LOGISTIC) {
+            if (grad) r[0] = 1.0 / (1.0 + exp(-z[0])) - s->y[i];
+            else loss += softplus(z[0]) - s->y[i] * z[0];
+        } else {
+            int label = (int)s->y[i];
+            double max_z = z[0];
+            for (int c = 1; c < k; c++) if (z[c] > max_z) max_z = z[c];
+            double sum = 0.0;
+            for (int c = 0; c < k; c++) {
+                r[c] = exp(z[c] - max_z);
+                sum += r[c];
+            }
+            loss += max_z + log(sum) - z[label];
+            for (int c = 0; c < k; c++) r[c] = r[c] / sum - (c == label ? 1.0 : 0.0);
+        }
+    }
+
+    if (grad) {
+        for (int m = 0; m < nact; m++) grad[act ? act[m] : m] = 0.0;
+        for (int i = 0; i < n; i++) {
+            const double* x = s->X + (size_t)i * d;
+            const double* r = s->R + (size_t)i * k;
+            if (!act) {
+                for (int c = 0; c < k; c++) {
+                    double* g = grad + (size_t)c * d;
+                    for (int j = 0; j < d; j++) g[j] += r[c] * x[j];
+                }
+            } else if (k == 1) {
+                for (int m = 0; m < nact; m++) grad[act[m]] += r[0] * x[act[m]];
+            } else {
+                for (int m = 0; m < nact; m++) grad[act[m]] += r[act[m] / d] * x[act[m] % d];
+            }
+        }
+        for (int m = 0; m < nact; m++) grad[act ? act[m] : m] /= n;
+        return 0.0;
+    }
+    return loss / n;
+}
+
+// Z += X · (w_new - w_old), over only the coordinates that moved
+static void update_margins(PathSolver* s, double* Z, const double* w_old, const double* w_new) {
+    int n = s->n, d = s->d, k = s->k;
+    int moved = 0;
+    for (int idx = 0; idx < s->kd; idx++) {
+        double delta = w_new[idx] - w_old[idx];
+        if (delta == 0.0) continue;
+        s->moved[moved] = idx;
+        s->delta[moved] = delta;
+        moved++;
+    }
+    if (moved == 0) return;
+
+    for (int i = 0; i < n; i++) {
+        const double* x = s->X + (size_t)i * d;
+        double* z = Z + (size_t)i * k;
+        for (int m = 0; m < moved; m++) {
+            int idx = s->moved[m];
+            z[idx / d] += s->delta[m] * x[idx % d];
+        }
+    }
+}
+
+// Exact margins, refreshed once per path point so incremental updates cannot drift
+static void compute_margins(PathSolver* s, const double* w, double* Z) {
+    int n = s->n, d = s->d, k = s->k;
+    for (int i = 0; i < n; i++) {
+        const double* x = s->X + (size_t)i * d;
+        for (int c = 0; c < k; c++) {
+            const double* wc = w + (size_t)c * d;
+            double z = 0.0;
+            for (int j = 0; j < d; j++) z += wc[j] * x[j];
+            Z[(size_t)i * k + c] = z;
+        }
+    }
+}
+
+static double penalty(const PathSolver* s, const double* w, double l1, double l2) {
+    double p = 0.0;
+    for (int c = 0; c < s->k; c++)
+        for (int j = 1; j < s->d; j++) {
+            double wj = w[(size_t)c * s->d + j];
+            p += l1 * fabs(wj) + 0.5 * l2 * wj * wj;
+        }
+    return p;
+}
+
+
+// One path point: FISTA with gradient-based restarts from the current w,
+// iterating over the active set only. Stops once the proximal gradient mapping
+// (v - prox(v - step * grad)) / step, which is zero exactly at a minimizer, falls
+// below tol in every coordinate; the size of one step alone says nothing when
+// 1/L is small.
+static int solve_point(PathSolver* s, double l1, double l2, const PathConfig* cfg) {
+    int d = s->d;
+    double step = 1.0 / (s->lip + l2);
+    double thresh = step * l1;
+    int margins = s->type != MODEL_LINEAR;
+    size_t nk = (size_t)s->n * s->k;
+
+    memcpy(s->v, s->w, s->kd * sizeof(double));
+    memcpy(s->w_new, s->w, s->kd * sizeof(double));
+    if (margins) {
+        compute_margins(s, s->w, s->Zw);
+        memcpy(s->Zv, s->Zw, nk * sizeof(double));
+    }
+    double t = 1.0;
+
+    int it;
+    for (it = 1; it <= cfg->max_iter; it++) {
+        data_loss_grad(s, s->v, s->Zv, s->grad, s->act, s->nact);
+
+        double max_map = 0.0, restart = 0.0;
+        for (int m = 0; m < s->nact; m++) {
+            int idx = s->act[m];
+            double u = s->v[idx] - step * s->grad[idx];
+            if (idx % d != 0) {
+                u -= step * l2 * s->v[idx];
+                if (u > thresh) u -= thresh;
+                else if (u < -thresh) u += thresh;
+                else u = 0.0;
+            }
+            s->w_new[idx] = u;
+            double delta = u - s->w[idx];
+            restart += (s->v[idx] - u) * delta;
+            if (fabs(s->v[idx] - u) > max_map) max_map = fabs(s->v[idx] - u);
+        }
+
+        // v becomes the new extrapolated point; margins follow linearly
+        double t_new = restart > 0 ? 1.0 : 0.5 * (1.0 + sqrt(1.0 + 4.0 * t * t));
+        double beta = restart > 0 ? 0.0 : (t - 1.0) / t_new;
+        if (margins) {
+            memcpy(s->Zprev, s->Zw, nk * sizeof(double));
+            update_margins(s, s->Zw, s->w, s->w_new);
+            for (size_t i = 0; i < nk; i++) s->Zv[i] = s->Zw[i] + beta * (s->Zw[i] - s->Zprev[i]);
+        }
+        for (int m = 0; m < s->nact; m++) {
+            int idx = s->act[m];
+            s->v[idx] = s->w_new[idx] + beta * (s->w_new[idx] - s->w[idx]);
+            s->w[idx] = s->w_new[idx];
+        }
+        t = t_new;
+
+        if (max_map < cfg->tol * step) break;
+    }
+    return it > cfg->max_iter ? cfg->max_iter : it;
+}
+
+// Strong rule (Tibshirani et al. 2012): a weight that is zero at the previous point
+// stays zero at lambda if |grad_j| < alpha * (2 * lambda - lambda_prev).
+// s->grad must hold the full gradient at the previous solution.
+static void screen(PathSolver* s, double cutoff) {
+    s->nact = 0;
+    for (int idx = 0; idx < s->kd; idx++)
+        if (idx % s->d == 0 || s->w[idx] != 0.0 || fabs(s->grad[idx]) >= cutoff)
+            s->act[s->nact++] = idx;
+}
+
+// Adds the inactive weights violating the optimality conditions; returns how many
+static int add_violators(PathSolver* s, double l1) {
+    data_loss_grad(s, s->w, s->Zw, s->grad, NULL, 0);
+
+    int added = 0, m = 0;
+    for (int idx = 0; idx < s->kd; idx++) {
+        if (m < s->nact && s->act[m] == idx) {
+            m++;
+            continue;
+        }
+        if (fabs(s->grad[idx]) > l1 * (1.0 + 1e-9)) {
+            s->moved[added++] = idx;
+        }
+    }
+
+    // Merge, keeping the set sorted
+    if (added) {
+        int a = s->nact - 1, b = added - 1;
+        s->nact += added;
+        for (int out = s->nact - 1; out >= 0; out--) {
+            if (b < 0 || (a >= 0 && s->act[a] > s->moved[b])) s->act[out] = s->act[a--];
+            else s->act[out] = s->moved[b--];
+        }
+    }
+    return added;
+}
+
+
+// Path
+
+RegPath* reg_path(const Dataset* data, const PathConfig* cfg) {
+    if (cfg->num_lambdas <= 0 || (cfg->type == MODEL_SOFTMAX && cfg->k <= 1)) return NULL;
+
+    PROF_BEGIN("reg_path");
+    PathSolver s;
+    if (solver_init(&s, data, cfg) != 0) {
+        perror("reg_path");
+        solver_free(&s);
+        PROF_END();
+        return NULL;
+    }
+
+    int num = cfg->num_lambdas, kd = s.kd;
+    RegPath* p = calloc(1, sizeof(RegPath));
+    if (!p) {
+        perror("reg_path");
+        solver_free(&s);
+        PROF_END();
+        return NULL;
+    }
+    p->num = num;
+    p->k = s.k;
+    p->d = s.d;
+    p->lambda = malloc(num * sizeof(double));
+    p->W = malloc((size_t)num * kd * sizeof(double));
+    p->loss = malloc(num * sizeof(double));
+    p->objective = malloc(num * sizeof(double));
+    p->nonzeros = malloc(num * sizeof(int));
+    p->iters = malloc(num * sizeof(int));
+    if (!p->lambda || !p->W || !p->loss || !p->objective || !p->nonzeros || !p->iters) {
+        perror("reg_path");
+        reg_path_free(p);
+        solver_free(&s);
+        PROF_END();
+        return NULL;
+    }
+
+    // The bias-only fit defines lambda_max: no penalized gradient exceeds it there
+    s.nact = 0;
+    for (int c = 0; c < s.k; c++) s.act[s.nact++] = c * s.d;
+    p->total_iters += solve_point(&s, 0.0, 0.0, cfg);
+    if (s.Zw) compute_margins(&s, s.w, s.Zw);
+    data_loss_grad(&s, s.w, s.Zw, s.grad, NULL, 0);
+
+    double lambda_max = cfg->lambda_max;
+    if (lambda_max <= 0) {
+        double gmax = 0.0;
+        for (int idx = 0; idx < kd; idx++)
+            if (idx % s.d != 0 && fabs(s.grad[idx]) > gmax) gmax = fabs(s.grad[idx]);
+        lambda_max = gmax / (cfg->alpha > 1e-3 ? cfg->alpha : 1e-3);
+    }
+
+    double lambda_prev = lambda_max;
+    for (int i = 0; i < num; i++) {
+        double frac = num > 1 ? (double)i / (num - 1) : 0.0;
+        double lambda = lambda_max * pow(cfg->lambda_min_ratio, frac);
+        double l1 = cfg->alpha * lambda, l2 = (1.0 - cfg->alpha) * lambda;
+
+        if (!cfg->warm_start) memset(s.w, 0, kd * sizeof(double));
+
+        // With an l1 term, iterate on the screened set and re-solve while the KKT check fails
+        if (l1 > 0) {
+            screen(&s, cfg->alpha * (2.0 * lambda - lambda_prev));
+        } else {
+            s.nact = kd;
+            for (int idx = 0; idx < kd; idx++) s.act[idx] = idx;
+        }
+        p->iters[i] = 0;
+        do {
+            p->iters[i] += solve_point(&s, l1, l2, cfg);
+        } while (l1 > 0 && add_violators(&s, l1) > 0);
+        lambda_prev = lambda;
+
+        p->total_iters += p->iters[i];
+        p->lambda[i] = lambda;
+        memcpy(p->W + (size_t)i * kd, s.w, kd * sizeof(double));
+        p->loss[i] = data_loss_grad(&s, s.w, s.Zw, NULL, NULL, 0);
+        p->objective[i] = p->loss[i] + penalty(&s, s.w, l1, l2);
+
+        int nz = 0;
+        for (int idx = 0; idx < kd; idx++) nz += idx % s.d != 0 && s.w[idx] != 0.0;
+        p->nonzeros[i] = nz;
+    }
+
+    solver_free(&s);
+    PROF_END();
+    return p;
+}
+
+const double* reg_path_weights(const RegPath* p, int i) {
+    return p->W + (size_t)i * p->k * p->d;
+}
+
+void reg_path_free(RegPath* p) {
+    if (!p) return;
+    free(p->lambda);
+    free(p->W);
+    free(p->loss);
+    free(p->objective);
+    free(p->nonzeros);
+    free(p->iters);
+    free(p);
+}
@@ -0,0 +1,259 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "../include/pool.h"
+#include "../include/rng.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+typedef struct {
+    TaskFn fn;
+    void* arg;
+} Task;
+
+// Growable ring; bottom is the owner's end, top is the thieves' end
+typedef struct {
+    pthread_mutex_t lock;
+    Task* tasks;
+    int cap;
+    int top;     // index of the oldest task
+    int size;
+} Deque;
+
+typedef struct {
+    ThreadPool* pool;
+    int id;
+    Rng rng;
+    pthread_t thread;
+} Worker;
+
+struct ThreadPool {
+    int num_threads;
+    Deque* deques;
+    Worker* workers;
+    int next_submit;           // round-robin target for external submits
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready, all_done;
+    int queued;                // tasks sitting in deques (changes under lock)
+    int unfinished;            // submitted but not yet completed
+    int sleeping;
+    int shutdown;
+};
+
+// Which pool/worker the current thread belongs to, so nested submits stay local
+static _Thread_local Worker* t_worker = NULL;
+
+int pool_num_cpus(void) {
+#ifdef _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (int)n : 1;
+#endif
+}
+
+
+// Deque operations
+
+static void deque_push_bottom(Deque* dq, Task t) {
+    pthread_mutex_lock(&dq->lock);
+    if (dq->size == dq->cap) {
+        int cap = dq->cap * 2;
+        Task* tasks = malloc(cap * sizeof(Task));
+        for (int i = 0; i < dq->size; i++) tasks[i] = dq->tasks[(dq->top + i) % dq->cap];
+        free(dq->tasks);
+        dq->tasks = tasks;
+        dq->cap = cap;
+        dq->top = 0;
+    }
+    dq->tasks[(dq->top + dq->size) % dq->cap] = t;
+    dq->size++;
+    pthread_mutex_unlock(&dq->lock);
+}
+
+static int deque_pop_bottom(Deque* dq, Task* out) {
+    pthread_mutex_lock(&dq->lock);
+    int ok = dq->size > 0;
+    if (ok) *out = dq->tasks[(dq->top + --dq->size) % dq->cap];
+    pthread_mutex_unlock(&dq->lock);
+    return ok;
+}
+
+static int deque_steal_top(Deque* dq, Task* out) {
+    pthread_mutex_lock(&dq->lock);
+    int ok = dq->size > 0;
+    if (ok) {
+        *out = dq->tasks[dq->top];
+        dq->top = (dq->top + 1) % dq->cap;
+        dq->size--;
+    }
+    pthread_mutex_unlock(&dq->lock);
+    return ok;
+}
+
+
+// Workers
+
+static int find_task(Worker* w, Task* out) {
+    ThreadPool* pool = w->pool;
+    if (deque_pop_bottom(&pool->deques[w->id], out)) return 1;
+
+    int n = pool->num_threads;
+    int start = rng_int(&w->rng, n);
+    for (int k = 0; k < n; k++) {
+        int victim = (start + k) % n;
+        if (victim != w->id && deque_steal_top(&pool->deques[victim], out)) return 1;
+    }
+    return 0;
+}
+
+static void task_taken(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->queued--;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void task_finished(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    if (--pool->unfinished == 0) pthread_cond_broadcast(&pool->all_done);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+static void* worker_main(void* arg) {
+    Worker* w = arg;
+    ThreadPool* pool = w->pool;
+    t_worker = w;
+
+    for (;;) {
+        Task t;
+        if (find_task(w, &t)) {
+            task_taken(pool);
+            t.fn(t.arg);
+            task_finished(pool);
+            continue;
+        }
+
+        pthread_mutex_lock(&pool->lock);
+        while (pool->queued == 0 && !pool->shutdown) {
+            pool->sleeping++;
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+            pool->sleeping--;
+        }
+        int done = pool->shutdown && pool->queued == 0;
+        pthread_mutex_unlock(&pool->lock);
+        if (done) break;
+    }
+
+    t_worker = NULL;
+    return NULL;
+}
+
+
+// Pool API
+
+ThreadPool* pool_create(int num_threads) {
+    if (num_threads <= 0) num_threads = pool_num_cpus();
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    pool->num_threads = num_threads;
+    pool->deques = calloc(num_threads, sizeof(Deque));
+    pool->workers = calloc(num_threads, sizeof(Worker));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->all_done, NULL);
+
+    for (int i = 0; i < num_threads; i++) {
+        Deque* dq = &pool->deques[i];
+        pthread_mutex_init(&dq->lock, NULL);
+        dq->cap = 64;
+        dq->tasks = malloc(dq->cap * sizeof(Task));
+    }
+
+    for (int i = 0; i < num_threads; i++) {
+        Worker* w = &pool->workers[i];
+        w->pool = pool;
+        w->id = i;
+        rng_seed(&w->rng, (uint64_t)i + 1);
+        if (pthread_create(&w->thread, NULL, worker_main, w) != 0) {
+            perror("Thread error");
+            // Keep the workers that did start; their deques are the only ones used
+            pthread_mutex_lock(&pool->lock);
+            pool->num_threads = i;
+            pthread_mutex_unlock(&pool->lock);
+            for (int j = i; j < num_threads; j++) {
+                pthread_mutex_destroy(&pool->deques[j].lock);
+                free(pool->deques[j].tasks);
+            }
+            break;
+        }
+    }
+
+    if (pool->num_threads == 0) {
+        pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void pool_submit(ThreadPool* pool, TaskFn fn, void* arg) {
+    Task t = { fn, arg };
+    int target;
+    if (t_worker && t_worker->pool == pool) {
+        target = t_worker->id;
+    } else {
+        pthread_mutex_lock(&pool->lock);
+        target = pool->next_submit;
+        pool->next_submit = (pool->next_submit + 1) % pool->num_threads;
+        pthread_mutex_unlock(&pool->lock);
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->unfinished++;
+    pthread_mutex_unlock(&pool->lock);
+
+    deque_push_bottom(&pool->deques[target], t);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->queued++;
+    if (pool->sleeping > 0) pthread_cond_signal(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_wait(ThreadPool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    while (pool->unfinished > 0) pthread_cond_wait(&pool->all_done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int pool_size(const ThreadPool* pool) {
+    return pool->num_threads;
+}
+
+void pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->num_threads; i++) pthread_join(pool->workers[i].thread, NULL);
+
+    for (int i = 0; i < pool->num_threads; i++) {
+        pthread_mutex_destroy(&pool->deques[i].lock);
+        free(pool->deques[i].tasks);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_cond_destroy(&pool->all_done);
+    free(pool->deques);
+    free(pool->workers);
+    free(pool);
+}
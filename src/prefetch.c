@@ -0,0 +1,245 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/prefetch.h"
+#include "../include/aligned.h"
+#include "../include/pool.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sched.h>
+#endif
+
+// One ring slot; seq == k means free for batch k, seq == k + 1 means batch k is ready
+typedef struct {
+    long long seq;
+    Batch batch;
+    char pad[CACHE_LINE];   // keep neighbouring slots' seq on separate lines
+} Slot;
+
+struct Prefetcher {
+    const Dataset* data;
+    PrefetchConfig cfg;
+    int depth;
+    Slot* slots;
+    int batches_per_epoch;
+    long long total_batches;
+    int half_bits;            // Feistel half width for the per-epoch permutation
+
+    long long next_claim;     // shared by workers
+    long long next_consume;   // consumer only
+    int stop;
+
+    pthread_t* threads;
+    int num_threads;
+
+    long long produced;
+    long long consumer_stalls;
+    long long consumer_wait_ns;
+    long long producer_stalls;
+};
+
+static long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000000000ll + ts.tv_nsec;
+}
+
+static void backoff(int* spins) {
+    if (++*spins < 64) return;
+#ifdef _WIN32
+    if (*spins < 256) SwitchToThread();
+    else Sleep(0);
+#else
+    if (*spins < 256) {
+        sched_yield();
+    } else {
+        struct timespec ts = { 0, 20000 };
+        nanosleep(&ts, NULL);
+    }
+#endif
+}
+
+
+// Random-access shuffle: a Feistel network is a bijection on [0, 4^half_bits);
+// cycle-walking restricts it to [0, n). Workers can place any row of any epoch
+// without sharing a permutation array.
+
+static uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static int permute(const Prefetcher* p, int epoch, int i) {
+    int half = p->half_bits;
+    uint64_t mask = (1ull << half) - 1;
+    uint64_t key = mix64(p->cfg.seed + 0x9E3779B97F4A7C15ull * (uint64_t)(epoch + 1));
+    uint64_t x = (uint64_t)i;
+    do {
+        uint64_t l = x >> half, r = x & mask;
+        for (int round = 0; round < 4; round++) {
+            uint64_t f = mix64(r ^ key ^ (uint64_t)round * 0xD1B54A32D192ED03ull) & mask;
+            uint64_t next_l = r;
+            r = l ^ f;
+            l = next_l;
+        }
+        x = (l << half) | r;
+    } while (x >= (uint64_t)p->data->n);
+    return (int)x;
+}
+
+
+// Workers
+
+static void fill_batch(Prefetcher* p, Batch* b, long long k) {
+    const Dataset* data = p->data;
+    int B = p->cfg.batch_size;
+    int d = data->d;
+    int epoch = (int)(k / p->batches_per_epoch);
+    int first = (int)(k % p->batches_per_epoch) * B;
+
+    b->rows = data->n - first < B ? data->n - first : B;
+    b->epoch = epoch;
+    b->index = k;
+
+    for (int r = 0; r < b->rows; r++) {
+        int i = permute(p, epoch, first + r);
+        const double* src = data->X[i];
+        double* dst = b->X + (size_t)r * d;
+        if (p->cfg.mean && p->cfg.inv_std) {
+            for (int j = 0; j < d; j++) dst[j] = (src[j] - p->cfg.mean[j]) * p->cfg.inv_std[j];
+        } else {
+            memcpy(dst, src, d * sizeof(double));
+        }
+        b->y[r] = data->y[i];
+    }
+}
+
+static void* worker_main(void* arg) {
+    Prefetcher* p = arg;
+
+    for (;;) {
+        long long k = __atomic_fetch_add(&p->next_claim, 1, __ATOMIC_RELAXED);
+        if (k >= p->total_batches) break;
+
+        Slot* s = &p->slots[k % p->depth];
+        int spins = 0;
+        while (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != k) {
+            if (__atomic_load_n(&p->stop, __ATOMIC_RELAXED)) return NULL;
+            if (spins == 0) __atomic_fetch_add(&p->producer_stalls, 1, __ATOMIC_RELAXED);
+            backoff(&spins);
+        }
+
+        fill_batch(p, &s->batch, k);
+        __atomic_store_n(&s->seq, k + 1, __ATOMIC_RELEASE);
+        __atomic_fetch_add(&p->produced, 1, __ATOMIC_RELAXED);
+    }
+    return NULL;
+}
+
+
+// API
+
+PrefetchConfig prefetch_default_config(int batch_size, int epochs) {
+    PrefetchConfig cfg;
+    cfg.batch_size = batch_size;
+    cfg.queue_depth = 4;
+    cfg.num_workers = 0;
+    cfg.epochs = epochs;
+    cfg.seed = 42;
+    cfg.mean = NULL;
+    cfg.inv_std = NULL;
+    return cfg;
+}
+
+Prefetcher* prefetch_create(const Dataset* data, const PrefetchConfig* cfg) {
+    if (data->n <= 0 || cfg->batch_size <= 0) return NULL;
+
+    Prefetcher* p = calloc(1, sizeof(Prefetcher));
+    p->data = data;
+    p->cfg = *cfg;
+    p->depth = cfg->queue_depth >= 2 ? cfg->queue_depth : 2;
+    p->batches_per_epoch = (data->n + cfg->batch_size - 1) / cfg->batch_size;
+    p->total_batches = (long long)p->batches_per_epoch * (cfg->epochs > 0 ? cfg->epochs : 0);
+
+    int bits = 1;
+    while ((1ll << bits) < data->n) bits++;
+    p->half_bits = (bits + 1) / 2;
+
+    p->slots = aligned_malloc(p->depth * sizeof(Slot));
+    for (int i = 0; i < p->depth; i++) {
+        Slot* s = &p->slots[i];
+        memset(s, 0, sizeof(Slot));
+        s->seq = i;
+        s->batch.d = data->d;
+        s->batch.X = aligned_malloc(aligned_doubles((size_t)cfg->batch_size * data->d) * sizeof(double));
+        s->batch.y = aligned_malloc(aligned_doubles(cfg->batch_size) * sizeof(double));
+    }
+
+    int workers = cfg->num_workers > 0 ? cfg->num_workers : pool_num_cpus() - 1;
+    if (workers < 1) workers = 1;
+    p->threads = malloc(workers * sizeof(pthread_t));
+    for (int t = 0; t < workers; t++) {
+        if (pthread_create(&p->threads[t], NULL, worker_main, p) != 0) {
+            perror("Thread error");
+            break;
+        }
+        p->num_threads++;
+    }
+
+    if (p->num_threads == 0) {
+        prefetch_destroy(p);
+        return NULL;
+    }
+    return p;
+}
+
+const Batch* prefetch_next(Prefetcher* p) {
+    long long k = p->next_consume;
+    if (k >= p->total_batches) return NULL;
+
+    Slot* s = &p->slots[k % p->depth];
+    if (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != k + 1) {
+        long long t0 = now_ns();
+        int spins = 0;
+        while (__atomic_load_n(&s->seq, __ATOMIC_ACQUIRE) != k + 1) backoff(&spins);
+        __atomic_fetch_add(&p->consumer_stalls, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&p->consumer_wait_ns, now_ns() - t0, __ATOMIC_RELAXED);
+    }
+    return &s->batch;
+}
+
+void prefetch_release(Prefetcher* p, const Batch* b) {
+    Slot* s = &p->slots[b->index % p->depth];
+    __atomic_store_n(&s->seq, b->index + p->depth, __ATOMIC_RELEASE);
+    p->next_consume = b->index + 1;
+}
+
+void prefetch_stats(Prefetcher* p, PrefetchStats* out) {
+    out->produced = __atomic_load_n(&p->produced, __ATOMIC_RELAXED);
+    out->consumed = p->next_consume;
+    out->occupancy = (int)(out->produced - out->consumed);
+    out->consumer_stalls = __atomic_load_n(&p->consumer_stalls, __ATOMIC_RELAXED);
+    out->consumer_wait_s = __atomic_load_n(&p->consumer_wait_ns, __ATOMIC_RELAXED) * 1e-9;
+    out->producer_stalls = __atomic_load_n(&p->producer_stalls, __ATOMIC_RELAXED);
+}
+
+void prefetch_destroy(Prefetcher* p) {
+    if (!p) return;
+
+    __atomic_store_n(&p->stop, 1, __ATOMIC_RELAXED);
+    for (int t = 0; t < p->num_threads; t++) pthread_join(p->threads[t], NULL);
+
+    for (int i = 0; i < p->depth; i++) {
+        aligned_free(p->slots[i].batch.X);
+        aligned_free(p->slots[i].batch.y);
+    }
+    aligned_free(p->slots);
+    free(p->threads);
+    free(p);
+}
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/prof.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define MAX_REGIONS 128
+#define NUM_COUNTERS 4
+
+static const char* counter_names[NUM_COUNTERS] = { "cycles", "instructions", "llc_misses", "branch_misses" };
+
+typedef struct {
+    const char* name;
+    unsigned long long calls;
+    unsigned long long ns;
+    unsigned long long counters[NUM_COUNTERS];
+    unsigned long long counted_calls;   // calls that had hardware counters
+} Region;
+
+static Region g_regions[MAX_REGIONS];
+static int g_num_regions = 0;
+static int g_enabled = 0;
+static pthread_mutex_t g_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned long long now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+
+// Hardware counters (one perf event group per thread)
+
+#ifdef __linux__
+static _Thread_local int t_group_fd = -2;        // -2 = not opened yet, -1 = unavailable
+static _Thread_local int t_slot[NUM_COUNTERS];   // counter index of each event in the group
+static _Thread_local int t_num_events = 0;
+
+// The group's fds, leader first, are closed when the thread exits: pools are created and
+// destroyed per call in several places, so their threads must not leak descriptors
+typedef struct {
+    int fd[NUM_COUNTERS];
+    int num;
+} EventFds;
+
+static pthread_key_t g_fds_key;
+static pthread_once_t g_fds_once = PTHREAD_ONCE_INIT;
+
+static void close_events(void* arg) {
+    EventFds* fds = arg;
+    for (int e = fds->num - 1; e >= 0; e--) close(fds->fd[e]);
+    free(fds);
+}
+
+static void create_fds_key(void) {
+    pthread_key_create(&g_fds_key, close_events);
+}
+
+static int open_event(unsigned long long config, int group_fd) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = group_fd == -1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0);
+}
+
+static void open_group(void) {
+    static const unsigned long long configs[NUM_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+        PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+    };
+
+    pthread_once(&g_fds_once, create_fds_key);
+    EventFds* fds = malloc(sizeof(EventFds));
+    t_group_fd = fds ? open_event(configs[0], -1) : -1;
+    if (t_group_fd < 0) {
+        t_group_fd = -1;
+        free(fds);
+        return;
+    }
+    fds->fd[0] = t_group_fd;
+    fds->num = 1;
+    t_slot[t_num_events++] = 0;
+    for (int c = 1; c < NUM_COUNTERS; c++) {
+        int fd = open_event(configs[c], t_group_fd);
+        if (fd < 0) continue;
+        fds->fd[fds->num++] = fd;
+        t_slot[t_num_events++] = c;
+    }
+    if (pthread_setspecific(g_fds_key, fds) != 0) {
+        close_events(fds);
+        t_group_fd = -1;
+        t_num_events = 0;
+        return;
+    }
+    ioctl(t_group_fd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(t_group_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+static int read_counters(unsigned long long* out) {
+    if (t_group_fd == -2) open_group();
+    if (t_group_fd < 0) return 0;
+
+    unsigned long long buf[1 + NUM_COUNTERS];
+    if (read(t_group_fd, buf, sizeof(buf)) < (ssize_t)(sizeof(unsigned long long) * (1 + t_num_events))) return 0;
+    for (int c = 0; c < NUM_COUNTERS; c++) out[c] = 0;
+    for (unsigned long long e = 0; e < buf[0] && e < (unsigned long long)t_num_events; e++) out[t_slot[e]] = buf[1 + e];
+    return 1;
+}
+#else
+static int read_counters(unsigned long long* out) {
+    (void)out;
+    return 0;
+}
+#endif
+
+
+// Regions
+
+void prof_enable(int on) {
+    __atomic_store_n(&g_enabled, on, __ATOMIC_RELAXED);
+}
+
+int prof_enabled(void) {
+    return __atomic_load_n(&g_enabled, __ATOMIC_RELAXED);
+}
+
+int prof_register(const char* name) {
+    pthread_mutex_lock(&g_lock);
+    int id = -1;
+    for (int r = 0; r < g_num_regions; r++) {
+        if (strcmp(g_regions[r].name, name) == 0) id = r;
+    }
+    if (id < 0 && g_num_regions < MAX_REGIONS) {
+        id = g_num_regions;
+        g_regions[id].name = name;
+        __atomic_store_n(&g_num_regions, g_num_regions + 1, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&g_lock);
+    return id;
+}
+
+void prof_begin(ProfScope* s, int* region, const char* name) {
+    s->active = 0;
+    if (!__atomic_load_n(&g_enabled, __ATOMIC_RELAXED)) return;
+
+    int id = __atomic_load_n(region, __ATOMIC_ACQUIRE);
+    if (id < 0) {
+        id = prof_register(name);
+        if (id < 0) return;   // region table full
+        __atomic_store_n(region, id, __ATOMIC_RELEASE);
+    }
+
+    s->active = read_counters(s->c0) ? 2 : 1;
+    s->region = id;
+    s->t0 = now_ns();
+}
+
+void prof_end(ProfScope* s) {
+    if (!s->active) return;
+    unsigned long long t1 = now_ns();
+    Region* r = &g_regions[s->region];
+
+    unsigned long long c1[NUM_COUNTERS];
+    if (s->active == 2 && read_counters(c1)) {
+        for (int c = 0; c < NUM_COUNTERS; c++) __atomic_fetch_add(&r->counters[c], c1[c] - s->c0[c], __ATOMIC_RELAXED);
+        __atomic_fetch_add(&r->counted_calls, 1, __ATOMIC_RELAXED);
+    }
+    __atomic_fetch_add(&r->ns, t1 - s->t0, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&r->calls, 1, __ATOMIC_RELAXED);
+}
+
+void prof_reset(void) {
+    pthread_mutex_lock(&g_lock);
+    for (int r = 0; r < g_num_regions; r++) {
+        const char* name = g_regions[r].name;
+        memset(&g_regions[r], 0, sizeof(Region));
+        g_regions[r].name = name;
+    }
+    pthread_mutex_unlock(&g_lock);
+}
+
+
+// Reports
+
+static int by_time(const void* a, const void* b) {
+    const Region* x = a;
+    const Region* y = b;
+    return (y->ns > x->ns) - (y->ns < x->ns);
+}
+
+// Copies the regions that were hit, slowest first
+static int snapshot(Region* out) {
+    pthread_mutex_lock(&g_lock);
+    int n = 0;
+    for (int r = 0; r < g_num_regions; r++) {
+        if (g_regions[r].calls > 0) out[n++] = g_regions[r];
+    }
+    pthread_mutex_unlock(&g_lock);
+    qsort(out, n, sizeof(Region), by_time);
+    return n;
+}
+
+void prof_report(FILE* out) {
+    Region regions[MAX_REGIONS];
+    int n = snapshot(regions);
+
+    fprintf(out, "%-28s | %9s | %10s | %10s | %14s | %5s | %12s | %12s\n",
+            "Region", "Calls", "Total ms", "Avg us", "Cycles", "IPC", "LLC miss", "Branch miss");
+    for (int i = 0; i < n; i++) {
+        Region* r = &regions[i];
+        fprintf(out, "%-28s | %9llu | %10.3f | %10.3f",
+                r->name, r->calls, r->ns / 1e6, r->ns / 1e3 / r->calls);
+        if (r->counted_calls > 0) {
+            double ipc = r->counters[0] ? (double)r->counters[1] / r->counters[0] : 0.0;
+            fprintf(out, " | %14llu | %5.2f | %12llu | %12llu\n", r->counters[0], ipc, r->counters[2], r->counters[3]);
+        } else {
+            fprintf(out, " | %14s | %5s | %12s | %12s\n", "-", "-", "-", "-");
+        }
+    }
+}
+
+int prof_dump_json(const char* filename) {
+    FILE* f = fopen(filename, "w");
+    if (!f) {
+        perror("Profile file error");
+        return -1;
+    }
+
+    Region regions[MAX_REGIONS];
+    int n = snapshot(regions);
+
+    fprintf(f, "{\n  \"regions\": [\n");
+    for (int i = 0; i < n; i++) {
+        Region* r = &regions[i];
+        fprintf(f, "    {\"name\": \"%s\", \"calls\": %llu, \"total_ns\": %llu", r->name, r->calls, r->ns);
+        if (r->counted_calls > 0) {
+            for (int c = 0; c < NUM_COUNTERS; c++) fprintf(f, ", \"%s\": %llu", counter_names[c], r->counters[c]);
+        }
+        fprintf(f, "}%s\n", i + 1 < n ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+
+// COPTI_PROFILE / COPTI_PROFILE_JSON environment switches
+
+static void report_at_exit(void) {
+    prof_report(stderr);
+    const char* json = getenv("COPTI_PROFILE_JSON");
+    if (json && *json) prof_dump_json(json);
+}
+
+#if defined(__GNUC__)
+__attribute__((constructor))
+#endif
+static void prof_init_from_env(void) {
+    const char* env = getenv("COPTI_PROFILE");
+    if (env && *env && strcmp(env, "0") != 0) {
+        prof_enable(1);
+        atexit(report_at_exit);
+    }
+}
@@ -0,0 +1,391 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/quant.h"
+#include "../include/aligned.h"
+#include "../include/prof.h"
+
+#if (defined(__AVX512VNNI__) && defined(__AVX512VL__)) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#define QUANT_MODEL_MAGIC 0x51504F43u   // "COPQ"
+#define QUANT_MODEL_VERSION 1u
+#define ENCODE_ROWS 256                 // rows encoded per pass by quant_predict_batch
+
+static int padded_dim(int d) {
+    return (d + QUANT_BLOCK - 1) / QUANT_BLOCK * QUANT_BLOCK;
+}
+
+static QuantModel* create_quant_model(ModelType type, int k, int d) {
+    QuantModel* qm = calloc(1, sizeof(QuantModel));
+    if (!qm) return NULL;
+    qm->type = type;
+    qm->k = k;
+    qm->d = d;
+    qm->d_pad = padded_dim(d);
+    qm->W = aligned_malloc((size_t)k * qm->d_pad);
+    qm->scale = malloc(k * sizeof(float));
+    qm->bias = malloc(k * sizeof(float));
+    qm->lo = calloc(d, sizeof(float));
+    qm->inv_step = calloc(d, sizeof(float));
+    if (!qm->W || !qm->scale || !qm->bias || !qm->lo || !qm->inv_step) {
+        free_quant_model(qm);
+        return NULL;
+    }
+    memset(qm->W, 0, (size_t)k * qm->d_pad);
+    return qm;
+}
+
+void free_quant_model(QuantModel* qm) {
+    if (!qm) return;
+    aligned_free(qm->W);
+    free(qm->scale);
+    free(qm->bias);
+    free(qm->lo);
+    free(qm->inv_step);
+    free(qm);
+}
+
+size_t quant_model_bytes(const QuantModel* qm) {
+    return (size_t)qm->k * qm->d_pad + 2 * (size_t)qm->k * sizeof(float) + 2 * (size_t)qm->d * sizeof(float);
+}
+
+
+// Quantization
+
+QuantModel* quantize_model(const Model* m, const FeatureTransform* t, const ColumnStats* calib,
+                           QuantScale scale, double clip_std) {
+    if (m->type != MODEL_LOGISTIC && m->type != MODEL_SOFTMAX && m->type != MODEL_OVR) {
+        fprintf(stderr, "quantize_model: only logistic, softmax and one-vs-rest models are quantized\n");
+        return NULL;
+    }
+    if (calib->d != m->d || (t && t->d != m->d) || calib->count == 0) {
+        fprintf(stderr, "quantize_model: calibration statistics do not match the model (d = %d)\n", m->d);
+        return NULL;
+    }
+
+    int k = m->k, d = m->d;
+    QuantModel* qm = create_quant_model(m->type, k, d);
+    double* w = malloc((size_t)k * d * sizeof(double));
+    double* v = malloc((size_t)k * d * sizeof(double));
+    double* step = calloc(d, sizeof(double));
+    if (!qm || !w || !v || !step) {
+        free_quant_model(qm);
+        free(w);
+        free(v);
+        free(step);
+        return NULL;
+    }
+
+    // Raw-space weights
+    if (t) transform_fold_weights(t, m->W, w, k);
+    else memcpy(w, m->W, (size_t)k * d * sizeof(double));
+
+    // Input grids; the float values stored in the model are the ones folded below
+    for (int j = 1; j < d; j++) {
+        double lo = calib->min[j], hi = calib->max[j];
+        if (clip_std > 0.0) {
+            double sd = stats_std(calib, j);
+            if (calib->mean[j] - clip_std * sd > lo) lo = calib->mean[j] - clip_std * sd;
+            if (calib->mean[j] + clip_std * sd < hi) hi = calib->mean[j] + clip_std * sd;
+        }
+        qm->lo[j] = (float)lo;
+        qm->inv_step[j] = hi > lo ? (float)(QUANT_INPUT_MAX / (hi - lo)) : 0.0f;
+        step[j] = qm->inv_step[j] > 0.0f ? 1.0 / qm->inv_step[j] : 0.0;
+    }
+
+    // v_cj = w_cj * step_j, and everything the codes do not carry goes into the bias
+    double max_all = 0.0;
+    for (int c = 0; c < k; c++) {
+        const double* wc = w + (size_t)c * d;
+        double* vc = v + (size_t)c * d;
+        double bias = wc[0], max_c = 0.0;
+        vc[0] = 0.0;
+        for (int j = 1; j < d; j++) {
+            bias += wc[j] * qm->lo[j];
+            vc[j] = wc[j] * step[j];
+            if (fabs(vc[j]) > max_c) max_c = fabs(vc[j]);
+        }
+        qm->bias[c] = (float)bias;     // before the rounding correction below
+        qm->scale[c] = (float)(max_c / 127.0);
+        if (max_c > max_all) max_all = max_c;
+    }
+    for (int c = 0; c < k; c++) {
+        if (scale == QUANT_PER_TENSOR) qm->scale[c] = (float)(max_all / 127.0);
+        if (qm->scale[c] == 0.0f) qm->scale[c] = 1.0f;     // all-zero row
+        // The rounding error of each weight is exact at the mean code of its feature
+        // (added to the bias), so it only multiplies the deviation from that mean
+        int8_t* row = qm->W + (size_t)c * qm->d_pad;
+        double bias = qm->bias[c];
+        for (int j = 1; j < d; j++) {
+            double vj = v[(size_t)c * d + j];
+            double q = round(vj / qm->scale[c]);
+            row[j] = (int8_t)(q < -127 ? -127 : q > 127 ? 127 : q);
+            double center = (calib->mean[j] - qm->lo[j]) * qm->inv_step[j];
+            center = center < 0.0 ? 0.0 : center > QUANT_INPUT_MAX ? QUANT_INPUT_MAX : center;
+            bias += (vj - (double)qm->scale[c] * row[j]) * center;
+        }
+        qm->bias[c] = (float)bias;
+    }
+
+    free(w);
+    free(v);
+    free(step);
+    return qm;
+}
+
+
+// Kernels
+
+#define ENCODE_LANES 8      // fixed-length inner loops, so the compiler vectorizes them
+
+static inline int32_t encode_value(double x, float lo, float inv_step) {
+    const double top = QUANT_INPUT_MAX;
+    double c = (x - lo) * inv_step;
+    c = 0.5 * (fabs(c) - fabs(c - top) + top);     // clamp to [0, top] without branches
+    return (int32_t)(c + 0.5);
+}
+
+// Column 0 has lo = inv_step = 0, so the bias feature encodes to 0 with the rest
+void quant_encode_rows(const QuantModel* qm, const double* X, int n, uint8_t* codes_out) {
+    PROF_BEGIN("quant_encode_rows");
+    int d = qm->d, d_pad = qm->d_pad;
+    const float* restrict lo = qm->lo;
+    const float* restrict inv_step = qm->inv_step;
+    for (int i = 0; i < n; i++) {
+        const double* restrict x = X + (size_t)i * d;
+        uint8_t* restrict q = codes_out + (size_t)i * d_pad;
+        int j = 0;
+        for (; j + ENCODE_LANES <= d; j += ENCODE_LANES) {
+            int32_t c[ENCODE_LANES];    // narrowed in a second loop: double -> u8 in one step does not vectorize
+            for (int l = 0; l < ENCODE_LANES; l++) c[l] = encode_value(x[j + l], lo[j + l], inv_step[j + l]);
+            for (int l = 0; l < ENCODE_LANES; l++) q[j + l] = (uint8_t)c[l];
+        }
+        for (; j < d; j++) q[j] = (uint8_t)encode_value(x[j], lo[j], inv_step[j]);
+        memset(q + d, 0, d_pad - d);
+    }
+    PROF_END();
+}
+
+#if (defined(__AVX512VNNI__) && defined(__AVX512VL__)) || defined(__AVX2__)
+static inline int32_t hsum_epi32(__m256i v) {
+    __m128i s = _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+    s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+    return _mm_cvtsi128_si32(s);
+}
+#endif
+
+// sum_j q_j * w_j over a padded row; q is unsigned 7-bit, w signed 8-bit and 32-byte aligned
+static inline int32_t dot_codes(const uint8_t* q, const int8_t* w, int d_pad) {
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    __m256i acc = _mm256_setzero_si256();
+    for (int b = 0; b < d_pad; b += QUANT_BLOCK)
+        acc = _mm256_dpbusd_epi32(acc, _mm256_loadu_si256((const __m256i*)(q + b)),
+                                  _mm256_load_si256((const __m256i*)(w + b)));
+    return hsum_epi32(acc);
+#elif defined(__AVX2__)
+    // u8 x s8 -> pairs of int16 (no saturation with 7-bit codes) -> int32
+    const __m256i ones = _mm256_set1_epi16(1);
+    __m256i acc = _mm256_setzero_si256();
+    for (int b = 0; b < d_pad; b += QUANT_BLOCK) {
+        __m256i pairs = _mm256_maddubs_epi16(_mm256_loadu_si256((const __m256i*)(q + b)),
+                                             _mm256_load_si256((const __m256i*)(w + b)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(pairs, ones));
+    }
+    return hsum_epi32(acc);
+#else
+    int32_t acc = 0;
+    for (int b = 0; b < d_pad; b += QUANT_BLOCK)
+        for (int l = 0; l < QUANT_BLOCK; l++) acc += (int32_t)q[b + l] * w[b + l];
+    return acc;
+#endif
+}
+
+const char* quant_kernel_name(void) {
+#if defined(__AVX512VNNI__) && defined(__AVX512VL__)
+    return "avx512-vnni";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+static double quant_margin(const QuantModel* qm, const uint8_t* q, int c) {
+    return qm->bias[c] + (double)qm->scale[c] * dot_codes(q, qm->W + (size_t)c * qm->d_pad, qm->d_pad);
+}
+
+void quant_predict_codes(const QuantModel* qm, const uint8_t* codes, int n, double* scores_out, int* labels_out) {
+    PROF_BEGIN("quant_predict_codes");
+    int softmax = qm->type == MODEL_SOFTMAX && scores_out;     // labels alone need no exp()
+    for (int i = 0; i < n; i++) {
+        const uint8_t* q = codes + (size_t)i * qm->d_pad;
+        if (qm->type == MODEL_LOGISTIC) {
+            double p = 1.0 / (1.0 + exp(-quant_margin(qm, q, 0)));
+            if (scores_out) scores_out[i] = p;
+            if (labels_out) labels_out[i] = p >= 0.5;
+            continue;
+        }
+
+        // Running max and rescaled exp sum, as predict_batch()
+        double z_max = -INFINITY, sum = 0.0;
+        int best = 0;
+        for (int c = 0; c < qm->k; c++) {
+            double z = quant_margin(qm, q, c);
+            if (z > z_max) {
+                if (softmax) sum = sum * exp(z_max - z) + 1.0;
+                z_max = z;
+                best = c;
+            } else if (softmax) {
+                sum += exp(z - z_max);
+            }
+        }
+        if (scores_out) scores_out[i] = softmax ? 1.0 / sum : 1.0 / (1.0 + exp(-z_max));
+        if (labels_out) labels_out[i] = best;
+    }
+    PROF_END();
+}
+
+void quant_predict_batch(const QuantModel* qm, const double* X, int n, double* scores_out, int* labels_out) {
+    uint8_t* codes = aligned_malloc((size_t)ENCODE_ROWS * qm->d_pad);
+    if (!codes) {
+        perror("quant_predict_batch");
+        return;
+    }
+    for (int i = 0; i < n; i += ENCODE_ROWS) {
+        int rows = n - i < ENCODE_ROWS ? n - i : ENCODE_ROWS;
+        quant_encode_rows(qm, X + (size_t)i * qm->d, rows, codes);
+        quant_predict_codes(qm, codes, rows, scores_out ? scores_out + i : NULL, labels_out ? labels_out + i : NULL);
+    }
+    aligned_free(codes);
+}
+
+
+// Files
+
+int save_quant_model(const char* filename, const QuantModel* qm) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        perror("Model file error");
+        return -1;
+    }
+
+    unsigned int header[2] = { QUANT_MODEL_MAGIC, QUANT_MODEL_VERSION };
+    int shape[3] = { (int)qm->type, qm->k, qm->d };
+    size_t weights = (size_t)qm->k * qm->d_pad;
+    int ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+             fwrite(shape, sizeof(shape), 1, f) == 1 &&
+             fwrite(qm->W, 1, weights, f) == weights &&
+             fwrite(qm->scale, sizeof(float), qm->k, f) == (size_t)qm->k &&
+             fwrite(qm->bias, sizeof(float), qm->k, f) == (size_t)qm->k &&
+             fwrite(qm->lo, sizeof(float), qm->d, f) == (size_t)qm->d &&
+             fwrite(qm->inv_step, sizeof(float), qm->d, f) == (size_t)qm->d;
+
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+QuantModel* load_quant_model(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        perror("Model file error");
+        return NULL;
+    }
+
+    unsigned int header[2];
+    int shape[3];
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != QUANT_MODEL_MAGIC ||
+        header[1] != QUANT_MODEL_VERSION || fread(shape, sizeof(shape), 1, f) != 1 ||
+        shape[1] <= 0 || shape[2] <= 0 ||
+        (shape[0] != MODEL_LOGISTIC && shape[0] != MODEL_SOFTMAX && shape[0] != MODEL_OVR)) {
+        fprintf(stderr, "%s: not a quantized model file\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    QuantModel* qm = create_quant_model((ModelType)shape[0], shape[1], shape[2]);
+    size_t weights = qm ? (size_t)qm->k * qm->d_pad : 0;
+    int ok = qm &&
+             fread(qm->W, 1, weights, f) == weights &&
+             fread(qm->scale, sizeof(float), qm->k, f) == (size_t)qm->k &&
+             fread(qm->bias, sizeof(float), qm->k, f) == (size_t)qm->k &&
+             fread(qm->lo, sizeof(float), qm->d, f) == (size_t)qm->d &&
+             fread(qm->inv_step, sizeof(float), qm->d, f) == (size_t)qm->d;
+    fclose(f);
+
+    // The kernels rely on zero padding and column 0: codes there are always 0, but a file
+    // with -128 weights would break the no-saturation bound
+    for (int c = 0; ok && c < qm->k; c++)
+        for (int j = 0; ok && j < qm->d_pad; j++) ok = qm->W[(size_t)c * qm->d_pad + j] != -128;
+    if (!ok) {
+        if (qm) fprintf(stderr, "%s: truncated or corrupt quantized model file\n", filename);
+        free_quant_model(qm);
+        return NULL;
+    }
+    return qm;
+}
+
+
+// Accuracy report
+
+QuantReport quant_report(const QuantModel* qm, const Model* m, const FeatureTransform* t, const Dataset* data) {
+    QuantReport r = { 0 };
+    int d = m->d;
+    if (data->d != d || qm->d != d) {
+        fprintf(stderr, "quant_report: dataset has %d features, the models %d and %d\n", data->d, d, qm->d);
+        return r;
+    }
+    double* X = malloc((size_t)ENCODE_ROWS * d * sizeof(double));
+    double* Xt = malloc((size_t)ENCODE_ROWS * d * sizeof(double));
+    double* s_float = malloc(ENCODE_ROWS * sizeof(double));
+    double* s_quant = malloc(ENCODE_ROWS * sizeof(double));
+    int* l_float = malloc(ENCODE_ROWS * sizeof(int));
+    int* l_quant = malloc(ENCODE_ROWS * sizeof(int));
+    int ok = X && Xt && s_float && s_quant && l_float && l_quant;
+    if (!ok) perror("quant_report");
+
+    int agree = 0, correct_float = 0, correct_quant = 0;
+    double err_sum = 0.0;
+    for (int i0 = 0; ok && i0 < data->n; i0 += ENCODE_ROWS) {
+        int rows = data->n - i0 < ENCODE_ROWS ? data->n - i0 : ENCODE_ROWS;
+        for (int r0 = 0; r0 < rows; r0++) {
+            memcpy(X + (size_t)r0 * d, data->X[i0 + r0], d * sizeof(double));
+            memcpy(Xt + (size_t)r0 * d, data->X[i0 + r0], d * sizeof(double));
+            if (t) transform_apply_row(t, Xt + (size_t)r0 * d);
+        }
+        predict_batch(m, Xt, rows, s_float, l_float);
+        quant_predict_batch(qm, X, rows, s_quant, l_quant);
+        for (int r0 = 0; r0 < rows; r0++) {
+            int y = (int)data->y[i0 + r0];
+            double err = fabs(s_quant[r0] - s_float[r0]);
+            agree += l_quant[r0] == l_float[r0];
+            correct_float += l_float[r0] == y;
+            correct_quant += l_quant[r0] == y;
+            err_sum += err;
+            if (err > r.max_score_error) r.max_score_error = err;
+        }
+    }
+    r.n = ok ? data->n : 0;
+    if (r.n > 0) {
+        r.agreement = (double)agree / r.n;
+        r.accuracy_float = (double)correct_float / r.n;
+        r.accuracy_quant = (double)correct_quant / r.n;
+        r.mean_score_error = err_sum / r.n;
+    }
+
+    free(X);
+    free(Xt);
+    free(s_float);
+    free(s_quant);
+    free(l_float);
+    free(l_quant);
+    return r;
+}
+
+void quant_report_print(const QuantReport* r, FILE* out) {
+    fprintf(out, "rows %d | same label %.2f%% | accuracy float %.4f int8 %.4f | score error mean %.1e max %.1e\n",
+            r->n, 100.0 * r->agreement, r->accuracy_float, r->accuracy_quant, r->mean_score_error, r->max_score_error);
+}
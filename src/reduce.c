@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/reduce.h"
+#include "../include/aligned.h"
+#include "../include/pool.h"
+#include "../include/prof.h"
+
+#define BLOCKS_PER_CHUNK (REDUCE_CHUNK_ROWS / REDUCE_BLOCK_ROWS)
+
+struct Reducer {
+    ReduceMode mode;
+    int threads;
+    ThreadPool* pool;   // NULL with one thread: everything runs inline
+
+    // Grown on demand and kept between calls, so steady-state training does not allocate
+    double* partials;   // one len vector per task
+    size_t partials_cap;
+    double* work;       // per task: block sums and the caller's scratch
+    size_t work_cap;
+};
+
+typedef struct {
+    RowSumFn fn;
+    void* ctx;
+    int n;
+    int len;
+    int first, last;    // chunks (deterministic) or the slice index (fast)
+    int levels;         // deterministic: depth of the task's subtree plus one
+    double* partial;    // the task's sum, len doubles
+    double* work;       // deterministic: (BLOCKS_PER_CHUNK + levels) * len, then scratch_len
+} ReduceTask;
+
+Reducer* reducer_create(ReduceMode mode, int num_threads) {
+    if (mode == REDUCE_OFF) return NULL;
+    Reducer* r = calloc(1, sizeof(Reducer));
+    if (!r) return NULL;
+    r->mode = mode;
+    r->threads = num_threads > 0 ? num_threads : pool_num_cpus();
+    if (r->threads > 1) {
+        r->pool = pool_create(r->threads);
+        if (!r->pool) {
+            free(r);
+            return NULL;
+        }
+    }
+    return r;
+}
+
+void reducer_free(Reducer* r) {
+    if (!r) return;
+    if (r->pool) pool_destroy(r->pool);
+    aligned_free(r->partials);
+    aligned_free(r->work);
+    free(r);
+}
+
+ReduceMode reducer_mode(const Reducer* r) {
+    return r ? r->mode : REDUCE_OFF;
+}
+
+int reducer_threads(const Reducer* r) {
+    return r ? r->threads : 1;
+}
+
+static double* reserve(double** buf, size_t* cap, size_t count) {
+    if (count == 0) count = 1;
+    if (count <= *cap) return *buf;
+    double* p = aligned_malloc(count * sizeof(double));
+    if (!p) return NULL;
+    aligned_free(*buf);
+    *buf = p;
+    *cap = count;
+    return p;
+}
+
+// v[0] = sum of the count vectors in v, always combined in the same pairwise shape
+static void tree_sum(double* v, int count, int len) {
+    for (int step = 1; step < count; step *= 2) {
+        for (int i = 0; i + step < count; i += 2 * step) {
+            double* a = v + (size_t)i * len;
+            const double* b = v + (size_t)(i + step) * len;
+            for (int k = 0; k < len; k++) a[k] += b[k];
+        }
+    }
+}
+
+// Sums chunks [first, last), an aligned power-of-two run (the tail may be shorter), into
+// the node of the chunk tree that covers them, so tree_sum() over the task sums gives the
+// same bits as over every chunk. Completed subtrees are merged as they appear, keeping one
+// pending vector per level instead of one per chunk.
+static void chunk_task(void* arg) {
+    ReduceTask* t = arg;
+    double* blocks = t->work;
+    double* pending = blocks + (size_t)BLOCKS_PER_CHUNK * t->len;
+    double* scratch = pending + (size_t)t->levels * t->len;
+    int level[32];
+    int top = 0;
+    for (int c = t->first; c < t->last; c++) {
+        int begin = c * REDUCE_CHUNK_ROWS;
+        int end = begin + REDUCE_CHUNK_ROWS < t->n ? begin + REDUCE_CHUNK_ROWS : t->n;
+        int nb = 0;
+        for (int b = begin; b < end; b += REDUCE_BLOCK_ROWS, nb++) {
+            double* acc = blocks + (size_t)nb * t->len;
+            memset(acc, 0, t->len * sizeof(double));
+            t->fn(t->ctx, b, b + REDUCE_BLOCK_ROWS < end ? b + REDUCE_BLOCK_ROWS : end, acc, scratch);
+        }
+        tree_sum(blocks, nb, t->len);
+        memcpy(pending + (size_t)top * t->len, blocks, t->len * sizeof(double));
+        level[top++] = 0;
+        while (top >= 2 && level[top - 2] == level[top - 1]) {
+            double* a = pending + (size_t)(top - 2) * t->len;
+            const double* b = a + t->len;
+            for (int k = 0; k < t->len; k++) a[k] += b[k];
+            level[top - 2]++;
+            top--;
+        }
+    }
+    // A short tail leaves subtrees of decreasing size; the tree pairs them from the right
+    for (; top >= 2; top--) {
+        double* a = pending + (size_t)(top - 2) * t->len;
+        const double* b = a + t->len;
+        for (int k = 0; k < t->len; k++) a[k] += b[k];
+    }
+    memcpy(t->partial, pending, t->len * sizeof(double));
+}
+
+static void slice_task(void* arg) {
+    ReduceTask* t = arg;
+    double* acc = t->partial;
+    memset(acc, 0, t->len * sizeof(double));
+    t->fn(t->ctx, t->first * (long)t->n / t->last, (t->first + 1) * (long)t->n / t->last, acc, t->work);
+}
+
+const double* reducer_sum(Reducer* r, int n, int len, int scratch_len, RowSumFn fn, void* ctx, double* out) {
+    PROF_BEGIN("reducer_sum");
+    int deterministic = r->mode == REDUCE_DETERMINISTIC;
+    int num_chunks = (n + REDUCE_CHUNK_ROWS - 1) / REDUCE_CHUNK_ROWS;
+    // Deterministic tasks take aligned runs of span chunks, a power of two, so that each is
+    // one node of the chunk tree; several tasks per thread so that stealing evens out rows
+    int span = 1, levels = 1;
+    while (deterministic && (num_chunks + span - 1) / span > 4 * r->threads) {
+        span *= 2;
+        levels++;
+    }
+    int tasks = deterministic ? (num_chunks + span - 1) / span : r->threads;
+    size_t per_task = (deterministic ? (size_t)(BLOCKS_PER_CHUNK + levels) * len : 0) + scratch_len;
+
+    ReduceTask stack_tasks[64];
+    ReduceTask* task = tasks <= 64 ? stack_tasks : malloc(tasks * sizeof(ReduceTask));
+    if (n <= 0 || !task || !reserve(&r->partials, &r->partials_cap, (size_t)tasks * len) ||
+        !reserve(&r->work, &r->work_cap, (size_t)tasks * per_task)) {
+        if (n > 0) fprintf(stderr, "reducer_sum: cannot allocate %d x %d partial sums\n", tasks, len);
+        if (task != stack_tasks) free(task);
+        if (out) memset(out, 0, len * sizeof(double));
+        PROF_END();
+        return NULL;
+    }
+
+    for (int t = 0; t < tasks; t++) {
+        task[t].fn = fn;
+        task[t].ctx = ctx;
+        task[t].n = n;
+        task[t].len = len;
+        task[t].levels = levels;
+        task[t].partial = r->partials + (size_t)t * len;
+        task[t].work = r->work + (size_t)t * per_task;
+        if (deterministic) {
+            task[t].first = t * span;
+            task[t].last = (t + 1) * span < num_chunks ? (t + 1) * span : num_chunks;
+        } else {
+            task[t].first = t;
+            task[t].last = tasks;
+        }
+        if (r->pool) pool_submit(r->pool, deterministic ? chunk_task : slice_task, &task[t]);
+        else (deterministic ? chunk_task : slice_task)(&task[t]);
+    }
+    if (r->pool) pool_wait(r->pool);
+
+    if (deterministic) {
+        tree_sum(r->partials, tasks, len);
+    } else {
+        for (int t = 1; t < tasks; t++) {
+            const double* p = r->partials + (size_t)t * len;
+            for (int k = 0; k < len; k++) r->partials[k] += p[k];
+        }
+    }
+    if (out) memcpy(out, r->partials, len * sizeof(double));
+    if (task != stack_tasks) free(task);
+    PROF_END();
+    return r->partials;
+}
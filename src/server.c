@@ -0,0 +1,591 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
+#include "../include/server.h"
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#define LATENCY_WINDOW 65536
+
+// One client: stdin/stdout or an accepted socket
+typedef struct Conn {
+    int fd;                  // -1 in stdio mode
+    FILE* in;
+    FILE* out;
+    pthread_mutex_t lock;    // guards refs, writes and the pending response buffer
+    int refs;                // reader + requests still in flight
+    ServerResponse* pending; // responses produced by the current batch
+    int pending_len, pending_cap;
+    struct Conn* next;
+} Conn;
+
+typedef struct {
+    Conn* conn;
+    unsigned int id;
+    int model;
+    double t_arrive;
+    double* x;               // max_dim doubles of slot storage
+} Slot;
+
+struct InferenceServer {
+    Model** models;
+    int num_models;
+    int max_dim;
+    ServerConfig cfg;
+
+    // Bounded request queue
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty, not_full, readers_done;
+    Slot* ring;
+    double* ring_x;
+    int head, count;
+    int closing;             // no more requests will arrive; batcher drains and exits
+    int readers;
+    Conn* conns;
+
+    volatile sig_atomic_t stop;
+    int listen_fd;
+    pthread_t batcher;
+
+    // Batcher workspace
+    Slot* batch;
+    double* batch_x;
+    double* batch_scores;
+    int* batch_labels;
+    int* model_count;
+    int* model_offset;
+    size_t* model_elem;
+    Conn** touched;
+
+    // Counters
+    pthread_mutex_t stats_lock;
+    long long requests, batches;
+    double* latency_us;
+    int latency_len, latency_pos;
+    double t_start, t_last_report;
+};
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static struct timespec to_timespec(double t) {
+    struct timespec ts;
+    ts.tv_sec = (time_t)t;
+    ts.tv_nsec = (long)((t - (double)ts.tv_sec) * 1e9);
+    return ts;
+}
+
+ServerConfig server_default_config(void) {
+    ServerConfig cfg;
+    cfg.socket_path = NULL;
+    cfg.max_batch = 64;
+    cfg.max_wait_us = 200;
+    cfg.queue_capacity = 4096;
+    cfg.stats_interval_s = 0;
+    return cfg;
+}
+
+
+// Connection I/O
+
+static Conn* conn_create(int fd, FILE* in, FILE* out) {
+    Conn* c = calloc(1, sizeof(Conn));
+    c->fd = fd;
+    c->in = in;
+    c->out = out;
+    c->refs = 1;
+    pthread_mutex_init(&c->lock, NULL);
+    return c;
+}
+
+static int conn_read(Conn* c, void* buf, size_t len) {
+    if (c->in) return fread(buf, 1, len, c->in) == len;
+#ifndef _WIN32
+    char* p = buf;
+    while (len > 0) {
+        ssize_t r = read(c->fd, p, len);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return 0;
+        p += r;
+        len -= (size_t)r;
+    }
+#endif
+    return 1;
+}
+
+// Caller holds c->lock
+static void conn_write_locked(Conn* c, const ServerResponse* r, int n) {
+    size_t len = (size_t)n * sizeof(ServerResponse);
+    if (c->out) {
+        fwrite(r, 1, len, c->out);
+        fflush(c->out);
+        return;
+    }
+#ifndef _WIN32
+    const char* p = (const char*)r;
+    while (len > 0) {
+        ssize_t w = write(c->fd, p, len);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return;  // client went away; drop the responses
+        p += w;
+        len -= (size_t)w;
+    }
+#endif
+}
+
+static void conn_release(InferenceServer* s, Conn* c, int n) {
+    pthread_mutex_lock(&c->lock);
+    c->refs -= n;
+    int last = c->refs == 0;
+    pthread_mutex_unlock(&c->lock);
+    if (!last) return;
+
+    if (c->fd >= 0) {
+        pthread_mutex_lock(&s->lock);
+        for (Conn** p = &s->conns; *p; p = &(*p)->next) {
+            if (*p == c) {
+                *p = c->next;
+                break;
+            }
+        }
+        pthread_mutex_unlock(&s->lock);
+#ifndef _WIN32
+        close(c->fd);
+#endif
+    }
+    pthread_mutex_destroy(&c->lock);
+    free(c->pending);
+    free(c);
+}
+
+
+// Server lifecycle
+
+InferenceServer* server_create(Model** models, int num_models, const ServerConfig* cfg) {
+    if (num_models <= 0 || num_models > 65535) return NULL;
+
+    InferenceServer* s = calloc(1, sizeof(InferenceServer));
+    s->models = models;
+    s->num_models = num_models;
+    s->cfg = cfg ? *cfg : server_default_config();
+    if (s->cfg.max_batch < 1) s->cfg.max_batch = 1;
+    if (s->cfg.queue_capacity < s->cfg.max_batch) s->cfg.queue_capacity = s->cfg.max_batch;
+    s->listen_fd = -1;
+
+    for (int m = 0; m < num_models; m++)
+        if (models[m]->d > s->max_dim) s->max_dim = models[m]->d;
+
+    int cap = s->cfg.queue_capacity;
+    int mb = s->cfg.max_batch;
+    s->ring = malloc(cap * sizeof(Slot));
+    s->ring_x = malloc((size_t)cap * s->max_dim * sizeof(double));
+    for (int i = 0; i < cap; i++) s->ring[i].x = s->ring_x + (size_t)i * s->max_dim;
+
+    s->batch = malloc(mb * sizeof(Slot));
+    s->batch_x = malloc((size_t)mb * s->max_dim * sizeof(double));
+    s->batch_scores = malloc(mb * sizeof(double));
+    s->batch_labels = malloc(mb * sizeof(int));
+    s->model_count = malloc(num_models * sizeof(int));
+    s->model_offset = malloc(num_models * sizeof(int));
+    s->model_elem = malloc(num_models * sizeof(size_t));
+    s->touched = malloc(mb * sizeof(Conn*));
+    s->latency_us = malloc(LATENCY_WINDOW * sizeof(double));
+
+    pthread_mutex_init(&s->lock, NULL);
+    pthread_mutex_init(&s->stats_lock, NULL);
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s->not_empty, &attr);
+    pthread_cond_init(&s->not_full, &attr);
+    pthread_cond_init(&s->readers_done, &attr);
+    pthread_condattr_destroy(&attr);
+
+    return s;
+}
+
+void server_destroy(InferenceServer* s) {
+    if (!s) return;
+    pthread_mutex_destroy(&s->lock);
+    pthread_mutex_destroy(&s->stats_lock);
+    pthread_cond_destroy(&s->not_empty);
+    pthread_cond_destroy(&s->not_full);
+    pthread_cond_destroy(&s->readers_done);
+    free(s->ring);
+    free(s->ring_x);
+    free(s->batch);
+    free(s->batch_x);
+    free(s->batch_scores);
+    free(s->batch_labels);
+    free(s->model_count);
+    free(s->model_offset);
+    free(s->model_elem);
+    free(s->touched);
+    free(s->latency_us);
+    free(s);
+}
+
+void server_stop(InferenceServer* s) {
+    s->stop = 1;
+#ifndef _WIN32
+    if (s->listen_fd >= 0) shutdown(s->listen_fd, SHUT_RDWR);
+#endif
+}
+
+
+// Statistics
+
+static int cmp_double(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void server_get_stats(InferenceServer* s, ServerStats* out) {
+    pthread_mutex_lock(&s->stats_lock);
+    int len = s->latency_len;
+    double* sorted = malloc((len > 0 ? len : 1) * sizeof(double));
+    memcpy(sorted, s->latency_us, len * sizeof(double));
+    out->requests = s->requests;
+    out->batches = s->batches;
+    out->elapsed_s = s->t_start > 0 ? now_s() - s->t_start : 0.0;
+    pthread_mutex_unlock(&s->stats_lock);
+
+    qsort(sorted, len, sizeof(double), cmp_double);
+    out->p50_us = len ? sorted[(int)(0.50 * (len - 1))] : 0.0;
+    out->p99_us = len ? sorted[(int)(0.99 * (len - 1))] : 0.0;
+    out->throughput = out->elapsed_s > 0 ? out->requests / out->elapsed_s : 0.0;
+    out->mean_batch = out->batches ? (double)out->requests / out->batches : 0.0;
+    free(sorted);
+}
+
+void server_print_stats(InferenceServer* s, FILE* out) {
+    ServerStats st;
+    server_get_stats(s, &st);
+    fprintf(out, "requests %lld | batches %lld | mean batch %.1f | %.0f req/s | p50 %.1f us | p99 %.1f us\n",
+            st.requests, st.batches, st.mean_batch, st.throughput, st.p50_us, st.p99_us);
+}
+
+static void record_batch(InferenceServer* s, int n, double t_done) {
+    pthread_mutex_lock(&s->stats_lock);
+    for (int i = 0; i < n; i++) {
+        s->latency_us[s->latency_pos] = (t_done - s->batch[i].t_arrive) * 1e6;
+        s->latency_pos = (s->latency_pos + 1) % LATENCY_WINDOW;
+        if (s->latency_len < LATENCY_WINDOW) s->latency_len++;
+    }
+    s->requests += n;
+    s->batches++;
+    pthread_mutex_unlock(&s->stats_lock);
+}
+
+static void maybe_report(InferenceServer* s) {
+    if (s->cfg.stats_interval_s <= 0) return;
+    double t = now_s();
+    if (t - s->t_last_report >= s->cfg.stats_interval_s) {
+        s->t_last_report = t;
+        server_print_stats(s, stderr);
+    }
+}
+
+
+// Micro-batching
+
+static void enqueue(InferenceServer* s, Conn* c, unsigned int id, int model, const double* x, int d) {
+    pthread_mutex_lock(&c->lock);
+    c->refs++;
+    pthread_mutex_unlock(&c->lock);
+
+    pthread_mutex_lock(&s->lock);
+    while (s->count == s->cfg.queue_capacity)
+        pthread_cond_wait(&s->not_full, &s->lock);
+
+    Slot* slot = &s->ring[(s->head + s->count) % s->cfg.queue_capacity];
+    slot->conn = c;
+    slot->id = id;
+    slot->model = model;
+    slot->t_arrive = now_s();
+    memcpy(slot->x, x, d * sizeof(double));
+    s->count++;
+
+    if (s->count == 1 || s->count >= s->cfg.max_batch)
+        pthread_cond_signal(&s->not_empty);
+    pthread_mutex_unlock(&s->lock);
+}
+
+// Moves up to max_batch queued requests into the batch workspace, grouped by model.
+// Caller holds s->lock.
+static int take_batch(InferenceServer* s) {
+    int take = s->count < s->cfg.max_batch ? s->count : s->cfg.max_batch;
+    int cap = s->cfg.queue_capacity;
+
+    memset(s->model_count, 0, s->num_models * sizeof(int));
+    for (int i = 0; i < take; i++) s->model_count[s->ring[(s->head + i) % cap].model]++;
+
+    // Each model's rows form one contiguous group, packed with that model's stride,
+    // so predict_batch can consume the group directly
+    int row = 0;
+    size_t elem = 0;
+    for (int m = 0; m < s->num_models; m++) {
+        s->model_offset[m] = row;
+        s->model_elem[m] = elem;
+        row += s->model_count[m];
+        elem += (size_t)s->model_count[m] * s->models[m]->d;
+    }
+
+    for (int i = 0; i < take; i++) {
+        Slot* src = &s->ring[(s->head + i) % cap];
+        int m = src->model;
+        int d = s->models[m]->d;
+        Slot* dst = &s->batch[s->model_offset[m]++];
+        *dst = *src;
+        dst->x = s->batch_x + s->model_elem[m];
+        s->model_elem[m] += d;
+        memcpy(dst->x, src->x, d * sizeof(double));
+    }
+    for (int m = 0; m < s->num_models; m++) s->model_offset[m] -= s->model_count[m];
+
+    s->head = (s->head + take) % cap;
+    s->count -= take;
+    pthread_cond_broadcast(&s->not_full);
+    return take;
+}
+
+static void score_batch(InferenceServer* s, int n) {
+    for (int m = 0; m < s->num_models; m++) {
+        int cnt = s->model_count[m];
+        if (cnt == 0) continue;
+        int off = s->model_offset[m];
+        predict_batch(s->models[m], s->batch[off].x, cnt, s->batch_scores + off, s->batch_labels + off);
+    }
+
+    // Collect responses per connection so each client gets one write per batch
+    int touched = 0;
+    for (int i = 0; i < n; i++) {
+        Conn* c = s->batch[i].conn;
+        ServerResponse r;
+        r.request_id = s->batch[i].id;
+        r.status = SERVER_OK;
+        r.label = (short)s->batch_labels[i];
+        r.score = s->batch_scores[i];
+
+        pthread_mutex_lock(&c->lock);
+        if (c->pending_len == 0) s->touched[touched++] = c;
+        if (c->pending_len == c->pending_cap) {
+            c->pending_cap = c->pending_cap ? 2 * c->pending_cap : 16;
+            c->pending = realloc(c->pending, c->pending_cap * sizeof(ServerResponse));
+        }
+        c->pending[c->pending_len++] = r;
+        pthread_mutex_unlock(&c->lock);
+    }
+
+    for (int t = 0; t < touched; t++) {
+        Conn* c = s->touched[t];
+        pthread_mutex_lock(&c->lock);
+        int done = c->pending_len;
+        conn_write_locked(c, c->pending, done);
+        c->pending_len = 0;
+        pthread_mutex_unlock(&c->lock);
+        conn_release(s, c, done);
+    }
+
+    record_batch(s, n, now_s());
+}
+
+static void* batcher_main(void* arg) {
+    InferenceServer* s = arg;
+    double max_wait = s->cfg.max_wait_us * 1e-6;
+
+    pthread_mutex_lock(&s->lock);
+    for (;;) {
+        while (s->count == 0 && !s->closing) {
+            if (s->cfg.stats_interval_s > 0) {
+                struct timespec ts = to_timespec(now_s() + s->cfg.stats_interval_s);
+                pthread_cond_timedwait(&s->not_empty, &s->lock, &ts);
+                pthread_mutex_unlock(&s->lock);
+                maybe_report(s);
+                pthread_mutex_lock(&s->lock);
+            } else {
+                pthread_cond_wait(&s->not_empty, &s->lock);
+            }
+        }
+        if (s->count == 0) break;
+
+        // Hold the batch open until it is full or its oldest request hits max_wait_us
+        struct timespec deadline = to_timespec(s->ring[s->head].t_arrive + max_wait);
+        while (s->count < s->cfg.max_batch && !s->closing) {
+            if (pthread_cond_timedwait(&s->not_empty, &s->lock, &deadline) == ETIMEDOUT) break;
+        }
+
+        int n = take_batch(s);
+        pthread_mutex_unlock(&s->lock);
+
+        score_batch(s, n);
+        maybe_report(s);
+
+        pthread_mutex_lock(&s->lock);
+    }
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+
+// Request readers
+
+static void reject(Conn* c, unsigned int id, short status) {
+    ServerResponse r = { id, status, -1, 0.0 };
+    pthread_mutex_lock(&c->lock);
+    conn_write_locked(c, &r, 1);
+    pthread_mutex_unlock(&c->lock);
+}
+
+static void serve_conn(InferenceServer* s, Conn* c) {
+    double* x = malloc(s->max_dim * sizeof(double));
+    ServerRequestHeader h;
+
+    while (!s->stop && conn_read(c, &h, sizeof(h))) {
+        int ok_model = h.model_id < s->num_models;
+        int d = ok_model ? s->models[h.model_id]->d : 0;
+
+        if (!ok_model || h.n_features != d) {
+            // Drain the payload so the stream stays framed
+            double skip;
+            int fine = 1;
+            for (int j = 0; j < h.n_features && fine; j++) fine = conn_read(c, &skip, sizeof(double));
+            if (!fine) break;
+            reject(c, h.request_id, ok_model ? SERVER_ERR_DIM : SERVER_ERR_MODEL);
+            continue;
+        }
+
+        if (!conn_read(c, x, d * sizeof(double))) break;
+        enqueue(s, c, h.request_id, h.model_id, x, d);
+    }
+
+    free(x);
+}
+
+#ifndef _WIN32
+typedef struct {
+    InferenceServer* s;
+    Conn* c;
+} ReaderArg;
+
+static void* reader_main(void* arg) {
+    ReaderArg* ra = arg;
+    InferenceServer* s = ra->s;
+    serve_conn(s, ra->c);
+    conn_release(s, ra->c, 1);
+    free(ra);
+
+    pthread_mutex_lock(&s->lock);
+    if (--s->readers == 0) pthread_cond_broadcast(&s->readers_done);
+    pthread_mutex_unlock(&s->lock);
+    return NULL;
+}
+
+static int run_socket(InferenceServer* s) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(s->cfg.socket_path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "Socket path too long: %s\n", s->cfg.socket_path);
+        return -1;
+    }
+    strcpy(addr.sun_path, s->cfg.socket_path);
+    unlink(s->cfg.socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        perror("Socket error");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    s->listen_fd = fd;
+
+    while (!s->stop) {
+        int cfd = accept(fd, NULL, NULL);
+        if (cfd < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        Conn* c = conn_create(cfd, NULL, NULL);
+        ReaderArg* ra = malloc(sizeof(ReaderArg));
+        ra->s = s;
+        ra->c = c;
+
+        pthread_mutex_lock(&s->lock);
+        c->next = s->conns;
+        s->conns = c;
+        s->readers++;
+        pthread_mutex_unlock(&s->lock);
+
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, reader_main, ra) != 0) {
+            free(ra);
+            conn_release(s, c, 1);
+            pthread_mutex_lock(&s->lock);
+            s->readers--;
+            pthread_mutex_unlock(&s->lock);
+            continue;
+        }
+        pthread_detach(tid);
+    }
+
+    // Unblock readers, then let them finish queueing what they already parsed
+    pthread_mutex_lock(&s->lock);
+    for (Conn* c = s->conns; c; c = c->next) shutdown(c->fd, SHUT_RD);
+    while (s->readers > 0) pthread_cond_wait(&s->readers_done, &s->lock);
+    pthread_mutex_unlock(&s->lock);
+
+    close(fd);
+    s->listen_fd = -1;
+    unlink(s->cfg.socket_path);
+    return 0;
+}
+#endif
+
+int server_run(InferenceServer* s) {
+    s->t_start = s->t_last_report = now_s();
+    if (pthread_create(&s->batcher, NULL, batcher_main, s) != 0) {
+        perror("Thread error");
+        return -1;
+    }
+
+    int rc = 0;
+    if (s->cfg.socket_path) {
+#ifdef _WIN32
+        fprintf(stderr, "Unix domain sockets are not supported on this platform\n");
+        rc = -1;
+#else
+        rc = run_socket(s);
+#endif
+    } else {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        Conn* c = conn_create(-1, stdin, stdout);
+        serve_conn(s, c);
+        conn_release(s, c, 1);
+    }
+
+    pthread_mutex_lock(&s->lock);
+    s->closing = 1;
+    pthread_cond_broadcast(&s->not_empty);
+    pthread_mutex_unlock(&s->lock);
+    pthread_join(s->batcher, NULL);
+    return rc;
+}
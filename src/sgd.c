@@ -0,0 +1,290 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "../include/sgd.h"
+#include "../include/rng.h"
+#include "../include/pool.h"
+
+HogwildConfig hogwild_default_config(LossType loss) {
+    HogwildConfig cfg;
+    cfg.loss = loss;
+    cfg.num_threads = 0;
+    cfg.epochs = 10;
+    cfg.lr = 0.1;
+    cfg.decay = 0.0;
+    cfg.update = HOGWILD_RACY;
+    cfg.seed = 42;
+    return cfg;
+}
+
+
+// Hogwild!
+
+typedef struct {
+    const SparseDataset* data;
+    double* w;
+    const HogwildConfig* cfg;
+    int begin, end;     // shard rows
+    Rng rng;
+} HogwildWorker;
+
+// Relaxed atomics keep the races well-defined without adding fences
+static inline double load_relaxed(double* p) {
+    double v;
+    __atomic_load(p, &v, __ATOMIC_RELAXED);
+    return v;
+}
+
+static inline void store_relaxed(double* p, double v) {
+    __atomic_store(p, &v, __ATOMIC_RELAXED);
+}
+
+static inline void atomic_add(double* p, double delta) {
+    double old = load_relaxed(p), upd;
+    do {
+        upd = old + delta;
+    } while (!__atomic_compare_exchange(p, &old, &upd, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+static void* hogwild_worker(void* arg) {
+    HogwildWorker* wk = arg;
+    const SparseDataset* data = wk->data;
+    const HogwildConfig* cfg = wk->cfg;
+    double* w = wk->w;
+
+    int count = wk->end - wk->begin;
+    int* order = malloc((count > 0 ? count : 1) * sizeof(int));
+    for (int i = 0; i < count; i++) order[i] = wk->begin + i;
+
+    for (int e = 0; e < cfg->epochs; e++) {
+        double lr = cfg->lr / (1.0 + cfg->decay * e);
+        rng_shuffle(&wk->rng, order, count);
+
+        for (int s = 0; s < count; s++) {
+            int i = order[s];
+            int k0 = data->row_ptr[i], k1 = data->row_ptr[i + 1];
+
+            double z = 0.0;
+            for (int k = k0; k < k1; k++) z += load_relaxed(&w[data->idx[k]]) * data->val[k];
+            double step = lr * sample_dloss(cfg->loss, z, data->y[i]);
+
+            if (cfg->update == HOGWILD_ATOMIC) {
+                for (int k = k0; k < k1; k++) atomic_add(&w[data->idx[k]], -step * data->val[k]);
+            } else {
+                for (int k = k0; k < k1; k++) {
+                    double* wj = &w[data->idx[k]];
+                    store_relaxed(wj, load_relaxed(wj) - step * data->val[k]);
+                }
+            }
+        }
+    }
+
+    free(order);
+    return NULL;
+}
+
+void sgd_hogwild(const SparseDataset* data, double* w, const HogwildConfig* cfg) {
+    int T = cfg->num_threads > 0 ? cfg->num_threads : pool_num_cpus();
+    if (T > data->n) T = data->n > 0 ? data->n : 1;
+
+    HogwildWorker* workers = malloc(T * sizeof(HogwildWorker));
+    pthread_t* threads = malloc(T * sizeof(pthread_t));
+
+    for (int t = 0; t < T; t++) {
+        workers[t].data = data;
+        workers[t].w = w;
+        workers[t].cfg = cfg;
+        workers[t].begin = (int)((long long)data->n * t / T);
+        workers[t].end = (int)((long long)data->n * (t + 1) / T);
+        rng_seed(&workers[t].rng, cfg->seed + t);
+    }
+
+    // The calling thread runs shard 0 itself
+    int started = 1;
+    for (int t = 1; t < T; t++, started++) {
+        if (pthread_create(&threads[t], NULL, hogwild_worker, &workers[t]) != 0) {
+            perror("Thread error");
+            break;
+        }
+    }
+    hogwild_worker(&workers[0]);
+    for (int t = 1; t < started; t++) pthread_join(threads[t], NULL);
+
+    // Shards whose thread failed to start still get trained
+    for (int t = started; t < T; t++) hogwild_worker(&workers[t]);
+
+    free(workers);
+    free(threads);
+}
+
+
+// Variance-reduced SGD
+
+FiniteSum finite_sum_linear(const Dataset* data, LossType loss) {
+    FiniteSum f;
+    f.n = data->n;
+    f.d = data->d;
+    f.data = data;
+    f.loss = loss;
+    f.sample_grad = NULL;
+    f.ctx = NULL;
+    f.lipschitz = 0.0;
+    return f;
+}
+
+VRConfig vr_default_config(VRMethod method) {
+    VRConfig cfg;
+    cfg.method = method;
+    cfg.lr = 0.0;
+    cfg.l2 = 0.0;
+    cfg.epochs = 50;
+    cfg.inner = 0;
+    cfg.seed = 42;
+    cfg.on_epoch = NULL;
+    cfg.ctx = NULL;
+    return cfg;
+}
+
+static double dot(const double* a, const double* b, int d) {
+    double s = 0.0;
+    for (int j = 0; j < d; j++) s += a[j] * b[j];
+    return s;
+}
+
+// Largest per-sample smoothness: sample_loss'' is at most 2 (MSE) or 1/4 (logistic)
+static double linear_lipschitz(const FiniteSum* f) {
+    double curv = f->loss == LOSS_MSE ? 2.0 : 0.25;
+    double max_sq = 0.0;
+    for (int i = 0; i < f->n; i++) {
+        double sq = dot(f->data->X[i], f->data->X[i], f->d);
+        if (sq > max_sq) max_sq = sq;
+    }
+    return curv * max_sq;
+}
+
+// w -= lr * (c * x + avg + l2 * w), the bias w[0] unpenalized
+static void vr_update(double* w, const double* x, double c, const double* avg, double lr, double l2, int d) {
+    w[0] -= lr * (c * x[0] + avg[0]);
+    for (int j = 1; j < d; j++) w[j] -= lr * (c * x[j] + avg[j] + l2 * w[j]);
+}
+
+static double svrg(const FiniteSum* f, double* w, const VRConfig* cfg, double lr) {
+    int n = f->n, d = f->d;
+    int inner = cfg->inner > 0 ? cfg->inner : 2 * n;
+    const Dataset* data = f->data;
+
+    double* snap = malloc(d * sizeof(double));
+    double* mu = malloc(d * sizeof(double));
+    double* g = malloc(2 * d * sizeof(double));
+    double* dsnap = data ? malloc(n * sizeof(double)) : NULL;  // dloss at the snapshot
+    Rng rng;
+    rng_seed(&rng, cfg->seed);
+    long long evals = 0;
+
+    for (int e = 0; e < cfg->epochs; e++) {
+        // Full gradient at the snapshot
+        memcpy(snap, w, d * sizeof(double));
+        memset(mu, 0, d * sizeof(double));
+        for (int i = 0; i < n; i++) {
+            if (data) {
+                dsnap[i] = sample_dloss(f->loss, dot(snap, data->X[i], d), data->y[i]);
+                for (int j = 0; j < d; j++) mu[j] += dsnap[i] * data->X[i][j];
+            } else {
+                f->sample_grad(i, snap, g, f->ctx);
+                for (int j = 0; j < d; j++) mu[j] += g[j];
+            }
+        }
+        for (int j = 0; j < d; j++) mu[j] /= n;
+        evals += n;
+
+        for (int t = 0; t < inner; t++) {
+            int i = rng_int(&rng, n);
+            if (data) {
+                double a = sample_dloss(f->loss, dot(w, data->X[i], d), data->y[i]);
+                vr_update(w, data->X[i], a - dsnap[i], mu, lr, cfg->l2, d);
+                evals += 1;
+            } else {
+                f->sample_grad(i, w, g, f->ctx);
+                f->sample_grad(i, snap, g + d, f->ctx);
+                for (int j = 0; j < d; j++) g[j] = g[j] - g[d + j] + mu[j];
+                vr_update(w, g, 0.0, g, lr, cfg->l2, d);
+                evals += 2;
+            }
+        }
+
+        if (cfg->on_epoch && cfg->on_epoch(e, (double)evals / n, w, cfg->ctx)) break;
+    }
+
+    free(snap);
+    free(mu);
+    free(g);
+    free(dsnap);
+    return (double)evals / n;
+}
+
+static double saga(const FiniteSum* f, double* w, const VRConfig* cfg, double lr) {
+    int n = f->n, d = f->d;
+    const Dataset* data = f->data;
+
+    // Linear models keep one scalar per sample, others a full gradient
+    double* table = malloc((size_t)n * (data ? 1 : d) * sizeof(double));
+    double* avg = calloc(d, sizeof(double));
+    double* g = malloc(d * sizeof(double));
+    Rng rng;
+    rng_seed(&rng, cfg->seed);
+
+    for (int i = 0; i < n; i++) {
+        if (data) {
+            table[i] = sample_dloss(f->loss, dot(w, data->X[i], d), data->y[i]);
+            for (int j = 0; j < d; j++) avg[j] += table[i] * data->X[i][j];
+        } else {
+            double* ti = table + (size_t)i * d;
+            f->sample_grad(i, w, ti, f->ctx);
+            for (int j = 0; j < d; j++) avg[j] += ti[j];
+        }
+    }
+    for (int j = 0; j < d; j++) avg[j] /= n;
+    long long evals = n;
+
+    for (int e = 0; e < cfg->epochs; e++) {
+        for (int t = 0; t < n; t++) {
+            int i = rng_int(&rng, n);
+            if (data) {
+                const double* x = data->X[i];
+                double a = sample_dloss(f->loss, dot(w, x, d), data->y[i]);
+                double c = a - table[i];
+                vr_update(w, x, c, avg, lr, cfg->l2, d);
+                for (int j = 0; j < d; j++) avg[j] += c * x[j] / n;
+                table[i] = a;
+            } else {
+                double* ti = table + (size_t)i * d;
+                f->sample_grad(i, w, g, f->ctx);
+                for (int j = 0; j < d; j++) g[j] -= ti[j];
+                vr_update(w, g, 1.0, avg, lr, cfg->l2, d);
+                for (int j = 0; j < d; j++) {
+                    avg[j] += g[j] / n;
+                    ti[j] += g[j];
+                }
+            }
+        }
+        evals += n;
+
+        if (cfg->on_epoch && cfg->on_epoch(e, (double)evals / n, w, cfg->ctx)) break;
+    }
+
+    free(table);
+    free(avg);
+    free(g);
+    return (double)evals / n;
+}
+
+double sgd_vr(const FiniteSum* f, double* w, const VRConfig* cfg) {
+    if (f->n <= 0 || (!f->data && !f->sample_grad)) return 0.0;
+
+    double L = f->lipschitz > 0 ? f->lipschitz : (f->data ? linear_lipschitz(f) : 1.0);
+    L += cfg->l2;
+    double lr = cfg->lr > 0 ? cfg->lr : 1.0 / ((cfg->method == VR_SAGA ? 3.0 : 5.0) * L);
+
+    return cfg->method == VR_SAGA ? saga(f, w, cfg, lr) : svrg(f, w, cfg, lr);
+}
@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/stats.h"
+#include "../include/prof.h"
+
+#define STATS_CHUNK 4096    // rows per task; fixed so results are independent of the pool
+
+ColumnStats* stats_create(int d) {
+    ColumnStats* s = malloc(sizeof(ColumnStats));
+    if (!s) return NULL;
+    s->d = d;
+    s->mean = malloc(d * sizeof(double));
+    s->m2 = malloc(d * sizeof(double));
+    s->min = malloc(d * sizeof(double));
+    s->max = malloc(d * sizeof(double));
+    if (!s->mean || !s->m2 || !s->min || !s->max) {
+        stats_free(s);
+        return NULL;
+    }
+    stats_reset(s);
+    return s;
+}
+
+void stats_reset(ColumnStats* s) {
+    s->count = 0;
+    for (int j = 0; j < s->d; j++) {
+        s->mean[j] = 0.0;
+        s->m2[j] = 0.0;
+        s->min[j] = INFINITY;
+        s->max[j] = -INFINITY;
+    }
+}
+
+void stats_free(ColumnStats* s) {
+    if (!s) return;
+    free(s->mean);
+    free(s->m2);
+    free(s->min);
+    free(s->max);
+    free(s);
+}
+
+void stats_add_row(ColumnStats* s, const double* x) {
+    s->count++;
+    double inv = 1.0 / s->count;
+    for (int j = 0; j < s->d; j++) {
+        double delta = x[j] - s->mean[j];
+        s->mean[j] += delta * inv;
+        s->m2[j] += delta * (x[j] - s->mean[j]);
+        if (x[j] < s->min[j]) s->min[j] = x[j];
+        if (x[j] > s->max[j]) s->max[j] = x[j];
+    }
+}
+
+void stats_merge(ColumnStats* into, const ColumnStats* other) {
+    if (other->count == 0) return;
+    if (into->count == 0) {
+        into->count = other->count;
+        memcpy(into->mean, other->mean, into->d * sizeof(double));
+        memcpy(into->m2, other->m2, into->d * sizeof(double));
+        memcpy(into->min, other->min, into->d * sizeof(double));
+        memcpy(into->max, other->max, into->d * sizeof(double));
+        return;
+    }
+
+    double na = (double)into->count, nb = (double)other->count, n = na + nb;
+    for (int j = 0; j < into->d; j++) {
+        double delta = other->mean[j] - into->mean[j];
+        into->mean[j] += delta * nb / n;
+        into->m2[j] += other->m2[j] + delta * delta * na * nb / n;
+        if (other->min[j] < into->min[j]) into->min[j] = other->min[j];
+        if (other->max[j] > into->max[j]) into->max[j] = other->max[j];
+    }
+    into->count += other->count;
+}
+
+double stats_variance(const ColumnStats* s, int j) {
+    return s->count > 0 ? s->m2[j] / s->count : 0.0;
+}
+
+double stats_std(const ColumnStats* s, int j) {
+    return sqrt(stats_variance(s, j));
+}
+
+
+// Parallel pass
+
+typedef struct {
+    const Dataset* data;
+    int begin, end;
+    ColumnStats* stats;
+} StatsChunk;
+
+static void stats_chunk(void* arg) {
+    StatsChunk* c = arg;
+    for (int i = c->begin; i < c->end; i++) stats_add_row(c->stats, c->data->X[i]);
+}
+
+ColumnStats* stats_compute(const Dataset* data, ThreadPool* pool) {
+    PROF_BEGIN("stats_compute");
+    int chunks = (data->n + STATS_CHUNK - 1) / STATS_CHUNK;
+    ColumnStats* total = stats_create(data->d);
+    StatsChunk* tasks = malloc(chunks * sizeof(StatsChunk));
+    if (!total || (chunks > 0 && !tasks)) {
+        stats_free(total);
+        free(tasks);
+        PROF_END();
+        return NULL;
+    }
+
+    for (int c = 0; c < chunks; c++) {
+        tasks[c].data = data;
+        tasks[c].begin = c * STATS_CHUNK;
+        tasks[c].end = c + 1 < chunks ? (c + 1) * STATS_CHUNK : data->n;
+        tasks[c].stats = stats_create(data->d);
+        if (!tasks[c].stats) {
+            for (int u = 0; u < c; u++) stats_free(tasks[u].stats);
+            stats_free(total);
+            free(tasks);
+            PROF_END();
+            return NULL;
+        }
+    }
+
+    // The same chunks run inline without a pool, so the merge order never changes
+    for (int c = 0; c < chunks; c++) {
+        if (pool) pool_submit(pool, stats_chunk, &tasks[c]);
+        else stats_chunk(&tasks[c]);
+    }
+    if (pool) pool_wait(pool);
+
+    for (int c = 0; c < chunks; c++) {
+        stats_merge(total, tasks[c].stats);
+        stats_free(tasks[c].stats);
+    }
+    free(tasks);
+    PROF_END();
+    return total;
+}
+
+
+// Feature transforms
+
+static FeatureTransform* create_transform(int d) {
+    FeatureTransform* t = malloc(sizeof(FeatureTransform));
+    if (!t) return NULL;
+    t->d = d;
+    t->shift = calloc(d, sizeof(double));
+    t->scale = malloc(d * sizeof(double));
+    if (!t->shift || !t->scale) {
+        transform_free(t);
+        return NULL;
+    }
+    for (int j = 0; j < d; j++) t->scale[j] = 1.0;
+    return t;
+}
+
+FeatureTransform* transform_from_stats(const ColumnStats* s, TransformType type) {
+    FeatureTransform* t = create_transform(s->d);
+    if (!t) return NULL;
+    for (int j = 1; j < s->d; j++) {
+        if (type == TRANSFORM_MINMAX) {
+            double range = s->max[j] - s->min[j];
+            t->shift[j] = s->min[j];
+            t->scale[j] = range > 0 ? 1.0 / range : 1.0;
+        } else {
+            t->shift[j] = s->mean[j];
+            t->scale[j] = 1.0 / (stats_std(s, j) + 1e-8);
+        }
+    }
+    return t;
+}
+
+void transform_free(FeatureTransform* t) {
+    if (!t) return;
+    free(t->shift);
+    free(t->scale);
+    free(t);
+}
+
+void transform_apply_row(const FeatureTransform* t, double* x) {
+    for (int j = 1; j < t->d; j++) x[j] = (x[j] - t->shift[j]) * t->scale[j];
+}
+
+void transform_apply(const FeatureTransform* t, Dataset* data) {
+    PROF_BEGIN("transform_apply");
+    for (int i = 0; i < data->n; i++) transform_apply_row(t, data->X[i]);
+    PROF_END();
+}
+
+// z = w_0 + sum_j w_j (x_j - shift_j) scale_j = (w_0 - sum_j w_j scale_j shift_j) + sum_j (w_j scale_j) x_j
+void transform_fold_weights(const FeatureTransform* t, const double* w, double* w_raw, int k) {
+    int d = t->d;
+    for (int c = 0; c < k; c++) {
+        const double* wc = w + (size_t)c * d;
+        double* out = w_raw + (size_t)c * d;
+        double bias = wc[0];
+        for (int j = 1; j < d; j++) {
+            out[j] = wc[j] * t->scale[j];
+            bias -= out[j] * t->shift[j];
+        }
+        out[0] = bias;
+    }
+}
+
+// dL/dw_j = s_j (g_j - shift_j g_0) for j >= 1, dL/dw_0 = g_0
+void transform_unfold_grad(const FeatureTransform* t, double* grad, int k) {
+    int d = t->d;
+    for (int c = 0; c < k; c++) {
+        double* g = grad + (size_t)c * d;
+        for (int j = 1; j < d; j++) g[j] = t->scale[j] * (g[j] - t->shift[j] * g[0]);
+    }
+}
+
+FeatureTransform* standardize_dataset(Dataset* data, ThreadPool* pool) {
+    ColumnStats* s = stats_compute(data, pool);
+    if (!s) return NULL;
+    FeatureTransform* t = transform_from_stats(s, TRANSFORM_STANDARDIZE);
+    stats_free(s);
+    if (t) transform_apply(t, data);
+    return t;
+}
+
+
+// Files
+
+#define TRANSFORM_MAGIC 0x4E504F43u  // "COPN"
+#define TRANSFORM_VERSION 1u
+
+int save_transform(const char* filename, const FeatureTransform* t) {
+    FILE* f = fopen(filename, "wb");
+    if (!f) {
+        perror("Transform file error");
+        return -1;
+    }
+
+    unsigned int header[2] = { TRANSFORM_MAGIC, TRANSFORM_VERSION };
+    int ok = fwrite(header, sizeof(header), 1, f) == 1 &&
+             fwrite(&t->d, sizeof(int), 1, f) == 1 &&
+             fwrite(t->shift, sizeof(double), t->d, f) == (size_t)t->d &&
+             fwrite(t->scale, sizeof(double), t->d, f) == (size_t)t->d;
+
+    if (fclose(f) != 0) ok = 0;
+    return ok ? 0 : -1;
+}
+
+FeatureTransform* load_transform(const char* filename) {
+    FILE* f = fopen(filename, "rb");
+    if (!f) {
+        perror("Transform file error");
+        return NULL;
+    }
+
+    unsigned int header[2];
+    int d;
+    if (fread(header, sizeof(header), 1, f) != 1 || header[0] != TRANSFORM_MAGIC ||
+        header[1] != TRANSFORM_VERSION || fread(&d, sizeof(int), 1, f) != 1 || d <= 0) {
+        fprintf(stderr, "%s: not a transform file\n", filename);
+        fclose(f);
+        return NULL;
+    }
+
+    FeatureTransform* t = create_transform(d);
+    if (t && (fread(t->shift, sizeof(double), d, f) != (size_t)d ||
+              fread(t->scale, sizeof(double), d, f) != (size_t)d)) {
+        fprintf(stderr, "%s: truncated transform file\n", filename);
+        transform_free(t);
+        t = NULL;
+    }
+    fclose(f);
+    return t;
+}
@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "../include/sweep.h"
+#include "../include/pool.h"
+#include "../include/optim.h"
+#include "../include/rng.h"
+
+
+// Configuration builders
+
+static int axis_count(const SweepAxis* a) {
+    return a->count > 0 ? a->count : 1;
+}
+
+static double axis_value(const SweepAxis* a, int i, double def) {
+    return a->count > 0 ? a->values[i] : def;
+}
+
+OptimizerParams* sweep_grid(OptimizerType type, const SweepGrid* grid, int* count) {
+    int n = axis_count(&grid->lr) * axis_count(&grid->momentum) * axis_count(&grid->beta1) *
+            axis_count(&grid->beta2) * axis_count(&grid->epsilon);
+    OptimizerParams* configs = malloc(n * sizeof(OptimizerParams));
+    OptimizerParams def = optimizer_default_params(type);
+
+    int k = 0;
+    for (int a = 0; a < axis_count(&grid->lr); a++)
+    for (int b = 0; b < axis_count(&grid->momentum); b++)
+    for (int c = 0; c < axis_count(&grid->beta1); c++)
+    for (int d = 0; d < axis_count(&grid->beta2); d++)
+    for (int e = 0; e < axis_count(&grid->epsilon); e++) {
+        OptimizerParams p = def;
+        p.lr = axis_value(&grid->lr, a, def.lr);
+        p.momentum = axis_value(&grid->momentum, b, def.momentum);
+        p.beta1 = axis_value(&grid->beta1, c, def.beta1);
+        p.beta2 = axis_value(&grid->beta2, d, def.beta2);
+        p.epsilon = axis_value(&grid->epsilon, e, def.epsilon);
+        configs[k++] = p;
+    }
+
+    *count = n;
+    return configs;
+}
+
+static double sample(Rng* rng, const SweepRange* r, double def, int log_scale) {
+    if (r->lo == 0.0 && r->hi == 0.0) return def;
+    double u = rng_uniform(rng);
+    if (log_scale && r->lo > 0.0 && r->hi > 0.0)
+        return exp(log(r->lo) + u * (log(r->hi) - log(r->lo)));
+    return r->lo + u * (r->hi - r->lo);
+}
+
+OptimizerParams* sweep_random(OptimizerType type, const SweepSpace* space, int count, unsigned long long seed) {
+    OptimizerParams* configs = malloc(count * sizeof(OptimizerParams));
+    OptimizerParams def = optimizer_default_params(type);
+    Rng rng;
+    rng_seed(&rng, seed);
+
+    for (int i = 0; i < count; i++) {
+        OptimizerParams p = def;
+        p.lr = sample(&rng, &space->lr, def.lr, 1);
+        p.momentum = sample(&rng, &space->momentum, def.momentum, 0);
+        p.beta1 = sample(&rng, &space->beta1, def.beta1, 0);
+        p.beta2 = sample(&rng, &space->beta2, def.beta2, 0);
+        p.epsilon = sample(&rng, &space->epsilon, def.epsilon, 1);
+        configs[i] = p;
+    }
+    return configs;
+}
+
+
+// Running a sweep
+
+typedef struct {
+    FuncPtrND f;
+    GradPtrND grad;
+    const double* x0;
+    int dim;
+    double tol;
+    int iters;            // budget of the current rung
+} SweepCtx;
+
+typedef struct {
+    const SweepCtx* ctx;
+    SweepResult* result;
+    Optimizer* opt;       // kept across rungs so survivors resume where they stopped
+    int converged;
+} SweepTask;
+
+static void run_config(void* arg) {
+    SweepTask* task = arg;
+    const SweepCtx* ctx = task->ctx;
+    SweepResult* r = task->result;
+
+    int steps = ctx->iters - r->iters;
+    if (!task->converged && steps > 0)
+        task->converged = optimizer_run(task->opt, r->x, steps, ctx->tol) < steps;
+
+    double loss = ctx->f(r->x, ctx->dim);
+    r->loss = isfinite(loss) ? loss : INFINITY;
+    r->iters = ctx->iters;
+}
+
+static int by_loss(const void* a, const void* b) {
+    double x = (*(SweepResult* const*)a)->loss;
+    double y = (*(SweepResult* const*)b)->loss;
+    return (x > y) - (x < y);
+}
+
+static int by_rank(const void* a, const void* b) {
+    const SweepResult* x = a;
+    const SweepResult* y = b;
+    if (x->rung != y->rung) return y->rung - x->rung;
+    return (x->loss > y->loss) - (x->loss < y->loss);
+}
+
+SweepConfig sweep_default_config(void) {
+    SweepConfig cfg;
+    cfg.num_threads = 0;
+    cfg.min_iters = 50;
+    cfg.max_iters = 1000;
+    cfg.eta = 3;
+    cfg.tol = 1e-6;
+    return cfg;
+}
+
+SweepResult* sweep_run(FuncPtrND f, GradPtrND grad, const double* x0, int dim,
+                       const OptimizerParams* configs, int n, const SweepConfig* cfg) {
+    SweepConfig c = cfg ? *cfg : sweep_default_config();
+    if (c.min_iters > c.max_iters || c.eta < 2) c.min_iters = c.max_iters;
+
+    ThreadPool* pool = pool_create(c.num_threads);
+    if (!pool) return NULL;
+
+    SweepResult* results = malloc(n * sizeof(SweepResult));
+    SweepResult** alive = malloc(n * sizeof(SweepResult*));
+    SweepTask* tasks = malloc(n * sizeof(SweepTask));
+    SweepCtx ctx = { f, grad, x0, dim, c.tol, c.min_iters };
+    for (int i = 0; i < n; i++) {
+        results[i].params = configs[i];
+        results[i].loss = INFINITY;
+        results[i].iters = 0;
+        results[i].rung = 0;
+        results[i].x = malloc(dim * sizeof(double));
+        memcpy(results[i].x, x0, dim * sizeof(double));
+        alive[i] = &results[i];
+
+        tasks[i].ctx = &ctx;
+        tasks[i].result = &results[i];
+        tasks[i].opt = optimizer_create(&configs[i], grad, dim);
+        tasks[i].converged = 0;
+    }
+
+    int n_alive = n;
+
+    // Successive halving: run every survivor at the current budget, keep the best 1/eta
+    for (int rung = 0; ; rung++) {
+        for (int i = 0; i < n_alive; i++) {
+            alive[i]->rung = rung;
+            pool_submit(pool, run_config, &tasks[alive[i] - results]);
+        }
+        pool_wait(pool);
+
+        if (ctx.iters >= c.max_iters || n_alive <= 1) break;
+
+        qsort(alive, n_alive, sizeof(SweepResult*), by_loss);
+        n_alive = (n_alive + c.eta - 1) / c.eta;
+        ctx.iters = ctx.iters > c.max_iters / c.eta ? c.max_iters : ctx.iters * c.eta;
+    }
+
+    pool_destroy(pool);
+    for (int i = 0; i < n; i++) optimizer_destroy(tasks[i].opt);
+    free(alive);
+    free(tasks);
+
+    qsort(results, n, sizeof(SweepResult), by_rank);
+    return results;
+}
+
+void sweep_print(const SweepResult* results, int n, int top, FILE* out) {
+    if (top <= 0 || top > n) top = n;
+    fprintf(out, "Rank | Optimizer | lr         | momentum | beta1  | beta2  | epsilon  | iters | loss\n");
+    for (int i = 0; i < top; i++) {
+        const SweepResult* r = &results[i];
+        const OptimizerParams* p = &r->params;
+        fprintf(out, "%4d | %-9s | %.4e | %.4f   | %.4f | %.4f | %.2e | %5d | %.6g\n",
+                i + 1, optimizer_name(p->type), p->lr, p->momentum, p->beta1, p->beta2, p->epsilon, r->iters, r->loss);
+    }
+}
+
+void sweep_free(SweepResult* results, int n) {
+    if (!results) return;
+    for (int i = 0; i < n; i++) free(results[i].x);
+    free(results);
+}
@@ -0,0 +1,124 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../include/train.h"
+#include "../include/checkpoint.h"
+#include "../include/prof.h"
+
+MiniBatchConfig minibatch_default_config(LossType loss, OptimizerType type) {
+    MiniBatchConfig cfg;
+    cfg.loss = loss;
+    cfg.opt = optimizer_default_params(type);
+    cfg.batch_size = 32;
+    cfg.epochs = 10;
+    cfg.seed = 42;
+    cfg.max_steps = 0;
+    cfg.checkpoint_path = NULL;
+    cfg.checkpoint_every = 100;
+    return cfg;
+}
+
+TrainState* train_state_create(const Dataset* data, const MiniBatchConfig* cfg) {
+    TrainState* st = calloc(1, sizeof(TrainState));
+    st->opt = optimizer_create(&cfg->opt, NULL, data->d);
+    st->w = calloc(data->d, sizeof(double));
+    st->perm = malloc((data->n > 0 ? data->n : 1) * sizeof(int));
+    if (!st->opt || !st->w || !st->perm) {
+        train_state_free(st);
+        return NULL;
+    }
+
+    st->dim = data->d;
+    st->n = data->n;
+    st->batch_size = cfg->batch_size > 0 ? cfg->batch_size : 1;
+    st->loss = cfg->loss;
+    rng_seed(&st->rng, cfg->seed);
+    for (int i = 0; i < st->n; i++) st->perm[i] = i;
+    rng_shuffle(&st->rng, st->perm, st->n);
+    return st;
+}
+
+void train_state_free(TrainState* st) {
+    if (!st) return;
+    optimizer_destroy(st->opt);
+    free(st->w);
+    free(st->perm);
+    free(st);
+}
+
+// Mean gradient over the rows idx[0..count) at the point w
+static void batch_grad(const Dataset* data, LossType loss, const double* w, const int* idx, int count, double* g) {
+    int d = data->d;
+    PROF_BEGIN("minibatch_grad");
+    for (int j = 0; j < d; j++) g[j] = 0.0;
+
+    for (int s = 0; s < count; s++) {
+        const double* x = data->X[idx[s]];
+        double z = 0.0;
+        for (int j = 0; j < d; j++) z += w[j] * x[j];
+        double e = sample_dloss(loss, z, data->y[idx[s]]);
+        for (int j = 0; j < d; j++) g[j] += e * x[j];
+    }
+
+    for (int j = 0; j < d; j++) g[j] /= count;
+    PROF_END();
+}
+
+long long train_minibatch(const Dataset* data, TrainState* st, const MiniBatchConfig* cfg) {
+    Checkpointer* ckpt = NULL;
+    if (cfg->checkpoint_path && cfg->checkpoint_every > 0) ckpt = checkpointer_create(cfg->checkpoint_path);
+
+    long long steps = 0;
+    while (st->epoch < cfg->epochs && (cfg->max_steps <= 0 || st->step < cfg->max_steps)) {
+        int count = st->n - st->pos < st->batch_size ? st->n - st->pos : st->batch_size;
+
+        const double* at = optimizer_eval_point(st->opt, st->w);
+        batch_grad(data, st->loss, at, st->perm + st->pos, count, st->opt->g);
+        optimizer_apply(st->opt, st->w, st->opt->g);
+
+        st->pos += count;
+        st->step++;
+        steps++;
+        if (st->pos >= st->n) {
+            st->epoch++;
+            st->pos = 0;
+            rng_shuffle(&st->rng, st->perm, st->n);
+        }
+
+        if (ckpt && st->step % cfg->checkpoint_every == 0) checkpointer_submit(ckpt, st);
+    }
+
+    if (ckpt && checkpointer_destroy(ckpt) != 0) fprintf(stderr, "Checkpoint write failed: %s\n", cfg->checkpoint_path);
+    return steps;
+}
+
+// Mean gradient over a contiguous batch
+static void contiguous_batch_grad(const Batch* b, LossType loss, const double* w, double* g) {
+    int d = b->d;
+    PROF_BEGIN("prefetched_batch_grad");
+    for (int j = 0; j < d; j++) g[j] = 0.0;
+
+    for (int r = 0; r < b->rows; r++) {
+        const double* x = b->X + (size_t)r * d;
+        double z = 0.0;
+        for (int j = 0; j < d; j++) z += w[j] * x[j];
+        double e = sample_dloss(loss, z, b->y[r]);
+        for (int j = 0; j < d; j++) g[j] += e * x[j];
+    }
+
+    for (int j = 0; j < d; j++) g[j] /= b->rows;
+    PROF_END();
+}
+
+long long train_minibatch_prefetched(Prefetcher* pf, LossType loss, Optimizer* opt, double* w) {
+    long long steps = 0;
+    const Batch* b;
+    while ((b = prefetch_next(pf)) != NULL) {
+        const double* at = optimizer_eval_point(opt, w);
+        contiguous_batch_grad(b, loss, at, opt->g);
+        prefetch_release(pf, b);
+        optimizer_apply(opt, w, opt->g);
+        steps++;
+    }
+    return steps;
+}